@@ -0,0 +1,125 @@
+#include "PIDFAutoTuner.h"
+#include <cmath>
+
+
+void PIDFAutoTuner::start(float setpoint, const config_t& config)
+{
+    _config = config;
+    // at least one cycle must be measured, otherwise the tuner would never complete
+    _config.measureCycles = config.measureCycles == 0 ? 1 : config.measureCycles;
+    _setpoint = setpoint;
+    _sampleCount = 0;
+    _cycleStartSample = 0;
+    _amplitudeSum = 0.0F;
+    _periodSampleSum = 0;
+    _oscillationAmplitude = 0.0F;
+    _ultimateGain = 0.0F;
+    _ultimatePeriod = 0.0F;
+    _cycleCount = 0;
+    _relayHigh = true;
+    _max = -INFINITY;
+    _min = INFINITY;
+    _state = RUNNING;
+}
+
+/*!
+Relay output, switching when the measurement crosses the setpoint (plus or minus the hysteresis).
+The relay switching low marks the start of each oscillation cycle.
+*/
+float PIDFAutoTuner::update(float measurement, float deltaT)
+{
+    if (_state != RUNNING) {
+        return _config.relayBias;
+    }
+    ++_sampleCount;
+    if (static_cast<float>(_sampleCount)*deltaT > _config.timeout) {
+        _state = FAILED;
+        return _config.relayBias;
+    }
+
+    _max = std::fmax(_max, measurement);
+    _min = std::fmin(_min, measurement);
+    const float error = _setpoint - measurement;
+    if (_relayHigh) {
+        if (error < -_config.hysteresis) {
+            _relayHigh = false;
+            completeCycle(deltaT);
+        }
+    } else if (error > _config.hysteresis) {
+        _relayHigh = true;
+    }
+    if (_state != RUNNING) {
+        return _config.relayBias;
+    }
+    return _relayHigh ? _config.relayBias + _config.relayAmplitude : _config.relayBias - _config.relayAmplitude;
+}
+
+void PIDFAutoTuner::completeCycle(float deltaT)
+{
+    // the first switch low is the start of the first cycle, so there is no complete cycle to measure
+    if (_cycleCount > _config.settleCycles) {
+        _amplitudeSum += 0.5F*(_max - _min);
+        _periodSampleSum += _sampleCount - _cycleStartSample;
+        if (_cycleCount - _config.settleCycles == _config.measureCycles) {
+            const auto cycles = static_cast<float>(_config.measureCycles);
+            _oscillationAmplitude = _amplitudeSum / cycles;
+            _ultimatePeriod = static_cast<float>(_periodSampleSum)*deltaT / cycles;
+            const float hysteresis = _config.hysteresis;
+            if (_oscillationAmplitude <= hysteresis) {
+                _state = FAILED;
+                return;
+            }
+            _ultimateGain = 4.0F*_config.relayAmplitude / (PI * std::sqrt(_oscillationAmplitude*_oscillationAmplitude - hysteresis*hysteresis));
+            _state = COMPLETE;
+            return;
+        }
+    }
+    ++_cycleCount;
+    _cycleStartSample = _sampleCount;
+    _max = -INFINITY;
+    _min = INFINITY;
+}
+
+/*!
+Gains from the ultimate gain Ku and ultimate period Pu.
+The rules are expressed in terms of kp, the integral time Ti and the derivative time Td, so ki = kp/Ti and kd = kp*Td.
+*/
+PIDFAutoTuner::PIDF_t PIDFAutoTuner::calculatePID(rule_e rule, float ultimateGain, float ultimatePeriod)
+{
+    float kp = 0.0F;
+    float Ti = 0.0F; // NOLINT(readability-identifier-naming)
+    float Td = 0.0F; // NOLINT(readability-identifier-naming)
+    switch (rule) {
+    case ZIEGLER_NICHOLS_PI:
+        kp = 0.45F*ultimateGain;
+        Ti = ultimatePeriod / 1.2F;
+        break;
+    case ZIEGLER_NICHOLS_PID:
+        kp = 0.6F*ultimateGain;
+        Ti = 0.5F*ultimatePeriod;
+        Td = 0.125F*ultimatePeriod;
+        break;
+    case TYREUS_LUYBEN_PI:
+        kp = ultimateGain / 3.2F;
+        Ti = 2.2F*ultimatePeriod;
+        break;
+    case TYREUS_LUYBEN_PID:
+        kp = ultimateGain / 2.2F;
+        Ti = 2.2F*ultimatePeriod;
+        Td = ultimatePeriod / 6.3F;
+        break;
+    case SIMC_PI:
+        // integrating plus dead time model k*exp(-theta*s)/s has Pu = 4*theta and Ku = pi/(2*k*theta),
+        // SIMC with tauC = theta gives kp = 1/(2*k*theta) = Ku/pi, Ti = 8*theta = 2*Pu
+        kp = ultimateGain / PI;
+        Ti = 2.0F*ultimatePeriod;
+        break;
+    }
+    return PIDF_t {
+        kp,
+        Ti == 0.0F ? 0.0F : kp / Ti,
+        kp*Td,
+        0.0F,
+        0.0F
+    };
+}
@@ -0,0 +1,92 @@
+# pragma once
+
+#include "PIDFT.h"
+#include <cstdint>
+
+/*!
+Relay feedback auto-tuner.
+
+While tuning, the plant is driven by a relay: the output is bias + amplitude when the measurement is below the setpoint,
+and bias - amplitude when it is above (with hysteresis, to avoid chattering due to noise). This makes the plant oscillate
+at close to its ultimate period, with an amplitude from which the ultimate gain is calculated using the describing function
+of the relay:
+
+    Ku = 4*amplitude / (pi * sqrt(a*a - hysteresis*hysteresis))
+
+where a is the amplitude of the oscillation of the measurement. The gains are then calculated from Ku and the ultimate period Pu
+using the selected tuning rule.
+
+The tuner runs incrementally: `update` is called in the control loop in place of `PIDF::update`, and its return value used as the
+control output, until `isRunning` returns false. There is no heap allocation.
+
+Time is measured by counting samples, rather than by summing deltaT (whose rounding would bias the period over a long run),
+so deltaT should be the same for every update while tuning.
+*/
+class PIDFAutoTuner {
+public:
+    enum state_e : uint8_t { IDLE, RUNNING, COMPLETE, FAILED };
+    enum rule_e {
+        ZIEGLER_NICHOLS_PI,
+        ZIEGLER_NICHOLS_PID,
+        TYREUS_LUYBEN_PI, //!< less aggressive than Ziegler-Nichols, with less overshoot
+        TYREUS_LUYBEN_PID,
+        SIMC_PI, //!< Skogestad's SIMC rule, using an integrating plus dead time approximation of the plant, with tauC equal to the dead time
+    };
+    using PIDF_t = PIDFBase::PIDF_t;
+    struct config_t {
+        float relayAmplitude; //!< output is bias +/- relayAmplitude
+        float relayBias; //!< output bias, eg the output needed to hold the plant near the setpoint
+        float hysteresis; //!< the relay switches when the measurement is more than hysteresis from the setpoint
+        float timeout; //!< tuning fails if not complete within this time, in seconds
+        uint32_t settleCycles; //!< number of oscillation cycles ignored while the oscillation settles
+        uint32_t measureCycles; //!< number of oscillation cycles over which the amplitude and period are averaged, zero is treated as one
+    };
+    static constexpr float PI = 3.14159265358979F;
+public:
+    PIDFAutoTuner() = default;
+public:
+    //! Start tuning, with the plant oscillating around setpoint.
+    void start(float setpoint, const config_t& config);
+    inline void stop() { _state = IDLE; }
+
+    inline state_e getState() const { return _state; }
+    inline bool isRunning() const { return _state == RUNNING; }
+    inline bool isComplete() const { return _state == COMPLETE; }
+
+    /*!
+    Update the tuner, returning the relay output to be applied to the plant.
+    When tuning has completed or failed, returns the relay bias.
+    */
+    float update(float measurement, float deltaT);
+    //! Fixed-rate update, using the sample time set by setSampleTime().
+    inline float update(float measurement) { return update(measurement, _deltaT); }
+    inline void setSampleTime(float deltaT) { _deltaT = deltaT; }
+
+    inline float getUltimateGain() const { return _ultimateGain; } //!< Ku, valid when tuning is complete
+    inline float getUltimatePeriod() const { return _ultimatePeriod; } //!< Pu, in seconds, valid when tuning is complete
+    inline float getOscillationAmplitude() const { return _oscillationAmplitude; } //!< amplitude of the measurement oscillation
+    inline uint32_t getCycleCount() const { return _cycleCount; }
+
+    //! PID gains calculated from the measured ultimate gain and period, using the given rule.
+    inline PIDF_t getPID(rule_e rule) const { return calculatePID(rule, _ultimateGain, _ultimatePeriod); }
+    static PIDF_t calculatePID(rule_e rule, float ultimateGain, float ultimatePeriod);
+private:
+    void completeCycle(float deltaT);
+private:
+    config_t _config {};
+    float _setpoint {0.0F};
+    float _deltaT {0.0F};
+    uint32_t _sampleCount {0}; //!< number of updates since tuning started
+    uint32_t _cycleStartSample {0}; //!< sample count at the start of the current cycle, ie when the relay last switched low
+    float _max {0.0F}; //!< maximum measurement in the current cycle
+    float _min {0.0F}; //!< minimum measurement in the current cycle
+    float _amplitudeSum {0.0F};
+    uint32_t _periodSampleSum {0}; //!< sum of the measured cycle lengths, in samples
+    float _oscillationAmplitude {0.0F};
+    float _ultimateGain {0.0F};
+    float _ultimatePeriod {0.0F};
+    uint32_t _cycleCount {0}; //!< number of complete cycles, including the cycle started when the relay first switches low
+    state_e _state {IDLE};
+    bool _relayHigh {false};
+    uint16_t _unused {0};
+};
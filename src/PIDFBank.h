@@ -0,0 +1,157 @@
+# pragma once
+
+#include "PIDF.h"
+#include "PIDFSimd.h"
+#include <array>
+#include <cstddef>
+
+/*!
+Bank of N independent PIDF controllers, stored as a structure of arrays.
+
+Gains, setpoints, integrals and limits are each held in their own aligned array, so all N controllers can be updated
+with a single call to `update`, which uses SSE2/AVX2 on x86, NEON on AArch64, and scalar code otherwise.
+
+Each controller in the bank calculates the same output as the corresponding call to `PIDF::updateDelta`, or, for a controller
+with a non-zero tracking gain, to `PIDFT<PIDFTerms::ALL | PIDFTerms::BACK_CALCULATION>::updateDelta`.
+The results are bit-identical when FP contraction is not used (eg when compiled with `-ffp-contract=off`, or when the
+target has no fused multiply-add). When the compiler fuses multiply-adds differently in the scalar and vector code,
+each fused operation skips one rounding, so outputs then agree to within a few ULP of the largest term.
+The sign of a zero integral may also differ, since `std::fmax(-0.0F, 0.0F)` is allowed to return either zero.
+*/
+template <size_t N>
+class PIDFBank {
+public:
+    static constexpr size_t ALIGNMENT = 32;
+    static constexpr size_t CAPACITY = (N + 7) / 8 * 8; //!< arrays are padded to a multiple of 8 floats, so they stay aligned
+    using PIDF_t = PIDF::PIDF_t;
+    using error_t = PIDF::error_t;
+public:
+    inline size_t size() const { return N; }
+
+    inline void setPID(size_t index, const PIDF_t& pid) {
+        _kp[index] = pid.kp; _ki[index] = pid.ki; _kd[index] = pid.kd; _ks[index] = pid.ks; _kk[index] = pid.kk;
+    }
+    inline PIDF_t getPID(size_t index) const { return PIDF_t { _kp[index], _ki[index], _kd[index], _ks[index], _kk[index] }; }
+    inline void setPIDAll(const PIDF_t& pid) { for (size_t ii = 0; ii < N; ++ii) { setPID(ii, pid); } }
+
+    inline void setIntegralMax(size_t index, float integralMax) { _integralMax[index] = integralMax; }
+    inline void setIntegralMin(size_t index, float integralMin) { _integralMin[index] = integralMin; }
+    inline void setIntegralLimit(size_t index, float integralLimit) { _integralMax[index] = integralLimit; _integralMin[index] = -integralLimit; }
+    inline void setIntegralThreshold(size_t index, float integralThreshold) { _integralThreshold[index] = integralThreshold; }
+    inline void setOutputSaturationValue(size_t index, float outputSaturationValue) { _outputSaturationValue[index] = outputSaturationValue; }
+    //! Back-calculation tracking gain, see PIDFT::setTrackingGain. Zero (the default) uses integral limiting on output saturation.
+    inline void setTrackingGain(size_t index, float trackingGain) { _trackingGain[index] = trackingGain; }
+
+    inline void setSetpoint(size_t index, float setpoint) { _setpoint[index] = setpoint; }
+    inline void setSetpointDerivative(size_t index, float setpointDerivative) { _setpointDerivative[index] = setpointDerivative; }
+    inline float getSetpoint(size_t index) const { return _setpoint[index]; }
+
+    inline void resetIntegral(size_t index) { _errorIntegral[index] = 0.0F; }
+    void resetAll() {
+        _setpoint.fill(0.0F);
+        _setpointDerivative.fill(0.0F);
+        _errorIntegral.fill(0.0F);
+        _errorPrevious.fill(0.0F);
+        _errorDerivative.fill(0.0F);
+    }
+
+    inline error_t getError(size_t index) const {
+        return error_t {
+            _errorPrevious[index]*_kp[index],
+            _errorIntegral[index],
+            _errorDerivative[index]*_kd[index],
+            _setpoint[index]*_ks[index],
+            _setpointDerivative[index]*_kk[index]
+        };
+    }
+    inline float getErrorI(size_t index) const { return _errorIntegral[index]; }
+    inline float getPreviousError(size_t index) const { return _errorPrevious[index]; }
+
+    /*!
+    Update all N controllers. Equivalent to calling `updateDelta(measurements[ii], measurementDeltas[ii], deltaT)`
+    on N separate PIDF objects. The input and output arrays need not be aligned.
+    */
+    void update(const float* measurements, const float* measurementDeltas, float deltaT, float* outputs) { // NOLINT(bugprone-easily-swappable-parameters)
+        constexpr size_t VECTOR_END = N / pidf_simd_t::WIDTH * pidf_simd_t::WIDTH;
+        for (size_t ii = 0; ii < VECTOR_END; ii += pidf_simd_t::WIDTH) {
+            updateLanes<pidf_simd_t>(ii, measurements, measurementDeltas, deltaT, outputs);
+        }
+        for (size_t ii = VECTOR_END; ii < N; ++ii) {
+            updateLanes<pidf_simd_scalar_t>(ii, measurements, measurementDeltas, deltaT, outputs);
+        }
+    }
+    //! Scalar update of all N controllers, for comparison with the SIMD version.
+    void updateScalar(const float* measurements, const float* measurementDeltas, float deltaT, float* outputs) { // NOLINT(bugprone-easily-swappable-parameters)
+        for (size_t ii = 0; ii < N; ++ii) {
+            updateLanes<pidf_simd_scalar_t>(ii, measurements, measurementDeltas, deltaT, outputs);
+        }
+    }
+private:
+    /*!
+    Branch-free form of PIDF::updateDeltaITerm, with iTermError equal to the error, operating on V::WIDTH lanes starting at index.
+    */
+    template <typename V>
+    void updateLanes(size_t index, const float* measurements, const float* measurementDeltas, float deltaT, float* outputs) { // NOLINT(bugprone-easily-swappable-parameters)
+        using v = typename V::v;
+        using m = typename V::m;
+        const v zero = V::zero();
+        const v dT = V::set1(deltaT);
+
+        const v setpoint = V::load(&_setpoint[index]);
+        const v error = V::sub(setpoint, V::loadu(measurements + index));
+        const v errorDerivative = V::div(V::neg(V::loadu(measurementDeltas + index)), dT);
+        //                                      P                                    + D                                                     + S                                        + K
+        const v partialSum = V::add(V::add(V::add(V::mul(V::load(&_kp[index]), error), V::mul(V::load(&_kd[index]), errorDerivative)), V::mul(V::load(&_ks[index]), setpoint)),
+                                    V::mul(V::load(&_kk[index]), V::load(&_setpointDerivative[index])));
+
+        // integrate the error, with integral clamping, if the error is above the integral threshold
+        v errorIntegral = V::load(&_errorIntegral[index]);
+        const v integralThreshold = V::load(&_integralThreshold[index]);
+        const m integrate = V::mor(V::eq(integralThreshold, zero), V::ge(V::abs(error), integralThreshold));
+        v integrated = V::add(errorIntegral, V::mul(V::mul(V::load(&_ki[index]), error), dT));
+        const v integralMax = V::load(&_integralMax[index]);
+        integrated = V::select(V::mand(V::gt(integralMax, zero), V::gt(integrated, integralMax)), integralMax, integrated);
+        const v integralMin = V::load(&_integralMin[index]);
+        integrated = V::select(V::mand(V::lt(integralMin, zero), V::lt(integrated, integralMin)), integralMin, integrated);
+        errorIntegral = V::select(integrate, integrated, errorIntegral);
+
+        // anti-windup by avoiding output saturation
+        const v outputSaturationValue = V::load(&_outputSaturationValue[index]);
+        const v upper = V::sub(outputSaturationValue, partialSum);
+        const v lower = V::sub(V::neg(outputSaturationValue), partialSum);
+        v limited = V::select(V::gt(errorIntegral, upper), V::max(upper, zero),
+                              V::select(V::lt(errorIntegral, lower), V::min(lower, zero), errorIntegral));
+        // or back-calculation, where the integral tracks the saturated output
+        const v trackingGain = V::load(&_trackingGain[index]);
+        const v unsaturated = V::add(partialSum, errorIntegral);
+        const v saturated = V::min(V::max(unsaturated, V::neg(outputSaturationValue)), outputSaturationValue);
+        const v tracked = V::add(errorIntegral, V::mul(V::mul(trackingGain, dT), V::sub(saturated, unsaturated)));
+        limited = V::select(V::gt(trackingGain, zero), tracked, limited);
+        errorIntegral = V::select(V::gt(outputSaturationValue, zero), limited, errorIntegral);
+
+        V::store(&_errorIntegral[index], errorIntegral);
+        V::store(&_errorPrevious[index], error);
+        V::store(&_errorDerivative[index], errorDerivative);
+        V::storeu(outputs + index, V::add(partialSum, errorIntegral));
+    }
+private:
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _kp {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _ki {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _kd {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _ks {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _kk {};
+
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _setpoint {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _setpointDerivative {};
+
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _errorIntegral {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _errorPrevious {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _errorDerivative {};
+
+    // integral anti-windup parameters
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _integralMax {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _integralMin {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _integralThreshold {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _outputSaturationValue {};
+    alignas(ALIGNMENT) std::array<float, CAPACITY> _trackingGain {};
+};
@@ -0,0 +1,143 @@
+# pragma once
+
+#include "PIDF.h"
+#include <cstdint>
+#include <type_traits>
+
+/*!
+Cascaded controller: the output of the outer controller (eg angle) is the setpoint of the inner controller (eg rate).
+
+Both stages are run by a single call to `update`, which is called at the inner loop rate. The outer controller is updated
+every rateDivisor calls, so the outer loop runs at an integer fraction of the inner loop rate.
+
+Both stages use fixed-rate updates, with the sample times set by `setSampleTime`. The inner setpoint derivative,
+used by the inner K-term, is calculated from the change in the outer output using the precomputed reciprocal of the outer
+sample time, rather than the division done by `setSetpoint(setpoint, deltaT)`.
+
+Anti-windup is propagated from the inner stage to the outer stage: if the inner output saturates (ie reaches the
+cascade's output limit, or the inner controller's own output saturation value, if it has PIDFTerms::OUTPUT_SATURATION and
+the value is set) or the inner setpoint is limited, then the outer integral is frozen while the outer error would drive the
+inner stage further into saturation. This assumes both stages are direct-acting, ie increasing the outer output increases
+the inner output.
+
+The cascade's values (setpoints, measurements, limits, and output) are of the controllers' value type, eg double for a
+cascade of PIDFDouble controllers. Both controllers must have the same value type.
+*/
+template <typename OUTER = PIDF, typename INNER = PIDF>
+class PIDFCascade {
+public:
+    using value_type = typename INNER::value_type;
+    using PIDF_t = typename INNER::PIDF_t;
+    static_assert(OUTER::HAS_FIXED_RATE && INNER::HAS_FIXED_RATE, "cascade requires fixed rate controllers");
+    static_assert(std::is_same_v<typename OUTER::value_type, value_type>, "cascade requires controllers with the same value type");
+public:
+    PIDFCascade(const PIDF_t& outerPID, const PIDF_t& innerPID) : _outer(outerPID), _inner(innerPID) {}
+    PIDFCascade() = default;
+public:
+    inline OUTER& getOuter() { return _outer; }
+    inline const OUTER& getOuter() const { return _outer; }
+    inline INNER& getInner() { return _inner; }
+    inline const INNER& getInner() const { return _inner; }
+
+    /*!
+    Set the inner loop sample time, and the number of inner loop updates per outer loop update.
+    */
+    inline void setSampleTime(value_type innerDeltaT, uint32_t rateDivisor) {
+        _rateDivisor = rateDivisor == 0 ? 1 : rateDivisor;
+        const value_type outerDeltaT = innerDeltaT*static_cast<value_type>(_rateDivisor);
+        _outer.setSampleTime(outerDeltaT);
+        _inner.setSampleTime(innerDeltaT);
+        _outerDeltaTReciprocal = value_type(1) / outerDeltaT;
+        _counter = 0;
+    }
+    inline uint32_t getRateDivisor() const { return _rateDivisor; }
+
+    inline void setSetpoint(value_type setpoint) { _outer.setSetpoint(setpoint); }
+    inline value_type getSetpoint() const { return _outer.getSetpoint(); }
+    inline value_type getInnerSetpoint() const { return _inner.getSetpoint(); }
+
+    //! Limit on the magnitude of the inner setpoint (ie the outer output), 0 for no limit.
+    inline void setInnerSetpointLimit(value_type innerSetpointLimit) { _innerSetpointLimit = innerSetpointLimit; }
+    //! Limit on the magnitude of the inner output, 0 for no limit.
+    inline void setOutputLimit(value_type outputLimit) { _outputLimit = outputLimit; }
+    //! +1 if the inner stage has saturated high since the last outer update, -1 if low, 0 otherwise.
+    inline value_type getSaturation() const { return _saturation; }
+
+    inline value_type update(value_type outerMeasurement, value_type innerMeasurement) {
+        return updateDelta(outerMeasurement, innerMeasurement, innerMeasurement - _inner.getPreviousMeasurement());
+    }
+    /*!
+    Update the cascade, called at the inner loop rate. innerMeasurementDelta is the change in the inner measurement
+    since the previous call, which allows it to be filtered.
+    Returns the output of the inner controller.
+    */
+    value_type updateDelta(value_type outerMeasurement, value_type innerMeasurement, value_type innerMeasurementDelta) {
+        if (_counter == 0) {
+            _counter = _rateDivisor;
+            updateOuter(outerMeasurement);
+        }
+        --_counter;
+
+        value_type output = _inner.updateDelta(innerMeasurement, innerMeasurementDelta);
+        if constexpr (INNER::HAS_OUTPUT_SATURATION) {
+            // the inner controller limits its integral so that its output does not go beyond its saturation value,
+            // so an output at (or beyond) the saturation value means the inner stage is saturated
+            const value_type saturationValue = _inner.getOutputSaturationValue();
+            if (saturationValue > value_type(0)) {
+                if (output >= saturationValue) {
+                    _saturation = value_type(1);
+                } else if (output <= -saturationValue) {
+                    _saturation = value_type(-1);
+                }
+            }
+        }
+        if (_outputLimit > value_type(0)) {
+            if (output > _outputLimit) {
+                output = _outputLimit;
+                _saturation = value_type(1);
+            } else if (output < -_outputLimit) {
+                output = -_outputLimit;
+                _saturation = value_type(-1);
+            }
+        }
+        return output;
+    }
+
+    void resetAll() {
+        _outer.resetAll();
+        _inner.resetAll();
+        _saturation = value_type(0);
+        _counter = 0;
+    }
+private:
+    inline void updateOuter(value_type outerMeasurement) {
+        const value_type error = _outer.getSetpoint() - outerMeasurement;
+        // freeze the outer integral if the inner stage was saturated in the direction the outer error is driving it
+        const value_type iTermError = (_saturation*error > value_type(0)) ? value_type(0) : error;
+        value_type innerSetpoint = _outer.updateDeltaITerm(outerMeasurement, outerMeasurement - _outer.getPreviousMeasurement(), iTermError);
+
+        _saturation = value_type(0);
+        if (_innerSetpointLimit > value_type(0)) {
+            if (innerSetpoint > _innerSetpointLimit) {
+                innerSetpoint = _innerSetpointLimit;
+                _saturation = value_type(1);
+            } else if (innerSetpoint < -_innerSetpointLimit) {
+                innerSetpoint = -_innerSetpointLimit;
+                _saturation = value_type(-1);
+            }
+        }
+        if constexpr (INNER::HAS_K) {
+            _inner.setSetpointDerivative((innerSetpoint - _inner.getSetpoint())*_outerDeltaTReciprocal);
+        }
+        _inner.setSetpoint(innerSetpoint);
+    }
+private:
+    OUTER _outer;
+    INNER _inner;
+    value_type _outerDeltaTReciprocal {0};
+    value_type _innerSetpointLimit {0};
+    value_type _outputLimit {0};
+    value_type _saturation {0}; //!< direction of saturation of the inner stage since the last outer update
+    uint32_t _rateDivisor {1};
+    uint32_t _counter {0};
+};
@@ -0,0 +1,66 @@
+# pragma once
+
+#include <cstdint>
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define PIDF_DENORMAL_GUARD_SSE
+#elif defined(__aarch64__)
+#define PIDF_DENORMAL_GUARD_AARCH64
+#elif defined(__arm__) && defined(__ARM_FP) && !defined(__SOFTFP__)
+#define PIDF_DENORMAL_GUARD_VFP
+#endif
+
+/*!
+Scoped flush-to-zero (FTZ) and denormals-are-zero (DAZ) mode, for host builds.
+
+On x86, and to a lesser extent on some ARM cores, arithmetic on subnormal (denormal) floating point values is handled in
+microcode and is many times slower than normal arithmetic. A controller whose error decays towards zero while the setpoint
+is held (eg in a long simulation) can end up doing subnormal arithmetic on every update. While a guard is in scope, subnormal
+results are flushed to zero and subnormal inputs are treated as zero, so all the arithmetic runs at full speed:
+
+    {
+        const PIDFDenormalGuard guard;
+        // updates here do no subnormal arithmetic
+    }
+
+The previous mode is restored when the guard goes out of scope, so guards can be nested. The mode is per thread, so each
+thread needs its own guard. The mode affects all floating point code on the thread, not just the controllers: where that is
+not acceptable, use PIDFTerms::FLUSH_DENORMALS (or build PIDF with USE_PIDF_FLUSH_DENORMALS defined) instead, which flushes
+only the controllers' own values.
+
+Uses the MXCSR FTZ and DAZ bits on x86 (SSE), and the FPCR/FPSCR FZ bit on ARM. On other targets the guard does nothing,
+and isSupported returns false.
+*/
+class PIDFDenormalGuard {
+public:
+    PIDFDenormalGuard() : _savedMode(getMode()) { setMode(_savedMode | FLUSH_MODE); }
+    ~PIDFDenormalGuard() { setMode(_savedMode); }
+    PIDFDenormalGuard(const PIDFDenormalGuard&) = delete;
+    PIDFDenormalGuard& operator=(const PIDFDenormalGuard&) = delete;
+    PIDFDenormalGuard(PIDFDenormalGuard&&) = delete;
+    PIDFDenormalGuard& operator=(PIDFDenormalGuard&&) = delete;
+public:
+    static constexpr bool isSupported() { return FLUSH_MODE != 0; }
+    //! True if subnormal values are currently flushed to zero on this thread.
+    static bool isFlushing() { return isSupported() && (getMode() & FLUSH_MODE) == FLUSH_MODE; }
+private:
+#if defined(PIDF_DENORMAL_GUARD_SSE)
+    static constexpr uint64_t FLUSH_MODE = 0x8040; // MXCSR FTZ (bit 15) and DAZ (bit 6)
+    static uint64_t getMode() { return _mm_getcsr(); }
+    static void setMode(uint64_t mode) { _mm_setcsr(static_cast<unsigned int>(mode)); }
+#elif defined(PIDF_DENORMAL_GUARD_AARCH64)
+    static constexpr uint64_t FLUSH_MODE = 1ULL << 24U; // FPCR FZ
+    static uint64_t getMode() { uint64_t mode = 0; __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode)); return mode; }
+    static void setMode(uint64_t mode) { __asm__ __volatile__("msr fpcr, %0" : : "r"(mode)); }
+#elif defined(PIDF_DENORMAL_GUARD_VFP)
+    static constexpr uint64_t FLUSH_MODE = 1ULL << 24U; // FPSCR FZ
+    static uint64_t getMode() { uint32_t mode = 0; __asm__ __volatile__("vmrs %0, fpscr" : "=r"(mode)); return mode; }
+    static void setMode(uint64_t mode) { __asm__ __volatile__("vmsr fpscr, %0" : : "r"(static_cast<uint32_t>(mode))); }
+#else
+    static constexpr uint64_t FLUSH_MODE = 0;
+    static uint64_t getMode() { return 0; }
+    static void setMode(uint64_t mode) { (void)mode; }
+#endif
+private:
+    uint64_t _savedMode;
+};
@@ -0,0 +1,131 @@
+#include "PIDFDirectForm.h"
+
+
+PIDFDirectForm::PIDFDirectForm(const PIDF_t& pid, float deltaT, float derivativeFilterTimeConstant, discretization_e discretization) :
+    _coefficients(calculateCoefficients(pid, deltaT, derivativeFilterTimeConstant, discretization)),
+    _pid(pid),
+    _deltaT(deltaT),
+    _derivativeFilterTimeConstant(derivativeFilterTimeConstant),
+    _discretization(discretization)
+{
+}
+
+/*!
+The integral is I(z) = ki*NI(z)/(1 - z^-1) and the (filtered) derivative is D(z) = g*(1 - z^-1)/(1 - pole*z^-1), where:
+
+    backward Euler: NI(z) = T,                 g = 1/(T + tf),    pole = tf/(T + tf)
+    Tustin:         NI(z) = (T/2)*(1 + z^-1),  g = 2/(2*tf + T),  pole = (2*tf - T)/(2*tf + T)
+
+Over the common denominator A(z) = (1 - z^-1)*(1 - pole*z^-1) the error numerator is:
+
+    bError(z) = kp*A(z) + ki*NI(z)*(1 - pole*z^-1) + kd*g*(1 - z^-1)^2
+*/
+PIDFDirectForm::coefficients_t PIDFDirectForm::calculateCoefficients(const PIDF_t& pid, float deltaT, float derivativeFilterTimeConstant, discretization_e discretization)
+{
+    const float tf = derivativeFilterTimeConstant;
+    const bool tustin = discretization == TUSTIN;
+    const float ni0 = tustin ? 0.5F*deltaT : deltaT;
+    const float ni1 = tustin ? 0.5F*deltaT : 0.0F;
+    const bool tustinDerivative = tustin && tf > 0.0F;
+    const float g = tustinDerivative ? 2.0F / (2.0F*tf + deltaT) : 1.0F / (tf + deltaT);
+    const float poleUnrounded = tustinDerivative ? (2.0F*tf - deltaT) / (2.0F*tf + deltaT) : tf / (tf + deltaT);
+    // round the pole so that 1 + pole is exact, then A(1) = 1 - (1 + pole) + pole is exactly zero,
+    // so that rounding of the coefficients does not make the integrator leak (or grow)
+    const float onePlusPole = 1.0F + poleUnrounded;
+    const float pole = onePlusPole - 1.0F;
+
+    coefficients_t c {};
+    c.bError = {
+        pid.kp + pid.ki*ni0 + pid.kd*g,
+        -pid.kp*onePlusPole + pid.ki*(ni1 - pole*ni0) - 2.0F*pid.kd*g,
+        pid.kp*pole - pid.ki*pole*ni1 + pid.kd*g
+    };
+    c.a = { -onePlusPole, pole };
+    c.setpointDerivative = (pid.kk - pid.kd)*g;
+    c.setpoint = pid.ks;
+    c.integralStep = pid.ki*deltaT;
+    c.derivativePole = pole;
+    return c;
+}
+
+/*!
+The filter output is P + I + F, where F is the filtered derivative (D and K) contribution.
+If the inputs were held constant, the next filter output would be P + I + ki*T*error + pole*F (for both backward Euler and Tustin),
+and this prediction can be calculated from the filter state. These two equations are solved for I and F.
+*/
+void PIDFDirectForm::getTerms(float& integral, float& derivative) const
+{
+    const coefficients_t& c = _coefficients;
+    const float error = _setpointPrevious - _measurementPrevious;
+    const float iir = _output - c.setpoint*_setpointPrevious;
+    const float iirPredicted = c.bError[0]*error + c.setpointDerivative*_setpointPrevious + _state[0];
+    derivative = (iirPredicted - iir - c.integralStep*error) / (c.derivativePole - 1.0F);
+    integral = iir - _pid.kp*error - derivative;
+}
+
+//! Set the filter state from the integral and filtered derivative, the inverse of getTerms.
+void PIDFDirectForm::setTerms(float integral, float derivative)
+{
+    const coefficients_t& c = _coefficients;
+    const float error = _setpointPrevious - _measurementPrevious;
+    const float setpointTerm = c.setpointDerivative*_setpointPrevious;
+    const float iir = _pid.kp*error + integral + derivative;
+    const float iirPredicted = iir + c.integralStep*error + (c.derivativePole - 1.0F)*derivative;
+    _state[0] = iirPredicted - c.bError[0]*error - setpointTerm;
+    _state[1] = c.bError[2]*error + setpointTerm - c.a[1]*iir;
+    _output = iir + c.setpoint*_setpointPrevious;
+}
+
+PIDFDirectForm::error_t PIDFDirectForm::getError() const
+{
+    float integral {};
+    float derivative {};
+    getTerms(integral, derivative);
+    const float error = _setpointPrevious - _measurementPrevious;
+    const bool derivativeIsK = _pid.kd == 0.0F && _pid.kk != 0.0F;
+    return error_t {
+        .P = _pid.kp*error,
+        .I = integral,
+        .D = derivativeIsK ? 0.0F : derivative,
+        .S = _pid.ks*_setpointPrevious,
+        .K = derivativeIsK ? derivative : 0.0F
+    };
+}
+
+void PIDFDirectForm::setPID(const PIDF_t& pid)
+{
+    float integral {};
+    float derivative {};
+    getTerms(integral, derivative);
+    _pid = pid;
+    _coefficients = calculateCoefficients(_pid, _deltaT, _derivativeFilterTimeConstant, _discretization);
+    setTerms(integral, derivative);
+}
+
+void PIDFDirectForm::setSampleTime(float deltaT)
+{
+    float integral {};
+    float derivative {};
+    getTerms(integral, derivative);
+    _deltaT = deltaT;
+    _coefficients = calculateCoefficients(_pid, _deltaT, _derivativeFilterTimeConstant, _discretization);
+    setTerms(integral, derivative);
+}
+
+void PIDFDirectForm::setDerivativeFilterTimeConstant(float derivativeFilterTimeConstant)
+{
+    float integral {};
+    float derivative {};
+    getTerms(integral, derivative);
+    _derivativeFilterTimeConstant = derivativeFilterTimeConstant;
+    _coefficients = calculateCoefficients(_pid, _deltaT, _derivativeFilterTimeConstant, _discretization);
+    setTerms(integral, derivative);
+}
+
+void PIDFDirectForm::reset()
+{
+    _state = {};
+    _output = 0.0F;
+    _setpointPrevious = 0.0F;
+    _measurementPrevious = 0.0F;
+}
@@ -0,0 +1,113 @@
+# pragma once
+
+#include "PIDFT.h"
+#include <array>
+
+/*!
+PID controller implemented as a discrete-time IIR filter (difference equation), for a fixed sample time.
+
+Once the sample time is fixed, the controller
+
+    output = kp*error + ki*integral(error) - kd*derivative(measurement) + ks*setpoint + kk*derivative(setpoint)
+
+(with the derivatives optionally low-pass filtered with time constant tf) is a linear filter. Writing the derivative of the
+measurement as derivative(setpoint) - derivative(error), this is
+
+    output = E(z)*error + c*(1 - z^-1)^2/A(z)*setpoint + ks*setpoint
+
+where A(z) = (1 - z^-1)*(1 - pole*z^-1) and c = (kk - kd)*g, with g the derivative gain of the (filtered) backward difference.
+This is run as a second order transposed direct form II filter:
+
+    setpointTerm = c*setpoint
+    iir = bError[0]*error + setpointTerm + state[0]
+    state[0] = bError[1]*error - 2*setpointTerm - a[0]*iir + state[1]
+    state[1] = bError[2]*error + setpointTerm - a[1]*iir
+    output = iir + ks*setpoint
+
+Using the error, rather than the setpoint and measurement, as the filter input avoids the large cancellation in the setpoint
+and measurement numerators (each sums to about ki*deltaT), whose rounding would otherwise be integrated as a steady-state error.
+The rounding of the transient after a setpoint step is still integrated, so the output then settles slightly (of order 1e-5
+of the transient) away from its exact value, but does not drift. The rounding, and so this offset, is different if the compiler
+fuses the multiply-adds (eg with -march=native, or by default on AArch64), so the output is not bit-identical between builds
+with and without floating point contraction.
+
+The integral is discretized using backward Euler (the same as the fixed-rate PIDF update) or Tustin (trapezoidal) integration.
+The derivatives are backward differences, filtered by a first order low-pass filter when tf is non-zero (discretized using
+the selected method, Tustin is only used for the derivative when tf is non-zero, since otherwise it has a pole at z = -1).
+
+With backward Euler and no derivative filter, the output is the same as the fixed-rate `PIDF::update` when the setpoint is set by
+`setSetpoint(setpoint, deltaT)` before every update, ie the K-term is the setpoint derivative of the current sample.
+
+There is no per-term state, so the error terms are not stored: `getError` reconstructs them from the filter state when asked.
+There are no integral limits and no output saturation, for anti-windup use PIDFT.
+*/
+class PIDFDirectForm : public PIDFBase {
+public:
+    enum discretization_e { BACKWARD_EULER, TUSTIN };
+    struct coefficients_t {
+        std::array<float, 3> bError; //!< numerator of the transfer function from the error to the output
+        std::array<float, 2> a; //!< denominator, a[0]*z^-1 + a[1]*z^-2, the z^0 coefficient is 1
+        float setpointDerivative; //!< c, the setpoint numerator is c*(1 - 2*z^-1 + z^-2)
+        float setpoint; //!< ks, the setpoint is also fed through directly
+        float integralStep; //!< ki*deltaT, the change in the integral for a constant error, used to reconstruct the error terms
+        float derivativePole; //!< pole of the derivative filter, 0 when there is no filter
+    };
+public:
+    PIDFDirectForm(const PIDF_t& pid, float deltaT, float derivativeFilterTimeConstant = 0.0F, discretization_e discretization = BACKWARD_EULER);
+public:
+    //! Calculate the difference equation coefficients for the given gains and sample time.
+    static coefficients_t calculateCoefficients(const PIDF_t& pid, float deltaT, float derivativeFilterTimeConstant, discretization_e discretization);
+
+    inline const coefficients_t& getCoefficients() const { return _coefficients; }
+    inline const PIDF_t& getPID() const { return _pid; }
+    inline float getSampleTime() const { return _deltaT; }
+    inline float getDerivativeFilterTimeConstant() const { return _derivativeFilterTimeConstant; }
+    inline discretization_e getDiscretization() const { return _discretization; }
+
+    // Changing the gains, sample time, or filter time constant recalculates the coefficients and transforms the filter state
+    // so that the integral and filtered derivative are preserved, so the change is bumpless.
+    void setPID(const PIDF_t& pid);
+    void setSampleTime(float deltaT);
+    void setDerivativeFilterTimeConstant(float derivativeFilterTimeConstant);
+
+    inline void setSetpoint(float setpoint) { _setpoint = setpoint; }
+    inline float getSetpoint() const { return _setpoint; }
+    inline float getPreviousMeasurement() const { return _measurementPrevious; }
+    inline float getOutput() const { return _output; }
+
+    inline float update(float measurement) {
+        const coefficients_t& c = _coefficients;
+        const float error = _setpoint - measurement;
+        const float setpointTerm = c.setpointDerivative*_setpoint;
+        const float iir = c.bError[0]*error + setpointTerm + _state[0];
+        _state[0] = c.bError[1]*error - 2.0F*setpointTerm - c.a[0]*iir + _state[1];
+        _state[1] = c.bError[2]*error + setpointTerm - c.a[1]*iir;
+        const float output = iir + c.setpoint*_setpoint;
+        _setpointPrevious = _setpoint;
+        _measurementPrevious = measurement;
+        _output = output;
+        return output;
+    }
+
+    /*!
+    Reconstruct the error terms of the most recent update, for telemetry.
+    The D and K terms share the derivative filter state, so their sum is returned as D
+    (or as K if kd is zero).
+    */
+    error_t getError() const;
+    void reset();
+private:
+    void getTerms(float& integral, float& derivative) const;
+    void setTerms(float integral, float derivative);
+private:
+    coefficients_t _coefficients {};
+    PIDF_t _pid {};
+    float _deltaT;
+    float _derivativeFilterTimeConstant;
+    discretization_e _discretization;
+    float _setpoint {0.0F};
+    float _setpointPrevious {0.0F}; //!< setpoint used by the most recent update
+    float _measurementPrevious {0.0F};
+    float _output {0.0F};
+    std::array<float, 2> _state {};
+};
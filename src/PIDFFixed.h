@@ -0,0 +1,216 @@
+# pragma once
+
+#include "PIDFT.h"
+#include <cstdint>
+#include <limits>
+
+//! Double width type, for products of fixed-point values
+template <typename T> struct pidf_fixed_wide_t;
+template <> struct pidf_fixed_wide_t<int16_t> { using type = int32_t; };
+template <> struct pidf_fixed_wide_t<int32_t> { using type = int64_t; };
+
+/*!
+Fixed-point PIDF controller, for processors without a floating point unit.
+
+Has the same terms and anti-windup as PIDF (P, I, D, S, and K terms, integral limits, integral threshold, and output saturation),
+using saturating integer arithmetic, so there are no floating point operations in the update. Floating point is only used when
+converting gains and the sample time, ie when the controller is configured.
+
+The template parameters select the Q formats:
+
+    T                    the value type, int16_t or int32_t, products are calculated in the double width type W
+    VALUE_FRACTION_BITS  fraction bits of the setpoint, measurement, output, and limits, so values are in the range
+                         [-2^(B-1-VALUE_FRACTION_BITS), 2^(B-1-VALUE_FRACTION_BITS)), where B is the number of bits in T
+    GAIN_FRACTION_BITS   fraction bits of kp, ks, kk, and kd/deltaT, which must all fit in the gain range
+
+For example `PIDFFixed<int16_t, 15, 8>` (PIDFQ15) has Q15 values in the range [-1, 1) and Q7.8 gains in the range [-128, 128).
+
+Only fixed-rate update is supported: `setSampleTime` precomputes kd/deltaT in the gain format, and ki*deltaT as a pure
+fraction (Q15 or Q31), so it must be less than 1. The integral is held in W, with VALUE_FRACTION_BITS + B - 1 fraction bits, so
+that small increments ki*deltaT*error are not lost. The D-term uses the change in measurement per sample,
+and the K-term uses the setpoint derivative set by `setSetpointDerivative`, in value units per second.
+*/
+template <typename T, int VALUE_FRACTION_BITS, int GAIN_FRACTION_BITS>
+class PIDFFixed {
+public:
+    using W = typename pidf_fixed_wide_t<T>::type;
+    using PIDF_t = PIDFBase::PIDF_t;
+    struct error_t {
+        T P;
+        T I;
+        T D;
+        T S;
+        T K;
+    };
+    static constexpr int BITS = std::numeric_limits<T>::digits + 1;
+    static constexpr int INTEGRAL_GAIN_FRACTION_BITS = BITS - 1; //!< ki*deltaT is a pure fraction
+    static constexpr int INTEGRAL_FRACTION_BITS = VALUE_FRACTION_BITS + INTEGRAL_GAIN_FRACTION_BITS;
+    static constexpr W INTEGRAL_SCALE = W{1} << INTEGRAL_GAIN_FRACTION_BITS; //!< integral in the value format times INTEGRAL_SCALE
+    static_assert(VALUE_FRACTION_BITS > 0 && VALUE_FRACTION_BITS < BITS, "invalid value format");
+    static_assert(GAIN_FRACTION_BITS > 0 && GAIN_FRACTION_BITS < BITS, "invalid gain format");
+    static constexpr T T_MAX = std::numeric_limits<T>::max();
+    static constexpr T T_MIN = std::numeric_limits<T>::min();
+    static constexpr W W_MAX = std::numeric_limits<W>::max();
+    static constexpr W W_MIN = std::numeric_limits<W>::min();
+public:
+    explicit PIDFFixed(const PIDF_t& pid) : _pid(pid) { setPID(pid); }
+    PIDFFixed() : PIDFFixed({0.0F, 0.0F, 0.0F, 0.0F, 0.0F}) {}
+public:
+    // conversions, using floating point, so for configuration and test rather than in the control loop
+    static T fromFloat(float value, int fractionBits) {
+        const float scaled = value*static_cast<float>(W{1} << fractionBits);
+        if (scaled >= static_cast<float>(T_MAX)) { return T_MAX; }
+        if (scaled <= static_cast<float>(T_MIN)) { return T_MIN; }
+        return static_cast<T>(scaled < 0.0F ? scaled - 0.5F : scaled + 0.5F);
+    }
+    static float toFloat(W value, int fractionBits) { return static_cast<float>(value) / static_cast<float>(W{1} << fractionBits); }
+    static inline T fromFloat(float value) { return fromFloat(value, VALUE_FRACTION_BITS); }
+    static inline float toFloat(T value) { return toFloat(value, VALUE_FRACTION_BITS); }
+
+    //! Set the gains, converted to the gain format (saturated if out of range).
+    void setPID(const PIDF_t& pid) { _pid = pid; updateCoefficients(); }
+    inline const PIDF_t& getPID() const { return _pid; }
+    //! The gains after conversion to fixed point, converted back to floating point.
+    PIDF_t getPIDFixed() const {
+        return PIDF_t {
+            toFloat(_kp, GAIN_FRACTION_BITS),
+            _deltaT == 0.0F ? 0.0F : toFloat(_kiDeltaT, INTEGRAL_GAIN_FRACTION_BITS) / _deltaT,
+            toFloat(_kdOverDeltaT, GAIN_FRACTION_BITS)*_deltaT,
+            toFloat(_ks, GAIN_FRACTION_BITS),
+            toFloat(_kk, GAIN_FRACTION_BITS)
+        };
+    }
+    void setSampleTime(float deltaT) { _deltaT = deltaT; updateCoefficients(); }
+    inline float getSampleTime() const { return _deltaT; }
+
+    inline void setIntegralMax(T integralMax) { _integralMax = W{integralMax}*INTEGRAL_SCALE; }
+    inline void setIntegralMin(T integralMin) { _integralMin = W{integralMin}*INTEGRAL_SCALE; }
+    inline void setIntegralLimit(T integralLimit) { setIntegralMax(integralLimit); setIntegralMin(saturate(-W{integralLimit})); }
+    inline T getIntegralMax() const { return static_cast<T>(_integralMax >> INTEGRAL_GAIN_FRACTION_BITS); }
+    inline T getIntegralMin() const { return static_cast<T>(_integralMin >> INTEGRAL_GAIN_FRACTION_BITS); }
+    inline void setIntegralThreshold(T integralThreshold) { _integralThreshold = integralThreshold; }
+    inline T getIntegralThreshold() const { return _integralThreshold; }
+    inline void setOutputSaturationValue(T outputSaturationValue) { _outputSaturationValue = outputSaturationValue; }
+    inline T getOutputSaturationValue() const { return _outputSaturationValue; }
+
+    inline void setSetpoint(T setpoint) { _setpoint = setpoint; }
+    inline T getSetpoint() const { return _setpoint; }
+    inline void setSetpointDerivative(T setpointDerivative) { _setpointDerivative = setpointDerivative; }
+    inline T getPreviousMeasurement() const { return _measurementPrevious; }
+
+    inline void resetIntegral() { _errorIntegral = 0; }
+    void resetAll() {
+        _errorIntegral = 0;
+        _setpoint = 0;
+        _setpointDerivative = 0;
+        _measurementPrevious = 0;
+        _errorPrevious = 0;
+        _measurementDeltaNegated = 0;
+    }
+
+    inline error_t getError() const {
+        return error_t {
+            shiftToT(W{_kp}*_errorPrevious, GAIN_FRACTION_BITS),
+            getErrorI(),
+            shiftToT(W{_kdOverDeltaT}*_measurementDeltaNegated, GAIN_FRACTION_BITS),
+            shiftToT(W{_ks}*_setpoint, GAIN_FRACTION_BITS),
+            shiftToT(W{_kk}*_setpointDerivative, GAIN_FRACTION_BITS)
+        };
+    }
+    inline T getErrorI() const { return shiftToT(_errorIntegral, INTEGRAL_GAIN_FRACTION_BITS); }
+    inline T getPreviousError() const { return _errorPrevious; }
+
+    // fixed-rate update functions, using the sample time set by setSampleTime()
+    inline T update(T measurement) {
+        return updateDelta(measurement, subSat(measurement, _measurementPrevious));
+    }
+    inline T updateDelta(T measurement, T measurementDelta) {
+        return updateDeltaITerm(measurement, measurementDelta, subSat(_setpoint, measurement));
+    }
+    T updateDeltaITerm(T measurement, T measurementDelta, T iTermError);
+private:
+    static inline W addSat(W a, W b) {
+        W sum {};
+        if (__builtin_add_overflow(a, b, &sum)) {
+            return a < 0 ? W_MIN : W_MAX;
+        }
+        return sum;
+    }
+    static inline T saturate(W value) { return value > W{T_MAX} ? T_MAX : (value < W{T_MIN} ? T_MIN : static_cast<T>(value)); }
+    static inline T subSat(T a, T b) { return saturate(W{a} - W{b}); }
+    //! Shift right with rounding (to nearest, ties towards +infinity), and saturate.
+    static inline T shiftToT(W value, int shift) { return saturate(addSat(value, W{1} << (shift - 1)) >> shift); }
+    void updateCoefficients() {
+        _kp = fromFloat(_pid.kp, GAIN_FRACTION_BITS);
+        _kiDeltaT = fromFloat(_pid.ki*_deltaT, INTEGRAL_GAIN_FRACTION_BITS);
+        _kdOverDeltaT = _deltaT == 0.0F ? T{0} : fromFloat(_pid.kd/_deltaT, GAIN_FRACTION_BITS);
+        _ks = fromFloat(_pid.ks, GAIN_FRACTION_BITS);
+        _kk = fromFloat(_pid.kk, GAIN_FRACTION_BITS);
+    }
+private:
+    W _errorIntegral {0}; //!< integral, with INTEGRAL_FRACTION_BITS fraction bits
+    W _integralMax {0}; //!< with INTEGRAL_FRACTION_BITS fraction bits, 0 for no limit
+    W _integralMin {0};
+    PIDF_t _pid;
+    float _deltaT {0.0F};
+    T _kp {0};
+    T _kiDeltaT {0};
+    T _kdOverDeltaT {0};
+    T _ks {0};
+    T _kk {0};
+    T _setpoint {0};
+    T _setpointDerivative {0};
+    T _measurementPrevious {0};
+    T _errorPrevious {0};
+    T _measurementDeltaNegated {0}; //!< the error delta, used for the D-term
+    T _integralThreshold {0}; //!< 0 for no threshold
+    T _outputSaturationValue {0}; //!< 0 for no output saturation
+};
+
+using PIDFQ15 = PIDFFixed<int16_t, 15, 8>; //!< Q15 values in [-1, 1), Q7.8 gains
+using PIDFQ31 = PIDFFixed<int32_t, 31, 16>; //!< Q31 values in [-1, 1), Q15.16 gains
+
+/*!
+The same calculation as PIDF::updateDeltaITerm, in fixed point.
+The partial sum is calculated with VALUE_FRACTION_BITS + GAIN_FRACTION_BITS fraction bits and then rounded to the value format,
+the integral is kept with INTEGRAL_FRACTION_BITS fraction bits and rounded when added to the output.
+*/
+template <typename T, int VALUE_FRACTION_BITS, int GAIN_FRACTION_BITS>
+T PIDFFixed<T, VALUE_FRACTION_BITS, GAIN_FRACTION_BITS>::updateDeltaITerm(T measurement, T measurementDelta, T iTermError) // NOLINT(bugprone-easily-swappable-parameters)
+{
+    _measurementPrevious = measurement;
+    const T error = subSat(_setpoint, measurement);
+    _measurementDeltaNegated = saturate(-W{measurementDelta});
+
+    //                          P                                     D
+    W sum = addSat(W{_kp}*error, W{_kdOverDeltaT}*_measurementDeltaNegated);
+    //                S                                 K
+    sum = addSat(sum, addSat(W{_ks}*_setpoint, W{_kk}*_setpointDerivative));
+    const T partialSum = shiftToT(sum, GAIN_FRACTION_BITS);
+
+    const W absError = error < 0 ? -W{error} : W{error};
+    if (_integralThreshold == 0 || absError >= W{_integralThreshold}) {
+        // "integrate" the error, ki*deltaT*error is exact, with INTEGRAL_FRACTION_BITS fraction bits
+        _errorIntegral = addSat(_errorIntegral, W{_kiDeltaT}*iTermError);
+        // Anti-windup via integral clamping
+        if (_integralMax > 0 && _errorIntegral > _integralMax) {
+            _errorIntegral = _integralMax;
+        } else if (_integralMin < 0 && _errorIntegral < _integralMin) {
+            _errorIntegral = _integralMin;
+        }
+    }
+    _errorPrevious = error;
+
+    if (_outputSaturationValue > 0) {
+        // Anti-windup by avoiding output saturation, limit the integral to a value that avoids output saturation.
+        // The differences fit in B + 1 bits, so fit in W after shifting by B - 1
+        const W upper = (W{_outputSaturationValue} - partialSum)*INTEGRAL_SCALE;
+        const W lower = (-W{_outputSaturationValue} - partialSum)*INTEGRAL_SCALE;
+        if (_errorIntegral > upper) {
+            _errorIntegral = upper > 0 ? upper : 0;
+        } else if (_errorIntegral < lower) {
+            _errorIntegral = lower < 0 ? lower : 0;
+        }
+    }
+    return saturate(W{partialSum} + getErrorI());
+}
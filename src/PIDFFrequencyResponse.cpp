@@ -0,0 +1,219 @@
+#include "PIDFFrequencyResponse.h"
+#include "PIDFSimd.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+std::complex<double> PIDFTransferFunction::operator()(double omega) const
+{
+    const std::complex<double> s(0.0, omega);
+    // Horner's method, highest order first
+    std::complex<double> num {};
+    std::complex<double> den {};
+    for (size_t ii = MAX_ORDER + 1; ii > 0; --ii) {
+        num = num*s + static_cast<double>(numerator[ii - 1]);
+        den = den*s + static_cast<double>(denominator[ii - 1]);
+    }
+    return num/den*std::polar(1.0, -omega*static_cast<double>(delay));
+}
+
+PIDFTransferFunction PIDFTransferFunction::fopdt(float gain, float timeConstant, float delay)
+{
+    return PIDFTransferFunction { { gain, 0.0F, 0.0F, 0.0F, 0.0F }, { 1.0F, timeConstant, 0.0F, 0.0F, 0.0F }, delay };
+}
+
+PIDFTransferFunction PIDFTransferFunction::integrating(float gain, float delay)
+{
+    return PIDFTransferFunction { { gain, 0.0F, 0.0F, 0.0F, 0.0F }, { 0.0F, 1.0F, 0.0F, 0.0F, 0.0F }, delay };
+}
+
+PIDFTransferFunction PIDFTransferFunction::secondOrder(float gain, float naturalFrequency, float dampingRatio, float delay)
+{
+    const float omega2 = naturalFrequency*naturalFrequency;
+    return PIDFTransferFunction { { gain*omega2, 0.0F, 0.0F, 0.0F, 0.0F }, { omega2, 2.0F*dampingRatio*naturalFrequency, 1.0F, 0.0F, 0.0F }, delay };
+}
+
+
+/*!
+The controller responses are calculated in double, and 1 - z^-1 is calculated as 2*sin^2(omega*T/2) + j*sin(omega*T),
+so there is no cancellation at low frequencies, where the integral response is large.
+*/
+PIDFFrequencyResponse::PIDFFrequencyResponse(float deltaT, float minFrequency, float maxFrequency, size_t pointCount) :
+    _minFrequency(static_cast<double>(minFrequency)),
+    _logStep(0.0),
+    _maxIsNyquist(false),
+    _deltaT(deltaT),
+    _frequencies(pointCount),
+    _integralRe(pointCount),
+    _integralIm(pointCount),
+    _derivativeRe(pointCount),
+    _derivativeIm(pointCount),
+    _plantRe(pointCount, 1.0F),
+    _plantIm(pointCount, 0.0F),
+    _plantMagnitudeSquared(pointCount, 1.0F)
+{
+    const double nyquist = PI/static_cast<double>(deltaT);
+    double maximum = static_cast<double>(maxFrequency);
+    if (maximum >= nyquist) {
+        maximum = nyquist;
+        _maxIsNyquist = true;
+    }
+    if (pointCount > 1) {
+        _logStep = std::log(maximum/_minFrequency)/static_cast<double>(pointCount - 1);
+    }
+    const auto T = static_cast<double>(deltaT);
+    for (size_t ii = 0; ii < pointCount; ++ii) {
+        _frequencies[ii] = static_cast<float>(frequency(ii));
+        const std::complex<double> oneMinusZInverse = 1.0 - zInverse(ii);
+        const std::complex<double> integral = T/oneMinusZInverse;
+        const std::complex<double> derivative = oneMinusZInverse/T;
+        _integralRe[ii] = static_cast<float>(integral.real());
+        _integralIm[ii] = static_cast<float>(integral.imag());
+        _derivativeRe[ii] = static_cast<float>(derivative.real());
+        _derivativeIm[ii] = static_cast<float>(derivative.imag());
+    }
+}
+
+PIDFFrequencyResponse::~PIDFFrequencyResponse() = default;
+
+double PIDFFrequencyResponse::frequency(size_t index) const
+{
+    if (index + 1 == _frequencies.size() && _maxIsNyquist) {
+        return PI/static_cast<double>(_deltaT);
+    }
+    return _minFrequency*std::exp(static_cast<double>(index)*_logStep);
+}
+
+std::complex<double> PIDFFrequencyResponse::zInverse(size_t index) const
+{
+    if (index + 1 == _frequencies.size() && _maxIsNyquist) {
+        return { -1.0, 0.0 }; // exactly real, so a discrete plant's response is real at the Nyquist frequency
+    }
+    const double theta = frequency(index)*static_cast<double>(_deltaT);
+    const double sinHalf = std::sin(0.5*theta);
+    return { 1.0 - 2.0*sinHalf*sinHalf, -std::sin(theta) };
+}
+
+std::complex<double> PIDFFrequencyResponse::zeroOrderHold(size_t index) const
+{
+    const double theta = frequency(index)*static_cast<double>(_deltaT);
+    return (1.0 - zInverse(index))/std::complex<double>(0.0, theta);
+}
+
+std::complex<float> PIDFFrequencyResponse::getLoopGain(const PIDF::PIDF_t& pid, size_t index) const
+{
+    const std::complex<float> controller = pid.kp
+        + pid.ki*std::complex<float>(_integralRe[index], _integralIm[index])
+        + pid.kd*std::complex<float>(_derivativeRe[index], _derivativeIm[index]);
+    return controller*std::complex<float>(_plantRe[index], _plantIm[index]);
+}
+
+template <typename S>
+void PIDFFrequencyResponse::calculateLanes(const PIDF::PIDF_t& pid, size_t index, size_t lane, batch_t& batch) const
+{
+    using v = typename S::v;
+    const v integralRe = S::loadu(&_integralRe[index]);
+    const v integralIm = S::loadu(&_integralIm[index]);
+    const v derivativeRe = S::loadu(&_derivativeRe[index]);
+    const v derivativeIm = S::loadu(&_derivativeIm[index]);
+    const v plantRe = S::loadu(&_plantRe[index]);
+    const v plantIm = S::loadu(&_plantIm[index]);
+    const v ki = S::set1(pid.ki);
+    const v kd = S::set1(pid.kd);
+    // feedback path C = kp + ki*I + kd*D
+    const v controllerRe = S::add(S::set1(pid.kp), S::add(S::mul(ki, integralRe), S::mul(kd, derivativeRe)));
+    const v controllerIm = S::add(S::mul(ki, integralIm), S::mul(kd, derivativeIm));
+    // loop gain L = C*P
+    const v loopRe = S::sub(S::mul(controllerRe, plantRe), S::mul(controllerIm, plantIm));
+    const v loopIm = S::add(S::mul(controllerRe, plantIm), S::mul(controllerIm, plantRe));
+    const v onePlusLoopRe = S::add(S::set1(1.0F), loopRe);
+    const v returnDifference = S::add(S::mul(onePlusLoopRe, onePlusLoopRe), S::mul(loopIm, loopIm));
+    // setpoint path F = C + ks + (kk - kd)*D, the derivative is on the measurement, so kd is not in the setpoint path
+    const v kf = S::set1(pid.kk - pid.kd);
+    const v setpointRe = S::add(controllerRe, S::add(S::set1(pid.ks), S::mul(kf, derivativeRe)));
+    const v setpointIm = S::add(controllerIm, S::mul(kf, derivativeIm));
+    const v setpointSquared = S::add(S::mul(setpointRe, setpointRe), S::mul(setpointIm, setpointIm));
+    const v closedLoop = S::div(S::mul(S::loadu(&_plantMagnitudeSquared[index]), setpointSquared), returnDifference);
+    S::storeu(&batch.loopRe[lane], loopRe);
+    S::storeu(&batch.loopIm[lane], loopIm);
+    S::storeu(&batch.returnDifference[lane], returnDifference);
+    S::storeu(&batch.closedLoop[lane], closedLoop);
+}
+
+/*!
+Each batch of grid points is calculated with the vector operations, then scanned in order for:
+the loop gain crossing 1 (the phase margin is the angle from -1 to L), the loop gain crossing the negative real axis
+(the gain margin is 1/|L| there), the minimum of |1 + L|, and the closed-loop response first falling below half its
+power at the lowest frequency. Where there is more than one crossing, the smallest margin is reported.
+*/
+PIDFFrequencyResponse::margins_t PIDFFrequencyResponse::analyze(const PIDF::PIDF_t& pid) const
+{
+    constexpr float INF = std::numeric_limits<float>::infinity();
+    constexpr float RADIANS_TO_DEGREES = 57.2957795F;
+    margins_t margins { INF, -1.0F, INF, -1.0F, 0.0F, -1.0F, -1.0F };
+    const float logStep = static_cast<float>(_logStep);
+    // frequency at fraction t of the way from grid point index to the next
+    const auto interpolate = [this, &logStep](size_t index, float t) { return _frequencies[index]*std::exp(t*logStep); };
+
+    float minReturnDifference = INF;
+    float closedLoopHalf = 0.0F;
+    float previousRe = 0.0F;
+    float previousIm = 0.0F;
+    float previousMagnitudeSquared = 0.0F;
+    float previousClosedLoop = 0.0F;
+    batch_t batch; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init) each element is written before it is read
+    const size_t pointCount = _frequencies.size();
+    for (size_t begin = 0; begin < pointCount; begin += BATCH_SIZE) {
+        const size_t count = std::min(static_cast<size_t>(BATCH_SIZE), pointCount - begin);
+        const size_t vectorEnd = count / pidf_simd_t::WIDTH * pidf_simd_t::WIDTH;
+        for (size_t ii = 0; ii < vectorEnd; ii += pidf_simd_t::WIDTH) {
+            calculateLanes<pidf_simd_t>(pid, begin + ii, ii, batch);
+        }
+        for (size_t ii = vectorEnd; ii < count; ++ii) {
+            calculateLanes<pidf_simd_scalar_t>(pid, begin + ii, ii, batch);
+        }
+        for (size_t ii = 0; ii < count; ++ii) {
+            const size_t index = begin + ii;
+            const float re = batch.loopRe[ii];
+            const float im = batch.loopIm[ii];
+            const float magnitudeSquared = re*re + im*im;
+            const float closedLoop = batch.closedLoop[ii];
+            if (batch.returnDifference[ii] < minReturnDifference) {
+                minReturnDifference = batch.returnDifference[ii];
+                margins.sensitivityPeakFrequency = _frequencies[index];
+            }
+            if (index == 0) {
+                closedLoopHalf = 0.5F*closedLoop;
+            } else {
+                if ((previousMagnitudeSquared >= 1.0F) != (magnitudeSquared >= 1.0F)) {
+                    const float previousMagnitude = std::sqrt(previousMagnitudeSquared);
+                    const float t = (1.0F - previousMagnitude)/(std::sqrt(magnitudeSquared) - previousMagnitude);
+                    const float phaseMargin = RADIANS_TO_DEGREES*std::atan2(-(previousIm + t*(im - previousIm)), -(previousRe + t*(re - previousRe)));
+                    if (phaseMargin < margins.phaseMargin) {
+                        margins.phaseMargin = phaseMargin;
+                        margins.gainCrossoverFrequency = interpolate(index - 1, t);
+                    }
+                }
+                if ((previousIm < 0.0F && im >= 0.0F) || (previousIm > 0.0F && im <= 0.0F)) {
+                    const float t = previousIm/(previousIm - im);
+                    const float crossing = previousRe + t*(re - previousRe);
+                    if (crossing < 0.0F && -1.0F/crossing < margins.gainMargin) {
+                        margins.gainMargin = -1.0F/crossing;
+                        margins.gainMarginFrequency = interpolate(index - 1, t);
+                    }
+                }
+                if (margins.bandwidth < 0.0F && closedLoop < closedLoopHalf) {
+                    const float t = (previousClosedLoop - closedLoopHalf)/(previousClosedLoop - closedLoop);
+                    margins.bandwidth = interpolate(index - 1, t);
+                }
+            }
+            previousRe = re;
+            previousIm = im;
+            previousMagnitudeSquared = magnitudeSquared;
+            previousClosedLoop = closedLoop;
+        }
+    }
+    margins.sensitivityPeak = 1.0F/std::sqrt(minReturnDifference);
+    return margins;
+}
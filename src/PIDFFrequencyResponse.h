@@ -0,0 +1,146 @@
+# pragma once
+
+#include "PIDF.h"
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+/*!
+Continuous-time plant transfer function, numerator(s)/denominator(s)*exp(-delay*s), for PIDFFrequencyResponse.
+
+The polynomials are given lowest order first, eg the FOPDT plant gain/(timeConstant*s + 1) has numerator { gain } and
+denominator { 1, timeConstant }.
+*/
+struct PIDFTransferFunction {
+    enum { MAX_ORDER = 4 };
+    std::array<float, MAX_ORDER + 1> numerator; //!< coefficients of s^0, s^1, ...
+    std::array<float, MAX_ORDER + 1> denominator;
+    float delay; //!< dead time, in seconds
+
+    //! Response at s = j*omega, omega in rad/s.
+    std::complex<double> operator()(double omega) const;
+
+    //! gain*exp(-delay*s)/(timeConstant*s + 1), as PIDFPlantFOPDT
+    static PIDFTransferFunction fopdt(float gain, float timeConstant, float delay = 0.0F);
+    //! gain*exp(-delay*s)/s, as PIDFPlantIntegrating
+    static PIDFTransferFunction integrating(float gain, float delay = 0.0F);
+    //! gain*omega^2*exp(-delay*s)/(s^2 + 2*zeta*omega*s + omega^2), as PIDFPlantSecondOrder
+    static PIDFTransferFunction secondOrder(float gain, float naturalFrequency, float dampingRatio, float delay = 0.0F);
+};
+
+/*!
+Host-side frequency-response and stability-margin analysis of a PIDF controller against a plant model, without
+a time-domain simulation.
+
+The controller is the discrete-time fixed-rate `PIDF::update`, with sample time deltaT, and the setpoint set by
+`setSetpoint(setpoint, deltaT)` before each update. Its feedback (measurement) and setpoint paths are
+
+    C(z) = kp + ki*T/(1 - z^-1) + kd*(1 - z^-1)/T
+    F(z) = kp + ki*T/(1 - z^-1) + ks + kk*(1 - z^-1)/T
+
+so the loop gain is L = C*P, the sensitivity is S = 1/(1 + L), and the closed-loop setpoint response is P*F/(1 + L).
+The margins depend only on kp, ki, and kd, but the bandwidth also depends on ks and kk.
+The integral limit and output saturation are nonlinear, so are not included.
+
+The response is evaluated on a grid of log-spaced frequencies, fixed by the constructor, up to the Nyquist frequency pi/deltaT.
+The controller and plant responses at the grid points are precomputed, so analyze() is a handful of multiply-adds per
+point, calculated in batches with the PIDFSimd vector operations, followed by a scan for the crossings. Crossings are
+linearly interpolated between grid points. analyze() does not allocate and does not modify the object, so it can be called
+concurrently, eg from a PIDFOptimizer cost function.
+
+The plant is set either as a continuous-time response (eg a PIDFTransferFunction), which is combined with the response of
+the zero-order hold, (1 - exp(-j*omega*T))/(j*omega*T), or as a discrete-time response, a function of z^-1. The zero-order hold
+response ignores aliasing, so is accurate well below the Nyquist frequency: for an exact gain margin close to the Nyquist
+frequency use a discrete plant. The PIDFSimulation plants are discrete: eg PIDFPlantFOPDT<D>, as seen by the controller in
+PIDFSimulation::run (which measures the plant output of the previous step), is gain*alpha*z^-(D + 1)/(1 - (1 - alpha)*z^-1).
+
+The margins use the simplified Nyquist criterion, so assume the plant is stable, or has only integrators, and that the
+loop gain is large at low frequency and small at high frequency.
+*/
+class PIDFFrequencyResponse {
+public:
+    struct margins_t {
+        float gainMargin; //!< factor the loop gain can be multiplied by before instability, infinity if the phase never crosses -180 degrees
+        float gainMarginFrequency; //!< frequency at which the phase crosses -180 degrees, in rad/s, negative if it never does
+        float phaseMargin; //!< in degrees, infinity if the loop gain never crosses 1
+        float gainCrossoverFrequency; //!< frequency at which the loop gain crosses 1, in rad/s, negative if it never does
+        float sensitivityPeak; //!< Ms, the maximum of |S|, the reciprocal of the closest distance of the loop gain to -1
+        float sensitivityPeakFrequency; //!< in rad/s
+        float bandwidth; //!< frequency at which the closed-loop setpoint response is 3dB below its lowest frequency value, in rad/s, negative if it never is
+    };
+    enum { BATCH_SIZE = 64 }; //!< grid points calculated at a time, before scanning for crossings
+    static constexpr double PI = 3.14159265358979323846;
+public:
+    //! Grid of pointCount frequencies from minFrequency to maxFrequency, in rad/s, log-spaced. maxFrequency is limited to pi/deltaT.
+    PIDFFrequencyResponse(float deltaT, float minFrequency, float maxFrequency, size_t pointCount);
+    ~PIDFFrequencyResponse();
+    PIDFFrequencyResponse(const PIDFFrequencyResponse&) = default;
+    PIDFFrequencyResponse& operator=(const PIDFFrequencyResponse&) = default;
+    PIDFFrequencyResponse(PIDFFrequencyResponse&&) = default;
+    PIDFFrequencyResponse& operator=(PIDFFrequencyResponse&&) = default;
+
+    //! Set the plant from its continuous-time response, response(omega) returning a std::complex<double>, omega in rad/s.
+    template <typename F>
+    void setPlant(F&& response);
+    //! Set the plant from its discrete-time response, response(zInverse) returning a std::complex<double>.
+    template <typename F>
+    void setDiscretePlant(F&& response);
+
+    //! Calculate the margins, crossover frequencies, sensitivity peak, and bandwidth for the gains.
+    margins_t analyze(const PIDF::PIDF_t& pid) const;
+
+    //! Loop gain, L = C*P, at grid point index, eg for a Bode or Nyquist plot.
+    std::complex<float> getLoopGain(const PIDF::PIDF_t& pid, size_t index) const;
+    inline float getFrequency(size_t index) const { return _frequencies[index]; }
+    inline size_t getPointCount() const { return _frequencies.size(); }
+    inline float getSampleTime() const { return _deltaT; }
+private:
+    struct batch_t {
+        std::array<float, BATCH_SIZE> loopRe;
+        std::array<float, BATCH_SIZE> loopIm;
+        std::array<float, BATCH_SIZE> returnDifference; //!< |1 + L|^2
+        std::array<float, BATCH_SIZE> closedLoop; //!< |P*F/(1 + L)|^2
+    };
+    template <typename S>
+    void calculateLanes(const PIDF::PIDF_t& pid, size_t index, size_t lane, batch_t& batch) const;
+    double frequency(size_t index) const;
+    std::complex<double> zInverse(size_t index) const;
+    std::complex<double> zeroOrderHold(size_t index) const;
+    inline void setPlantPoint(size_t index, std::complex<double> response) {
+        _plantRe[index] = static_cast<float>(response.real());
+        _plantIm[index] = static_cast<float>(response.imag());
+        _plantMagnitudeSquared[index] = static_cast<float>(std::norm(response));
+    }
+private:
+    double _minFrequency;
+    double _logStep; //!< log of the ratio of adjacent grid frequencies
+    bool _maxIsNyquist;
+    std::array<uint8_t, 3> _unused {};
+    float _deltaT;
+    std::vector<float> _frequencies;
+    // precomputed responses at each grid point, as separate real and imaginary arrays for the vector calculation
+    std::vector<float> _integralRe; //!< T/(1 - z^-1)
+    std::vector<float> _integralIm;
+    std::vector<float> _derivativeRe; //!< (1 - z^-1)/T
+    std::vector<float> _derivativeIm;
+    std::vector<float> _plantRe;
+    std::vector<float> _plantIm;
+    std::vector<float> _plantMagnitudeSquared;
+};
+
+template <typename F>
+void PIDFFrequencyResponse::setPlant(F&& response)
+{
+    for (size_t ii = 0; ii < _frequencies.size(); ++ii) {
+        setPlantPoint(ii, response(frequency(ii))*zeroOrderHold(ii));
+    }
+}
+
+template <typename F>
+void PIDFFrequencyResponse::setDiscretePlant(F&& response)
+{
+    for (size_t ii = 0; ii < _frequencies.size(); ++ii) {
+        setPlantPoint(ii, response(zInverse(ii)));
+    }
+}
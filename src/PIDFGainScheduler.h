@@ -0,0 +1,109 @@
+# pragma once
+
+#include "PIDFT.h"
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+/*!
+Gain scheduler: a table of N sets of PID gains at uniformly spaced breakpoints of an operating point variable
+(eg throttle, airspeed, or battery voltage), with linear interpolation between the breakpoints.
+
+Since the breakpoints are uniformly spaced, the table index is calculated directly by multiplying by the reciprocal
+of the breakpoint spacing, so a lookup has no search and no division. The difference between each entry and the next is
+precomputed, so the interpolation is one multiply-add per gain.
+
+Operating points outside the table range use the first or last entry.
+
+The interpolated gains are applied with `setScheduledPID`, which leaves the integral, and whether integration is switched on, unchanged.
+The gains and operating point are of type T, which must be the value type of the controllers, eg double for PIDFDouble.
+*/
+template <size_t N, typename T = float>
+class PIDFGainScheduler {
+public:
+    static_assert(N >= 2, "gain scheduler requires at least two breakpoints");
+    using value_type = T;
+    using PIDF_t = typename PIDFBaseT<T>::PIDF_t;
+public:
+    PIDFGainScheduler(T inputMin, T inputMax, const std::array<PIDF_t, N>& table) : _table(table) {
+        setInputRange(inputMin, inputMax);
+        updateDeltas();
+    }
+public:
+    //! Sets the operating point of the first and last breakpoints, the other breakpoints are evenly spaced between them.
+    inline void setInputRange(T inputMin, T inputMax) {
+        _inputMin = inputMin;
+        _inputStep = (inputMax - inputMin) / static_cast<T>(N - 1);
+        _inputStepReciprocal = T(1) / _inputStep;
+    }
+    inline T getInputMin() const { return _inputMin; }
+    inline T getInputMax() const { return _inputMin + _inputStep*static_cast<T>(N - 1); }
+
+    inline void setEntry(size_t index, const PIDF_t& pid) {
+        _table[index] = pid;
+        if (index > 0) {
+            _deltas[index - 1] = difference(_table[index], _table[index - 1]);
+        }
+        if (index < N - 1) {
+            _deltas[index] = difference(_table[index + 1], _table[index]);
+        }
+    }
+    inline const PIDF_t& getEntry(size_t index) const { return _table[index]; }
+    inline size_t size() const { return N; }
+
+    //! Returns the gains at the given operating point, interpolated between the two nearest breakpoints.
+    PIDF_t lookup(T input) const {
+        T position = (input - _inputMin) * _inputStepReciprocal;
+        // clamp to the table, fmax also maps a NaN input to the first entry
+        position = std::fmin(std::fmax(position, T(0)), static_cast<T>(N - 1));
+        const auto index = static_cast<size_t>(position);
+        const T fraction = position - static_cast<T>(index);
+        // the last delta is zero, so an input at or above inputMax needs no special case
+        const PIDF_t& pid = _table[index];
+        const PIDF_t& delta = _deltas[index];
+        return PIDF_t {
+            pid.kp + delta.kp*fraction,
+            pid.ki + delta.ki*fraction,
+            pid.kd + delta.kd*fraction,
+            pid.ks + delta.ks*fraction,
+            pid.kk + delta.kk*fraction
+        };
+    }
+
+    /*!
+    Looks up the gains at the given operating point and applies them to each of the controllers, without changing
+    their integrals or whether integration is switched on. Controllers may be PIDF or any PIDFT.
+    Returns the applied gains.
+    */
+    template <typename... Controllers>
+    PIDF_t apply(T input, Controllers&... controllers) const {
+        const PIDF_t pid = lookup(input);
+        (controllers.setScheduledPID(pid), ...);
+        return pid;
+    }
+    //! Applies the gains at the given operating point to an array of count controllers.
+    template <typename Controller>
+    PIDF_t applyToArray(T input, Controller* controllers, size_t count) const {
+        const PIDF_t pid = lookup(input);
+        for (size_t ii = 0; ii < count; ++ii) {
+            controllers[ii].setScheduledPID(pid);
+        }
+        return pid;
+    }
+private:
+    static inline PIDF_t difference(const PIDF_t& a, const PIDF_t& b) {
+        return PIDF_t { a.kp - b.kp, a.ki - b.ki, a.kd - b.kd, a.ks - b.ks, a.kk - b.kk };
+    }
+    inline void updateDeltas() {
+        for (size_t ii = 0; ii < N - 1; ++ii) {
+            _deltas[ii] = difference(_table[ii + 1], _table[ii]);
+        }
+        _deltas[N - 1] = PIDF_t {};
+    }
+private:
+    std::array<PIDF_t, N> _table;
+    std::array<PIDF_t, N> _deltas {}; //!< _deltas[ii] = _table[ii+1] - _table[ii], with the last entry zero
+    T _inputMin {0};
+    T _inputStep {0};
+    T _inputStepReciprocal {0};
+};
@@ -0,0 +1,152 @@
+# pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if defined(PIDF_CYCLE_COUNTER)
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(__linux__) || defined(__APPLE__)
+#include <ctime>
+#endif
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__)
+#define PIDF_DWT_CYCLE_COUNTER
+#endif
+
+/*!
+Free-running 32-bit cycle counter, used to time updates. Differences are taken modulo 2^32, so intervals of up to 2^32 counts
+(eg 4 seconds at 1GHz) are measured correctly.
+
+Uses the DWT cycle counter on ARM Cortex-M3/M4/M7/M33 (which must be enabled with PIDFInstrumentation::enableCycleCounter),
+the time stamp counter on x86, and clock_gettime (in nanoseconds) on other Linux targets.
+Define PIDF_CYCLE_COUNTER() as an expression returning a uint32_t counter to use another counter.
+*/
+inline uint32_t pidfCycleCount()
+{
+#if defined(PIDF_CYCLE_COUNTER)
+    return PIDF_CYCLE_COUNTER();
+#elif defined(PIDF_DWT_CYCLE_COUNTER)
+    return *reinterpret_cast<volatile uint32_t*>(0xE0001004U); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr) DWT_CYCCNT
+#elif defined(__x86_64__) || defined(__i386__)
+    return static_cast<uint32_t>(__rdtsc());
+#elif defined(__linux__) || defined(__APPLE__)
+    timespec time {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<uint32_t>(static_cast<uint64_t>(time.tv_sec)*1000000000U + static_cast<uint64_t>(time.tv_nsec));
+#else
+    return 0;
+#endif
+}
+
+/*!
+Loop timing instrumentation for a controller, in cycle counter counts.
+
+When a PIDFT with the PIDFTerms::INSTRUMENTATION flag (or PIDF built with USE_PIDF_INSTRUMENTATION defined) has an
+instrumentation object set, using setInstrumentation, each update records:
+
+1. the number of counts taken by the update, as the minimum, maximum, and total (for the mean)
+2. the number of overruns, ie updates that took longer than the update budget
+3. the interval between the starts of successive updates (the actual deltaT), as the minimum and maximum, and in a histogram
+
+The histogram has BIN_COUNT bins covering [period - jitterRange, period + jitterRange), with intervals outside the range
+counted in the first or last bin. The bin is calculated using a precomputed multiplier, so recording has no division.
+All the counters are fixed size, so there is no allocation. Each controller needs its own instrumentation object.
+
+When the flag is not set, the update functions contain no instrumentation code and the controller has no instrumentation
+storage, so disabled instrumentation costs nothing.
+*/
+class PIDFInstrumentation {
+public:
+    enum { BIN_COUNT = 16 };
+    using histogram_t = std::array<uint32_t, BIN_COUNT>;
+public:
+    PIDFInstrumentation(uint32_t period, uint32_t jitterRange, uint32_t updateBudget) { setPeriod(period, jitterRange, updateBudget); }
+public:
+    //! Enable the DWT cycle counter, on ARM Cortex-M targets that have one. Does nothing on other targets.
+    static void enableCycleCounter() {
+#if defined(PIDF_DWT_CYCLE_COUNTER) && !defined(PIDF_CYCLE_COUNTER)
+        *reinterpret_cast<volatile uint32_t*>(0xE000EDFCU) |= (1U << 24U); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr) DEMCR TRCENA
+        *reinterpret_cast<volatile uint32_t*>(0xE0001FB0U) = 0xC5ACCE55U; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr) DWT_LAR unlock, needed on Cortex-M7
+        *reinterpret_cast<volatile uint32_t*>(0xE0001004U) = 0; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr) DWT_CYCCNT
+        *reinterpret_cast<volatile uint32_t*>(0xE0001000U) |= 1U; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr) DWT_CTRL CYCCNTENA
+#endif
+    }
+
+    //! Set the nominal update period, the histogram range either side of it, and the update budget, in counts. Resets the counters.
+    void setPeriod(uint32_t period, uint32_t jitterRange, uint32_t updateBudget) {
+        _period = period;
+        _histogramLow = period > jitterRange ? period - jitterRange : 0;
+        // rounded up, so that intervals on a bin boundary are not put in the bin below
+        const uint64_t range = 2U*static_cast<uint64_t>(jitterRange);
+        _histogramRange = range;
+        _binMultiplier = jitterRange == 0 ? 0 : ((static_cast<uint64_t>(BIN_COUNT) << 32U) + range - 1) / range;
+        _updateBudget = updateBudget;
+        reset();
+    }
+    void reset() {
+        _histogram = {};
+        _updateCount = 0;
+        _overrunCount = 0;
+        _updateCountsMin = UINT32_MAX;
+        _updateCountsMax = 0;
+        _updateCountsTotal = 0;
+        _intervalMin = UINT32_MAX;
+        _intervalMax = 0;
+        _startPrevious = 0;
+    }
+
+    //! Record an update that started and ended at the given counter values.
+    inline void record(uint32_t start, uint32_t end) {
+        const uint32_t counts = end - start;
+        _updateCountsTotal += counts;
+        _updateCountsMin = counts < _updateCountsMin ? counts : _updateCountsMin;
+        _updateCountsMax = counts > _updateCountsMax ? counts : _updateCountsMax;
+        _overrunCount += (counts > _updateBudget) ? 1U : 0U;
+        if (_updateCount != 0) {
+            const uint32_t interval = start - _startPrevious;
+            _intervalMin = interval < _intervalMin ? interval : _intervalMin;
+            _intervalMax = interval > _intervalMax ? interval : _intervalMax;
+            // clamped to the histogram range, so the multiplication cannot overflow when jitterRange is small
+            uint64_t offset = interval > _histogramLow ? interval - _histogramLow : 0U;
+            offset = offset < _histogramRange ? offset : _histogramRange;
+            const uint64_t bin = (offset*_binMultiplier) >> 32U;
+            ++_histogram[bin < BIN_COUNT ? bin : BIN_COUNT - 1];
+        }
+        _startPrevious = start;
+        ++_updateCount;
+    }
+
+    inline uint32_t getPeriod() const { return _period; }
+    inline uint32_t getUpdateBudget() const { return _updateBudget; }
+    inline uint32_t getUpdateCount() const { return _updateCount; }
+    inline uint32_t getOverrunCount() const { return _overrunCount; }
+    inline uint32_t getUpdateCountsMin() const { return _updateCount == 0 ? 0 : _updateCountsMin; }
+    inline uint32_t getUpdateCountsMax() const { return _updateCountsMax; }
+    inline uint64_t getUpdateCountsTotal() const { return _updateCountsTotal; }
+    inline float getUpdateCountsMean() const { return _updateCount == 0 ? 0.0F : static_cast<float>(_updateCountsTotal) / static_cast<float>(_updateCount); }
+    //! Fraction of the period taken by the mean update.
+    inline float getLoad() const { return _period == 0 ? 0.0F : getUpdateCountsMean() / static_cast<float>(_period); }
+    inline uint32_t getIntervalMin() const { return _updateCount < 2 ? 0 : _intervalMin; }
+    inline uint32_t getIntervalMax() const { return _intervalMax; }
+    inline const histogram_t& getHistogram() const { return _histogram; }
+    //! The lower bound of a histogram bin, in counts.
+    inline uint32_t getBinStart(size_t bin) const {
+        return _binMultiplier == 0 ? _histogramLow : _histogramLow + static_cast<uint32_t>(((static_cast<uint64_t>(bin) << 32U) + _binMultiplier - 1) / _binMultiplier);
+    }
+private:
+    uint64_t _binMultiplier {0}; //!< BIN_COUNT*2^32/(2*jitterRange)
+    uint64_t _histogramRange {0}; //!< 2*jitterRange
+    uint64_t _updateCountsTotal {0};
+    histogram_t _histogram {};
+    uint32_t _period {0};
+    uint32_t _histogramLow {0};
+    uint32_t _updateBudget {0};
+    uint32_t _updateCount {0};
+    uint32_t _overrunCount {0};
+    uint32_t _updateCountsMin {UINT32_MAX};
+    uint32_t _updateCountsMax {0};
+    uint32_t _intervalMin {UINT32_MAX};
+    uint32_t _intervalMax {0};
+    uint32_t _startPrevious {0};
+};
@@ -0,0 +1,507 @@
+# pragma once
+
+#include "PIDF.h"
+#include "PIDFSimulation.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+Host-side (ie not for the controller itself) gain optimization, using the PIDFSimulation plant models.
+
+The candidate gain sets are evaluated in parallel on every core. The cost function is called concurrently from the
+worker threads, so must not modify shared state. PIDFSimulationCost is a cost function that simulates each candidate
+against a set of scenarios, without allocating.
+*/
+
+/*!
+Work-stealing thread pool, for running the iterations of a loop on every core.
+
+Each worker owns a contiguous range of the iterations and takes batches from the front of it. A worker whose range is
+empty steals the back half of another worker's range. Each range is held in a single 64-bit atomic (begin and end),
+so taking a batch and stealing are both lock-free compare-and-swaps. The calling thread takes part as worker 0.
+Running a loop does not allocate.
+*/
+class PIDFWorkStealingPool {
+public:
+    //! threadCount of 0 uses one thread per core
+    explicit PIDFWorkStealingPool(size_t threadCount = 0) :
+        _threadCount(threadCount != 0 ? threadCount : std::max(1U, std::thread::hardware_concurrency())),
+        _ranges(new range_t[_threadCount]) // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+    {
+        _threads.reserve(_threadCount - 1);
+        for (size_t ii = 1; ii < _threadCount; ++ii) {
+            _threads.emplace_back([this, ii]() { workerLoop(ii); });
+        }
+    }
+    ~PIDFWorkStealingPool() {
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _startCondition.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+    PIDFWorkStealingPool(const PIDFWorkStealingPool&) = delete;
+    PIDFWorkStealingPool& operator=(const PIDFWorkStealingPool&) = delete;
+    PIDFWorkStealingPool(PIDFWorkStealingPool&&) = delete;
+    PIDFWorkStealingPool& operator=(PIDFWorkStealingPool&&) = delete;
+public:
+    //! Maximum number of indices in one pass, small enough that begin + batchSize cannot overflow the 32 bit range indices.
+    static constexpr size_t MAX_PASS_COUNT = 0x7FFFFFFF;
+public:
+    size_t getThreadCount() const { return _threadCount; }
+    /*!
+    Call body(index, workerIndex) for each index in [0, count), in parallel, and wait for all the calls to complete.
+    Each worker takes batchSize indices at a time.
+    The workers' ranges are packed into 32 bits each, so a count larger than MAX_PASS_COUNT is run as several passes.
+    */
+    template <typename F>
+    void parallelFor(size_t count, size_t batchSize, F& body);
+private:
+    static uint64_t pack(uint32_t begin, uint32_t end) { return (static_cast<uint64_t>(end) << 32U) | begin; }
+    template <typename F>
+    static void invoke(void* context, size_t index, size_t worker) { (*static_cast<F*>(context))(index, worker); }
+    bool takeBatch(size_t worker, uint32_t& begin, uint32_t& end);
+    bool steal(size_t worker);
+    void run(size_t worker);
+    void workerLoop(size_t worker);
+private:
+    // one per cache line, so workers do not contend
+    struct alignas(64) range_t {
+        std::atomic<uint64_t> range {0};
+        std::array<uint8_t, 64 - sizeof(std::atomic<uint64_t>)> _unused {};
+    };
+    size_t _threadCount;
+    std::unique_ptr<range_t[]> _ranges; // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _startCondition;
+    std::condition_variable _doneCondition;
+    uint64_t _generation {0}; //!< incremented to start the workers on a loop
+    size_t _busyCount {0}; //!< number of workers, other than worker 0, still running the loop
+    void (*_invoke)(void*, size_t, size_t) {nullptr};
+    void* _context {nullptr};
+    size_t _offset {0}; //!< index of the first iteration of the current pass
+    uint32_t _batchSize {1};
+    bool _stop {false};
+    std::array<uint8_t, 3> _unused {};
+};
+
+template <typename F>
+void PIDFWorkStealingPool::parallelFor(size_t count, size_t batchSize, F& body)
+{
+    _invoke = &invoke<F>;
+    _context = &body;
+    _batchSize = static_cast<uint32_t>(std::min(std::max(batchSize, static_cast<size_t>(1)), MAX_PASS_COUNT));
+    for (size_t offset = 0; offset < count; offset += MAX_PASS_COUNT) {
+        // the pass count fits in 32 bits, so the ranges are not truncated
+        const size_t passCount = std::min(count - offset, MAX_PASS_COUNT);
+        // initially the iterations are divided evenly between the workers
+        for (size_t ii = 0; ii < _threadCount; ++ii) {
+            _ranges[ii].range.store(pack(static_cast<uint32_t>(passCount*ii/_threadCount), static_cast<uint32_t>(passCount*(ii + 1)/_threadCount)), std::memory_order_relaxed);
+        }
+        _offset = offset;
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            _busyCount = _threadCount - 1;
+            ++_generation;
+        }
+        _startCondition.notify_all();
+        run(0);
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCondition.wait(lock, [this]() { return _busyCount == 0; });
+    }
+}
+
+inline bool PIDFWorkStealingPool::takeBatch(size_t worker, uint32_t& begin, uint32_t& end)
+{
+    std::atomic<uint64_t>& range = _ranges[worker].range;
+    uint64_t value = range.load(std::memory_order_acquire);
+    for (;;) {
+        begin = static_cast<uint32_t>(value);
+        const auto rangeEnd = static_cast<uint32_t>(value >> 32U);
+        if (begin >= rangeEnd) {
+            return false;
+        }
+        end = std::min(begin + _batchSize, rangeEnd);
+        if (range.compare_exchange_weak(value, pack(end, rangeEnd), std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+}
+
+inline bool PIDFWorkStealingPool::steal(size_t worker)
+{
+    for (size_t ii = 1; ii < _threadCount; ++ii) {
+        std::atomic<uint64_t>& victim = _ranges[(worker + ii) % _threadCount].range;
+        uint64_t value = victim.load(std::memory_order_acquire);
+        for (;;) {
+            const auto begin = static_cast<uint32_t>(value);
+            const auto end = static_cast<uint32_t>(value >> 32U);
+            if (begin >= end) {
+                break;
+            }
+            const uint32_t middle = begin + (end - begin)/2;
+            if (victim.compare_exchange_weak(value, pack(begin, middle), std::memory_order_acq_rel)) {
+                // this worker's range is empty, so no other worker can take from it until it is replaced
+                _ranges[worker].range.store(pack(middle, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+inline void PIDFWorkStealingPool::run(size_t worker)
+{
+    uint32_t begin {};
+    uint32_t end {};
+    for (;;) {
+        while (takeBatch(worker, begin, end)) {
+            for (uint32_t ii = begin; ii < end; ++ii) {
+                _invoke(_context, _offset + ii, worker);
+            }
+        }
+        if (!steal(worker)) {
+            return;
+        }
+    }
+}
+
+inline void PIDFWorkStealingPool::workerLoop(size_t worker)
+{
+    uint64_t generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _startCondition.wait(lock, [this, generation]() { return _stop || _generation != generation; });
+            if (_stop) {
+                return;
+            }
+            generation = _generation;
+        }
+        run(worker);
+        const std::lock_guard<std::mutex> lock(_mutex);
+        --_busyCount;
+        if (_busyCount == 0) {
+            _doneCondition.notify_one();
+        }
+    }
+}
+
+
+/*!
+Gain optimizer: grid search, random search, and multi-start Nelder-Mead, over kp, ki, kd, ks, kk, the integral limit,
+and the output saturation value.
+
+The search space is given by minimum and maximum candidates, and a parameter with equal minimum and maximum is held fixed.
+All searches return their results ranked by cost, lowest first.
+*/
+class PIDFOptimizer {
+public:
+    enum { PARAMETER_COUNT = 7 };
+    struct candidate_t {
+        PIDF::PIDF_t pid;
+        float integralLimit; //!< 0 for no limit
+        float outputSaturationValue; //!< 0 for no output saturation limit
+    };
+    struct result_t {
+        candidate_t candidate;
+        float cost;
+    };
+    typedef std::array<float, PARAMETER_COUNT> parameters_t;
+    enum { BATCH_SIZE = 8 }; //!< candidates taken by a worker at a time
+public:
+    explicit PIDFOptimizer(size_t threadCount = 0) : _pool(threadCount) {}
+    size_t getThreadCount() const { return _pool.getThreadCount(); }
+
+    //! Evaluate count candidates in parallel, results[ii] is set to candidates[ii] and its cost. Results are not ranked.
+    template <typename COST>
+    void evaluate(const candidate_t* candidates, size_t count, COST& cost, result_t* results);
+
+    //! Search a grid with steps[ii] values of each parameter, evenly spaced from minimum to maximum inclusive.
+    template <typename COST>
+    std::vector<result_t> grid(const candidate_t& minimum, const candidate_t& maximum, const std::array<uint32_t, PARAMETER_COUNT>& steps, COST& cost);
+
+    //! Search count candidates drawn uniformly from the space. The candidates depend only on the seed, not the thread count.
+    template <typename COST>
+    std::vector<result_t> random(const candidate_t& minimum, const candidate_t& maximum, size_t count, uint32_t seed, COST& cost);
+
+    /*!
+    Run a Nelder-Mead simplex search from each of the starting candidates, in parallel, and return the best candidate found
+    by each search. Each search is limited to the space, and stops after maxEvaluations calls to cost.
+    The starting candidates can be, for example, the best results of a random search.
+    */
+    template <typename COST>
+    std::vector<result_t> nelderMead(const candidate_t& minimum, const candidate_t& maximum, const std::vector<candidate_t>& starts, size_t maxEvaluations, COST& cost);
+
+    static void rank(std::vector<result_t>& results);
+    //! Print the first count results as a table.
+    static void report(FILE* file, const std::vector<result_t>& results, size_t count);
+
+    static parameters_t toParameters(const candidate_t& candidate) {
+        return parameters_t {{ candidate.pid.kp, candidate.pid.ki, candidate.pid.kd, candidate.pid.ks, candidate.pid.kk, candidate.integralLimit, candidate.outputSaturationValue }};
+    }
+    static candidate_t toCandidate(const parameters_t& p) {
+        return candidate_t { PIDF::PIDF_t { p[0], p[1], p[2], p[3], p[4] }, p[5], p[6] };
+    }
+private:
+    //! Candidate at position[ii] in [0, 1] along each parameter.
+    static candidate_t interpolate(const parameters_t& minimum, const parameters_t& maximum, const parameters_t& position);
+    template <typename COST>
+    static result_t nelderMeadSearch(const parameters_t& minimum, const parameters_t& maximum, const candidate_t& start, size_t maxEvaluations, COST& cost);
+private:
+    PIDFWorkStealingPool _pool;
+};
+
+template <typename COST>
+void PIDFOptimizer::evaluate(const candidate_t* candidates, size_t count, COST& cost, result_t* results)
+{
+    auto body = [candidates, results, &cost](size_t index, size_t) {
+        results[index] = result_t { candidates[index], cost(candidates[index]) };
+    };
+    _pool.parallelFor(count, BATCH_SIZE, body);
+}
+
+template <typename COST>
+std::vector<PIDFOptimizer::result_t> PIDFOptimizer::grid(const candidate_t& minimum, const candidate_t& maximum, const std::array<uint32_t, PARAMETER_COUNT>& steps, COST& cost)
+{
+    size_t count = 1;
+    for (const uint32_t step : steps) {
+        count *= std::max(step, 1U);
+    }
+    const parameters_t lo = toParameters(minimum);
+    const parameters_t hi = toParameters(maximum);
+    std::vector<result_t> results(count);
+    // each candidate is generated from its index by the worker that evaluates it, so the candidates are not stored separately
+    auto body = [&lo, &hi, &steps, &cost, &results](size_t index, size_t) {
+        parameters_t position {};
+        size_t remainder = index;
+        for (size_t ii = 0; ii < PARAMETER_COUNT; ++ii) {
+            const uint32_t step = std::max(steps[ii], 1U);
+            position[ii] = (step == 1) ? 0.0F : static_cast<float>(remainder % step) / static_cast<float>(step - 1);
+            remainder /= step;
+        }
+        const candidate_t candidate = interpolate(lo, hi, position);
+        results[index] = result_t { candidate, cost(candidate) };
+    };
+    _pool.parallelFor(count, BATCH_SIZE, body);
+    rank(results);
+    return results;
+}
+
+template <typename COST>
+std::vector<PIDFOptimizer::result_t> PIDFOptimizer::random(const candidate_t& minimum, const candidate_t& maximum, size_t count, uint32_t seed, COST& cost)
+{
+    const parameters_t lo = toParameters(minimum);
+    const parameters_t hi = toParameters(maximum);
+    std::vector<result_t> results(count);
+    const uint64_t seed64 = static_cast<uint64_t>(seed) << 32U;
+    auto body = [&lo, &hi, seed64, &cost, &results](size_t index, size_t) {
+        // splitmix64, seeded by the index, so each candidate is independent of which worker evaluates it
+        uint64_t state = seed64 ^ index;
+        parameters_t position {};
+        for (float& p : position) {
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = state;
+            z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31U;
+            p = static_cast<float>(z >> 40U) * (1.0F / 16777216.0F);
+        }
+        const candidate_t candidate = interpolate(lo, hi, position);
+        results[index] = result_t { candidate, cost(candidate) };
+    };
+    _pool.parallelFor(count, BATCH_SIZE, body);
+    rank(results);
+    return results;
+}
+
+template <typename COST>
+std::vector<PIDFOptimizer::result_t> PIDFOptimizer::nelderMead(const candidate_t& minimum, const candidate_t& maximum, const std::vector<candidate_t>& starts, size_t maxEvaluations, COST& cost)
+{
+    const parameters_t lo = toParameters(minimum);
+    const parameters_t hi = toParameters(maximum);
+    std::vector<result_t> results(starts.size());
+    auto body = [&lo, &hi, &starts, maxEvaluations, &cost, &results](size_t index, size_t) {
+        results[index] = nelderMeadSearch(lo, hi, starts[index], maxEvaluations, cost);
+    };
+    _pool.parallelFor(starts.size(), 1, body); // each search is long, so the searches are taken one at a time
+    rank(results);
+    return results;
+}
+
+/*!
+Nelder-Mead search over the free parameters, with positions normalized to [0, 1], using the standard coefficients
+(reflection 1, expansion 2, contraction 0.5, shrink 0.5). The simplex is held in fixed-size arrays, so the search does not allocate.
+*/
+template <typename COST>
+PIDFOptimizer::result_t PIDFOptimizer::nelderMeadSearch(const parameters_t& minimum, const parameters_t& maximum, const candidate_t& start, size_t maxEvaluations, COST& cost)
+{
+    std::array<size_t, PARAMETER_COUNT> free {};
+    size_t n = 0;
+    const parameters_t startParameters = toParameters(start);
+    parameters_t origin {};
+    for (size_t ii = 0; ii < PARAMETER_COUNT; ++ii) {
+        const float range = maximum[ii] - minimum[ii];
+        origin[ii] = (range > 0.0F) ? std::clamp((startParameters[ii] - minimum[ii]) / range, 0.0F, 1.0F) : 0.0F;
+        if (range > 0.0F) {
+            free[n] = ii;
+            ++n;
+        }
+    }
+    std::array<parameters_t, PARAMETER_COUNT + 1> simplex {};
+    std::array<float, PARAMETER_COUNT + 1> costs {};
+    size_t evaluations = 0;
+    auto evaluatePoint = [&](parameters_t& position) {
+        for (float& p : position) {
+            p = std::clamp(p, 0.0F, 1.0F);
+        }
+        ++evaluations;
+        const float c = cost(interpolate(minimum, maximum, position));
+        return std::isfinite(c) ? c : FLT_MAX;
+    };
+    // initial simplex: the start, and a step of 0.1 (of the range) along each free parameter, away from the nearer bound
+    for (size_t ii = 0; ii <= n; ++ii) {
+        simplex[ii] = origin;
+        if (ii > 0) {
+            float& p = simplex[ii][free[ii - 1]];
+            p += (p > 0.9F) ? -0.1F : 0.1F;
+        }
+        costs[ii] = evaluatePoint(simplex[ii]);
+    }
+    while (n > 0 && evaluations < maxEvaluations) {
+        // order the simplex, best first
+        for (size_t ii = 1; ii <= n; ++ii) {
+            for (size_t jj = ii; jj > 0 && costs[jj] < costs[jj - 1]; --jj) {
+                std::swap(costs[jj], costs[jj - 1]);
+                std::swap(simplex[jj], simplex[jj - 1]);
+            }
+        }
+        parameters_t centroid {};
+        for (size_t ii = 0; ii < n; ++ii) {
+            for (size_t jj = 0; jj < n; ++jj) {
+                centroid[free[jj]] += simplex[ii][free[jj]] / static_cast<float>(n);
+            }
+        }
+        auto along = [&](float t) {
+            parameters_t position = simplex[0]; // fixed parameters are the same for all points
+            for (size_t jj = 0; jj < n; ++jj) {
+                const size_t k = free[jj];
+                position[k] = centroid[k] + t*(simplex[n][k] - centroid[k]);
+            }
+            return position;
+        };
+        parameters_t reflected = along(-1.0F);
+        const float reflectedCost = evaluatePoint(reflected);
+        if (reflectedCost < costs[0]) {
+            parameters_t expanded = along(-2.0F);
+            const float expandedCost = evaluatePoint(expanded);
+            if (expandedCost < reflectedCost) {
+                simplex[n] = expanded;
+                costs[n] = expandedCost;
+            } else {
+                simplex[n] = reflected;
+                costs[n] = reflectedCost;
+            }
+        } else if (reflectedCost < costs[n - 1]) {
+            simplex[n] = reflected;
+            costs[n] = reflectedCost;
+        } else {
+            parameters_t contracted = (reflectedCost < costs[n]) ? along(-0.5F) : along(0.5F);
+            const float contractedCost = evaluatePoint(contracted);
+            if (contractedCost < std::min(reflectedCost, costs[n])) {
+                simplex[n] = contracted;
+                costs[n] = contractedCost;
+            } else {
+                // shrink towards the best point
+                for (size_t ii = 1; ii <= n; ++ii) {
+                    for (size_t jj = 0; jj < n; ++jj) {
+                        const size_t k = free[jj];
+                        simplex[ii][k] = simplex[0][k] + 0.5F*(simplex[ii][k] - simplex[0][k]);
+                    }
+                    costs[ii] = evaluatePoint(simplex[ii]);
+                }
+            }
+        }
+    }
+    size_t best = 0;
+    for (size_t ii = 1; ii <= n; ++ii) {
+        if (costs[ii] < costs[best]) {
+            best = ii;
+        }
+    }
+    return result_t { interpolate(minimum, maximum, simplex[best]), costs[best] };
+}
+
+inline PIDFOptimizer::candidate_t PIDFOptimizer::interpolate(const parameters_t& minimum, const parameters_t& maximum, const parameters_t& position)
+{
+    parameters_t p {};
+    for (size_t ii = 0; ii < PARAMETER_COUNT; ++ii) {
+        p[ii] = minimum[ii] + position[ii]*(maximum[ii] - minimum[ii]);
+    }
+    return toCandidate(p);
+}
+
+inline void PIDFOptimizer::rank(std::vector<result_t>& results)
+{
+    std::stable_sort(results.begin(), results.end(), [](const result_t& a, const result_t& b) { return a.cost < b.cost; });
+}
+
+inline void PIDFOptimizer::report(FILE* file, const std::vector<result_t>& results, size_t count)
+{
+    std::fprintf(file, "%4s %12s %10s %10s %10s %10s %10s %10s %10s\n", "rank", "cost", "kp", "ki", "kd", "ks", "kk", "intLimit", "outSat");
+    for (size_t ii = 0; ii < std::min(count, results.size()); ++ii) {
+        const result_t& r = results[ii];
+        std::fprintf(file, "%4zu %12.6g %10.5g %10.5g %10.5g %10.5g %10.5g %10.5g %10.5g\n", ii + 1, static_cast<double>(r.cost),
+            static_cast<double>(r.candidate.pid.kp), static_cast<double>(r.candidate.pid.ki), static_cast<double>(r.candidate.pid.kd),
+            static_cast<double>(r.candidate.pid.ks), static_cast<double>(r.candidate.pid.kk),
+            static_cast<double>(r.candidate.integralLimit), static_cast<double>(r.candidate.outputSaturationValue));
+    }
+}
+
+
+/*!
+Cost function that simulates a candidate controlling a copy of plant through each of the scenarios, using the fixed-rate
+PIDF::update. The cost is the sum over the scenarios of ITAE + effortWeight*effort (the integral of the squared controller output).
+A candidate that makes the loop unstable has a cost of FLT_MAX.
+
+Each evaluation copies the plant and the controller onto the stack, so evaluations do not allocate and can run concurrently.
+*/
+template <typename PLANT, size_t SCENARIO_COUNT>
+class PIDFSimulationCost {
+public:
+    PIDFSimulationCost(const PLANT& plant, const std::array<PIDFSimulation::scenario_t, SCENARIO_COUNT>& simulationScenarios, float effortWeight) :
+        _plant(plant), _scenarios(simulationScenarios), _effortWeight(effortWeight) {}
+    float operator()(const PIDFOptimizer::candidate_t& candidate) const {
+        double cost = 0.0;
+        for (const PIDFSimulation::scenario_t& scenario : _scenarios) {
+            PLANT plant = _plant;
+            plant.reset();
+            PIDF pid(candidate.pid);
+            pid.setSampleTime(scenario.deltaT);
+            pid.setIntegralLimit(candidate.integralLimit);
+            pid.setOutputSaturationValue(candidate.outputSaturationValue);
+            const PIDFSimulation::metrics_t metrics = PIDFSimulation::run(plant, scenario, [&pid, &scenario](float setpoint, float measurement) {
+                pid.setSetpoint(setpoint, scenario.deltaT);
+                return pid.update(measurement);
+            });
+            cost += metrics.itae + static_cast<double>(_effortWeight)*metrics.effort;
+        }
+        return (std::isfinite(cost) && cost < static_cast<double>(FLT_MAX)) ? static_cast<float>(cost) : FLT_MAX;
+    }
+private:
+    PLANT _plant;
+    std::array<PIDFSimulation::scenario_t, SCENARIO_COUNT> _scenarios;
+    float _effortWeight;
+};
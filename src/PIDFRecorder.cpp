@@ -0,0 +1,163 @@
+#include "PIDFRecorder.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr float INT16_LIMIT = 32767.0F;
+constexpr float INT8_LIMIT = 127.0F;
+constexpr float INT32_LIMIT = 1.0e9F; // limit for the quantized value of a DELTA field, well within int32_t range
+
+inline int32_t quantize(float value, float scale, float limit)
+{
+    // fmax also maps NaN to -limit
+    return static_cast<int32_t>(std::lrintf(std::fmin(std::fmax(value*scale, -limit), limit)));
+}
+} // end namespace
+
+
+PIDFRecorder::PIDFRecorder(uint8_t* buffer, size_t bufferSize, const config_t& config) :
+    _buffer(buffer),
+    _capacity(static_cast<uint32_t>(bufferSize / recordSize(config))),
+    _header { MAGIC, VERSION, static_cast<uint16_t>(recordSize(config)), config }
+{
+}
+
+size_t PIDFRecorder::recordSize(const config_t& config)
+{
+    size_t size = sizeof(uint16_t); // sequence number
+    for (size_t ii = 0; ii < PIDFRecordFields::FIELD_COUNT; ++ii) {
+        if (config.fields & (1U << ii)) {
+            size += (config.encodings[ii] == FLOAT) ? sizeof(float) : (config.encodings[ii] == QUANTIZED) ? sizeof(int16_t) : sizeof(int8_t);
+        }
+    }
+    return size;
+}
+
+/*!
+Write a record. Called by the producer only. Never waits: if the buffer is full the record is dropped.
+*/
+void PIDFRecorder::record(const values_t& values)
+{
+    const uint16_t sequence = _sequence;
+    ++_sequence;
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+    // acquire, so the consumer has finished reading a record before it is overwritten
+    if (head - _tail.load(std::memory_order_acquire) >= _capacity) {
+        _droppedCount.store(_droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint8_t* out = _buffer + static_cast<size_t>(_writeIndex)*_header.recordSize;
+    memcpy(out, &sequence, sizeof(sequence));
+    out += sizeof(sequence);
+    const config_t& config = _header.config;
+    for (size_t ii = 0; ii < PIDFRecordFields::FIELD_COUNT; ++ii) {
+        if ((config.fields & (1U << ii)) == 0) {
+            continue;
+        }
+        switch (config.encodings[ii]) {
+        case QUANTIZED: {
+            const auto value = static_cast<int16_t>(quantize(values[ii], config.scales[ii], INT16_LIMIT));
+            memcpy(out, &value, sizeof(value));
+            out += sizeof(value);
+            break;
+        }
+        case DELTA: {
+            // delta from the value the decoder has reconstructed, so errors due to slew limiting do not accumulate
+            const int32_t delta = quantize(values[ii], config.scales[ii], INT32_LIMIT) - _deltaPrevious[ii];
+            const auto value = static_cast<int8_t>(delta > 127 ? 127 : delta < -127 ? -127 : delta);
+            _deltaPrevious[ii] += value;
+            memcpy(out, &value, sizeof(value));
+            out += sizeof(value);
+            break;
+        }
+        default:
+            memcpy(out, &values[ii], sizeof(float));
+            out += sizeof(float);
+            break;
+        }
+    }
+
+    ++_writeIndex;
+    if (_writeIndex == _capacity) {
+        _writeIndex = 0;
+    }
+    // release, so the record is written before the consumer sees it
+    _head.store(head + 1, std::memory_order_release);
+}
+
+size_t PIDFRecorder::peek(const uint8_t*& data) const
+{
+    const uint32_t count = _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    const uint32_t contiguous = _capacity - _readIndex;
+    data = _buffer + static_cast<size_t>(_readIndex)*_header.recordSize;
+    return static_cast<size_t>(count < contiguous ? count : contiguous) * _header.recordSize;
+}
+
+void PIDFRecorder::consume(size_t byteCount)
+{
+    const auto count = static_cast<uint32_t>(byteCount / _header.recordSize);
+    _readIndex += count;
+    if (_readIndex >= _capacity) {
+        _readIndex -= _capacity;
+    }
+    // release, so the records have been read before the producer overwrites them
+    _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+
+PIDFRecordDecoder::PIDFRecordDecoder(const PIDFRecorder::header_t& header) :
+    _header(header)
+{
+}
+
+bool PIDFRecordDecoder::isValid() const
+{
+    if (_header.magic != PIDFRecorder::MAGIC || _header.version != PIDFRecorder::VERSION) {
+        return false;
+    }
+    for (uint8_t encoding : _header.config.encodings) {
+        if (encoding > PIDFRecorder::DELTA) {
+            return false;
+        }
+    }
+    return _header.recordSize == PIDFRecorder::recordSize(_header.config);
+}
+
+PIDFRecordDecoder::record_t PIDFRecordDecoder::decode(const uint8_t* record)
+{
+    record_t ret {};
+    memcpy(&ret.sequence, record, sizeof(ret.sequence));
+    record += sizeof(ret.sequence);
+    ret.dropped = static_cast<uint16_t>(ret.sequence - _sequenceExpected);
+    _sequenceExpected = static_cast<uint16_t>(ret.sequence + 1);
+
+    const PIDFRecorder::config_t& config = _header.config;
+    for (size_t ii = 0; ii < PIDFRecordFields::FIELD_COUNT; ++ii) {
+        if ((config.fields & (1U << ii)) == 0) {
+            continue;
+        }
+        switch (config.encodings[ii]) {
+        case PIDFRecorder::QUANTIZED: {
+            int16_t value {};
+            memcpy(&value, record, sizeof(value));
+            record += sizeof(value);
+            ret.values[ii] = static_cast<float>(value) / config.scales[ii];
+            break;
+        }
+        case PIDFRecorder::DELTA: {
+            int8_t value {};
+            memcpy(&value, record, sizeof(value));
+            record += sizeof(value);
+            _deltaPrevious[ii] += value;
+            ret.values[ii] = static_cast<float>(_deltaPrevious[ii]) / config.scales[ii];
+            break;
+        }
+        default:
+            memcpy(&ret.values[ii], record, sizeof(float));
+            record += sizeof(float);
+            break;
+        }
+    }
+    return ret;
+}
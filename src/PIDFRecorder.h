@@ -0,0 +1,117 @@
+# pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+Field selection flags for PIDFRecorder. The fields are stored in each record in the order of their flags.
+*/
+struct PIDFRecordFields {
+    static constexpr uint32_t SETPOINT = 0x01;
+    static constexpr uint32_t MEASUREMENT = 0x02;
+    static constexpr uint32_t P = 0x04; //!< P contribution to the output, ie kp*error
+    static constexpr uint32_t I = 0x08; //!< I contribution to the output
+    static constexpr uint32_t D = 0x10; //!< D contribution to the output
+    static constexpr uint32_t S = 0x20; //!< S contribution to the output
+    static constexpr uint32_t K = 0x40; //!< K contribution to the output
+    static constexpr uint32_t OUTPUT = 0x80;
+    static constexpr uint32_t ALL = 0xFF;
+    static constexpr size_t FIELD_COUNT = 8;
+};
+
+/*!
+Blackbox recorder, for recording the state of a PID controller at every update.
+
+Each update writes a compact fixed-size binary record into a preallocated ring buffer. The recorder is lock-free with a
+single producer (the control loop) and a single consumer (eg a low-priority task that streams the records to a file or
+serial port). The producer never waits: if the buffer is full, the record is dropped and counted. Each record starts with
+a 16-bit sequence number, which is incremented for dropped records too, so gaps can be detected when decoding.
+
+Each selected field is stored either as a float, as a 16-bit integer quantized to 1/scale, or as an 8-bit
+delta from the field's previous quantized value. Delta encoding is slew limited: if a field changes by more than
+127/scale between records then the recorded value lags behind, but the error never accumulates, since each delta is
+calculated from the value that the decoder will reconstruct. Dropped records do not affect delta decoding.
+
+Records are drained without copying using `peek` and `consume`. A dump consists of the `header_t`, as returned by
+`getHeader`, followed by the records. Values are stored in native byte order (little-endian on all supported targets).
+PIDFRecordDecoder, and the pidf_decode host tool, convert a dump back into values.
+*/
+class PIDFRecorder {
+public:
+    enum encoding_e : uint8_t { FLOAT = 0, QUANTIZED = 1, DELTA = 2 };
+    using values_t = std::array<float, PIDFRecordFields::FIELD_COUNT>; //!< values in PIDFRecordFields order
+    struct config_t {
+        uint32_t fields; //!< combination of PIDFRecordFields flags
+        std::array<uint8_t, PIDFRecordFields::FIELD_COUNT> encodings; //!< encoding_e of each field, in PIDFRecordFields order
+        std::array<float, PIDFRecordFields::FIELD_COUNT> scales; //!< QUANTIZED and DELTA fields are stored as round(value*scale)
+    };
+    static constexpr uint32_t MAGIC = 0x46444950; //!< "PIDF" in little-endian byte order
+    static constexpr uint16_t VERSION = 1;
+    struct header_t {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t recordSize;
+        config_t config;
+    };
+public:
+    PIDFRecorder(uint8_t* buffer, size_t bufferSize, const config_t& config);
+public:
+    static size_t recordSize(const config_t& config);
+    inline size_t getRecordSize() const { return _header.recordSize; }
+    inline size_t getCapacity() const { return _capacity; } //!< capacity in records
+    inline const header_t& getHeader() const { return _header; }
+    inline uint32_t getDroppedCount() const { return _droppedCount.load(std::memory_order_relaxed); }
+
+    // producer
+    void record(const values_t& values);
+
+    // consumer
+    /*!
+    Sets data to the oldest unconsumed record, and returns the size in bytes of the contiguous run of records that starts there.
+    Returns 0 if there are no records. Call again after consume to get any records after the end of the buffer.
+    */
+    size_t peek(const uint8_t*& data) const;
+    void consume(size_t byteCount); //!< Releases byteCount bytes, which must be a multiple of the record size, returned by peek.
+    inline size_t available() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed); } //!< number of records waiting to be consumed
+private:
+    uint8_t* _buffer;
+    uint32_t _capacity;
+    header_t _header;
+    std::array<int32_t, PIDFRecordFields::FIELD_COUNT> _deltaPrevious {}; //!< previous value of each DELTA field, as reconstructed by the decoder
+    // producer state
+    std::atomic<uint32_t> _head {0};
+    uint32_t _writeIndex {0};
+    std::atomic<uint32_t> _droppedCount {0};
+    uint16_t _sequence {0};
+    uint16_t _unused {0};
+    // consumer state
+    std::atomic<uint32_t> _tail {0};
+    uint32_t _readIndex {0};
+};
+
+/*!
+Decodes records written by PIDFRecorder.
+*/
+class PIDFRecordDecoder {
+public:
+    struct record_t {
+        uint16_t sequence;
+        uint16_t dropped; //!< number of records dropped immediately before this one
+        PIDFRecorder::values_t values; //!< values of the fields that are not recorded are zero
+    };
+public:
+    explicit PIDFRecordDecoder(const PIDFRecorder::header_t& header);
+public:
+    //! Returns false if the header has the wrong magic number or version, or an inconsistent record size.
+    bool isValid() const;
+    inline size_t getRecordSize() const { return _header.recordSize; }
+    inline const PIDFRecorder::header_t& getHeader() const { return _header; }
+    record_t decode(const uint8_t* record); //!< records must be decoded in order
+private:
+    PIDFRecorder::header_t _header;
+    std::array<int32_t, PIDFRecordFields::FIELD_COUNT> _deltaPrevious {};
+    uint16_t _sequenceExpected {0};
+    uint16_t _unused {0};
+};
@@ -0,0 +1,71 @@
+#include "PIDFReplay.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PIDF_USE_MMAP
+#endif
+
+
+bool PIDFMappedFile::open(const char* path)
+{
+    close();
+#if defined(PIDF_USE_MMAP)
+    const int fd = ::open(path, O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status {};
+    if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<size_t>(status.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+        return false;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    _data = static_cast<const uint8_t*>(data);
+    _size = size;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void PIDFMappedFile::close()
+{
+#if defined(PIDF_USE_MMAP)
+    if (_data != nullptr) {
+        munmap(const_cast<uint8_t*>(_data), _size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+#endif
+    _data = nullptr;
+    _size = 0;
+}
+
+
+PIDFReplay::PIDFReplay(const uint8_t* data, size_t size) :
+    _records(data),
+    _recordCount(0),
+    _valid(false)
+{
+    if (data == nullptr || size < sizeof(PIDFRecorder::header_t)) {
+        return;
+    }
+    memcpy(&_header, data, sizeof(_header));
+    const PIDFRecordDecoder decoder(_header);
+    constexpr uint32_t required = PIDFRecordFields::SETPOINT | PIDFRecordFields::MEASUREMENT;
+    if (!decoder.isValid() || (_header.config.fields & required) != required) {
+        return;
+    }
+    _records = data + sizeof(PIDFRecorder::header_t); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    // a partially written final record is ignored
+    _recordCount = (size - sizeof(PIDFRecorder::header_t)) / decoder.getRecordSize();
+    _valid = true;
+}
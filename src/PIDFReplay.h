@@ -0,0 +1,131 @@
+# pragma once
+
+#include "PIDFRecorder.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/*!
+Read-only memory mapping of a file, for replaying logs without reading them into memory.
+The mapping is advised for sequential access, so the operating system reads ahead and can drop pages once they are replayed,
+so logs much larger than memory can be replayed. Only available on POSIX hosts: on other targets open returns false.
+*/
+class PIDFMappedFile {
+public:
+    PIDFMappedFile() = default;
+    ~PIDFMappedFile() { close(); }
+    PIDFMappedFile(const PIDFMappedFile&) = delete;
+    PIDFMappedFile& operator=(const PIDFMappedFile&) = delete;
+    PIDFMappedFile(PIDFMappedFile&&) = delete;
+    PIDFMappedFile& operator=(PIDFMappedFile&&) = delete;
+public:
+    bool open(const char* path); //!< Returns false if the file cannot be opened or mapped.
+    void close();
+    inline const uint8_t* data() const { return _data; }
+    inline size_t size() const { return _size; }
+private:
+    const uint8_t* _data {nullptr};
+    size_t _size {0};
+};
+
+/*!
+Offline replay of a PIDFRecorder dump through one or more controllers, for example to evaluate candidate gains against the
+setpoints and measurements recorded in the field.
+
+The dump (the recorder header followed by the records, eg memory-mapped using PIDFMappedFile) is decoded in blocks of
+BLOCK_SIZE records, and each block is run through every controller before the next block is decoded, so the log is read
+and decoded once however many gain sets are replayed, and only one block is held in memory. The dump must contain the
+setpoint and measurement fields.
+
+For each block and controller, the sink is called with the values that a recorder would have recorded for the update:
+the setpoint, measurement, P, I, D, S, and K contributions, and the output, in PIDFRecordFields order. So the results can be
+written to a PIDFRecorder and decoded with the pidf_decode tool, as the pidf_replay tool does.
+
+Records dropped by the recorder are skipped, and the deltaT of the next update is increased to span the gap.
+*/
+class PIDFReplay {
+public:
+    enum { BLOCK_SIZE = 1024 };
+    struct sample_t {
+        float setpoint;
+        float measurement;
+        float deltaT; //!< time since the previous sample
+    };
+    struct stats_t {
+        size_t recordCount;
+        size_t droppedCount;
+    };
+public:
+    //! data is the dump: the recorder header followed by the records.
+    PIDFReplay(const uint8_t* data, size_t size);
+public:
+    //! Returns false if the dump is not a valid recorder dump, or does not contain the setpoint and measurement.
+    inline bool isValid() const { return _valid; }
+    inline const PIDFRecorder::header_t& getHeader() const { return _header; }
+    inline size_t getRecordCount() const { return _recordCount; }
+
+    //! Default update function: sets the setpoint and calls update(measurement, deltaT).
+    struct Update {
+        template <typename PID>
+        float operator()(PID& pid, const sample_t& sample) const { pid.setSetpoint(sample.setpoint); return pid.update(sample.measurement, sample.deltaT); }
+    };
+
+    /*!
+    Replay the log through pidCount controllers, with the given deltaT between recorded samples.
+    update(pid, sample) runs one update and returns the output, so any update function can be replayed.
+    sink(pidIndex, firstRecordIndex, values, count) is called with the results of each block for each controller, where
+    values points to count PIDFRecorder::values_t.
+    */
+    template <typename PID, typename UPDATE, typename SINK>
+    stats_t run(PID* pids, size_t pidCount, float deltaT, UPDATE&& update, SINK&& sink) const;
+    template <typename PID, typename SINK>
+    stats_t run(PID* pids, size_t pidCount, float deltaT, SINK&& sink) const { return run(pids, pidCount, deltaT, Update(), sink); }
+private:
+    const uint8_t* _records;
+    size_t _recordCount;
+    PIDFRecorder::header_t _header {};
+    bool _valid;
+    std::array<uint8_t, 3> _unused {};
+};
+
+template <typename PID, typename UPDATE, typename SINK>
+PIDFReplay::stats_t PIDFReplay::run(PID* pids, size_t pidCount, float deltaT, UPDATE&& update, SINK&& sink) const
+{
+    stats_t stats {0, 0};
+    if (!_valid) {
+        return stats;
+    }
+    PIDFRecordDecoder decoder(_header);
+    const size_t recordSize = decoder.getRecordSize();
+    std::vector<sample_t> samples(BLOCK_SIZE);
+    std::vector<PIDFRecorder::values_t> values(BLOCK_SIZE);
+    const uint8_t* record = _records;
+
+    for (size_t blockStart = 0; blockStart < _recordCount; blockStart += BLOCK_SIZE) {
+        const size_t count = std::min(static_cast<size_t>(BLOCK_SIZE), _recordCount - blockStart);
+        for (size_t ii = 0; ii < count; ++ii) {
+            const PIDFRecordDecoder::record_t decoded = decoder.decode(record);
+            record += recordSize; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            // the first record has no previous record, so its sequence number is not a gap
+            const uint16_t dropped = (blockStart + ii == 0) ? 0 : decoded.dropped;
+            stats.droppedCount += dropped;
+            samples[ii] = { decoded.values[0], decoded.values[1], deltaT*static_cast<float>(dropped + 1) };
+        }
+        for (size_t jj = 0; jj < pidCount; ++jj) {
+            PID& pid = pids[jj]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            for (size_t ii = 0; ii < count; ++ii) {
+                const sample_t& sample = samples[ii];
+                const float output = static_cast<float>(update(pid, sample));
+                const auto e = pid.getError();
+                values[ii] = {
+                    sample.setpoint, sample.measurement,
+                    static_cast<float>(e.P), static_cast<float>(e.I), static_cast<float>(e.D), static_cast<float>(e.S), static_cast<float>(e.K),
+                    output
+                };
+            }
+            sink(jj, blockStart, &values[0], count);
+        }
+    }
+    stats.recordCount = _recordCount;
+    return stats;
+}
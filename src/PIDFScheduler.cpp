@@ -0,0 +1,267 @@
+// the scheduler needs threads, so is only built for hosts: the header is also host-only, since it uses std::thread,
+// std::mutex, and std::condition_variable, which single-threaded embedded toolchains do not provide
+#if defined(__unix__) || defined(__APPLE__) || defined(_WIN32)
+
+#include "PIDFScheduler.h"
+#include <cerrno>
+#include <chrono>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+
+uint64_t PIDFMonotonicClock::now()
+{
+#if defined(__linux__)
+    timespec time {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<uint64_t>(time.tv_sec)*1000000000U + static_cast<uint64_t>(time.tv_nsec);
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void PIDFMonotonicClock::sleepUntil(uint64_t time)
+{
+#if defined(__linux__)
+    // absolute sleep, so the wakeup time does not drift by the time taken to calculate it
+    const timespec wake { static_cast<time_t>(time/1000000000U), static_cast<long>(time%1000000000U) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR) {}
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(time)));
+#endif
+}
+
+size_t PIDFScheduler::addLoop(PIDF& pid, uint64_t period, sensor_t sensor, actuator_t actuator, size_t thread)
+{
+    period = std::max(period, static_cast<uint64_t>(1));
+    if (thread == ANY_THREAD) {
+        const auto first = _threadRates.begin() + (_threadCount > 1 ? 1 : 0);
+        thread = static_cast<size_t>(std::min_element(first, _threadRates.end()) - _threadRates.begin());
+    }
+    thread = std::min(thread, _threadCount - 1);
+    _threadRates[thread] += 1.0e9 / static_cast<double>(period);
+    _loops.emplace_back(pid, period, std::move(sensor), std::move(actuator), thread);
+    _prepared = false;
+    return _loops.size() - 1;
+}
+
+PIDFScheduler::stats_t PIDFScheduler::getStats(size_t loop) const
+{
+    const loop_t& l = _loops[loop];
+    stats_t stats = l.published.read();
+    stats.skipCount = l.skipCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void PIDFScheduler::prepare()
+{
+    if (_prepared) {
+        return;
+    }
+    // all loops are first released one period after the scheduler starts, so the first deltaT is the period
+    _epoch = _clock.now();
+    _wheel.resize(_loops.size());
+    _wheel.reset(0);
+    for (size_t ii = 0; ii < _loops.size(); ++ii) {
+        loop_t& loop = _loops[ii];
+        loop.nextRelease = _epoch + loop.period;
+        loop.previousStart = 0;
+        _wheel.schedule(static_cast<uint32_t>(ii), (loop.period + _tick - 1)/_tick);
+    }
+    // reserve the queues, so the scheduler does not allocate once running
+    _released.reserve(_loops.size());
+    _inline.reserve(_loops.size());
+    for (auto& worker : _workers) {
+        worker.queue.reserve(_loops.size());
+    }
+    _prepared = true;
+}
+
+void PIDFScheduler::dispatch(uint64_t now, bool runInline)
+{
+    _released.clear();
+    _wheel.advance(timeToTick(now), [this](uint32_t loop) { _released.push_back(loop); });
+    std::sort(_released.begin(), _released.end(), [this](uint32_t a, uint32_t b) {
+        return _loops[a].period < _loops[b].period || (_loops[a].period == _loops[b].period && a < b);
+    });
+    for (const uint32_t index : _released) {
+        loop_t& loop = _loops[index];
+        const uint64_t release = loop.nextRelease;
+        uint32_t skipCount = 0;
+        if (loop.busy.load(std::memory_order_acquire)) {
+            ++skipCount;
+        } else {
+            loop.release = release;
+            loop.busy.store(true, std::memory_order_relaxed);
+            if (runInline || loop.thread == 0) {
+                _inline.push_back(index);
+            } else {
+                worker_t& worker = _workers[loop.thread];
+                {
+                    const std::lock_guard<std::mutex> lock(worker.mutex);
+                    worker.queue.push_back(index);
+                }
+                worker.condition.notify_one();
+            }
+        }
+        // releases that have already passed are skipped, so a late loop does not run several times in a row
+        uint64_t next = release + loop.period;
+        if (next <= now) {
+            const uint64_t passed = (now - next)/loop.period + 1;
+            next += passed*loop.period;
+            skipCount += static_cast<uint32_t>(passed);
+        }
+        if (skipCount != 0) {
+            loop.skipCount.fetch_add(skipCount, std::memory_order_relaxed);
+        }
+        loop.nextRelease = next;
+        _wheel.schedule(index, (next - _epoch + _tick - 1)/_tick);
+    }
+    runQueued(_inline);
+}
+
+void PIDFScheduler::runQueued(std::vector<uint32_t>& queue)
+{
+    for (const uint32_t index : queue) {
+        runLoop(_loops[index]);
+    }
+    queue.clear();
+}
+
+void PIDFScheduler::runLoop(loop_t& loop)
+{
+    const uint64_t start = _clock.now();
+    const float deltaT = loop.previousStart == 0 ?
+        static_cast<float>(loop.period)*1.0e-9F :
+        static_cast<float>(start - loop.previousStart)*1.0e-9F;
+    loop.previousStart = start;
+
+    const float measurement = loop.sensor();
+    const float output = loop.pid->update(measurement, deltaT);
+    loop.actuator(output);
+
+    const uint64_t end = _clock.now();
+    stats_t& stats = loop.stats;
+    ++stats.runCount;
+    if (end > loop.release + loop.deadline) {
+        ++stats.missCount;
+    }
+    const auto saturate = [](uint64_t value) { return static_cast<uint32_t>(std::min(value, static_cast<uint64_t>(UINT32_MAX))); };
+    stats.maxLatency = std::max(stats.maxLatency, saturate(start - std::min(start, loop.release)));
+    stats.maxExecutionTime = std::max(stats.maxExecutionTime, saturate(end - start));
+    loop.published.publish(stats);
+    loop.busy.store(false, std::memory_order_release);
+}
+
+void PIDFScheduler::runUntil(uint64_t time)
+{
+    prepare();
+    for (;;) {
+        const uint64_t next = tickToTime(_wheel.getNextTick());
+        if (next > time) {
+            _clock.sleepUntil(time);
+            return;
+        }
+        _clock.sleepUntil(next);
+        dispatch(_clock.now(), true);
+    }
+}
+
+void PIDFScheduler::dispatcherLoop()
+{
+    while (_running.load(std::memory_order_acquire)) {
+        const uint64_t next = tickToTime(_wheel.getNextTick());
+        const uint64_t now = _clock.now();
+        _clock.sleepUntil(std::min(next, now + MAX_SLEEP));
+        dispatch(_clock.now(), false);
+    }
+}
+
+void PIDFScheduler::workerLoop(size_t thread)
+{
+    worker_t& worker = _workers[thread];
+    std::vector<uint32_t> queue;
+    queue.reserve(_loops.size());
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.condition.wait(lock, [this, &worker]() { return !worker.queue.empty() || !_running.load(std::memory_order_acquire); });
+            if (worker.queue.empty()) {
+                return;
+            }
+            queue.swap(worker.queue);
+        }
+        runQueued(queue);
+    }
+}
+
+bool PIDFScheduler::configureThread(std::thread& thread, const std::vector<int>& cpus, size_t index, int priority)
+{
+#if defined(__linux__)
+    bool ok = true;
+    if (!cpus.empty()) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(static_cast<size_t>(cpus[index % cpus.size()]), &cpuSet);
+        ok = pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet) == 0;
+    }
+    if (priority != 0) {
+        sched_param parameters {};
+        parameters.sched_priority = priority;
+        ok = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &parameters) == 0 && ok;
+    }
+    return ok;
+#else
+    (void)thread;
+    (void)index;
+    return cpus.empty() && priority == 0;
+#endif
+}
+
+bool PIDFScheduler::start(const std::vector<int>& cpus, int priority)
+{
+    if (_running.load(std::memory_order_acquire)) {
+        return true;
+    }
+    _prepared = false; // restart from the current time
+    prepare();
+    _running.store(true, std::memory_order_release);
+    bool ok = true;
+    for (size_t ii = 0; ii < _threadCount; ++ii) {
+        std::thread& thread = _workers[ii].thread;
+        if (ii == 0) {
+            thread = std::thread([this]() { dispatcherLoop(); });
+        } else {
+            thread = std::thread([this, ii]() { workerLoop(ii); });
+        }
+        ok = configureThread(thread, cpus, ii, priority) && ok;
+    }
+    return ok;
+}
+
+void PIDFScheduler::stop()
+{
+    if (!_running.load(std::memory_order_acquire)) {
+        return;
+    }
+    _running.store(false, std::memory_order_release);
+    _workers[0].thread.join();
+    for (size_t ii = 1; ii < _threadCount; ++ii) {
+        worker_t& worker = _workers[ii];
+        {
+            const std::lock_guard<std::mutex> lock(worker.mutex);
+        }
+        worker.condition.notify_one();
+        worker.thread.join();
+    }
+    // loops that were queued but not run are no longer busy
+    for (auto& loop : _loops) {
+        loop.busy.store(false, std::memory_order_relaxed);
+    }
+}
+
+#endif
@@ -0,0 +1,342 @@
+# pragma once
+
+#include "PIDF.h"
+#include "PIDFSeqlock.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+Clock used by PIDFScheduler, times are in nanoseconds.
+*/
+class PIDFClock {
+public:
+    PIDFClock() = default;
+    virtual ~PIDFClock() = default;
+    PIDFClock(const PIDFClock&) = delete;
+    PIDFClock& operator=(const PIDFClock&) = delete;
+    PIDFClock(PIDFClock&&) = delete;
+    PIDFClock& operator=(PIDFClock&&) = delete;
+public:
+    virtual uint64_t now() = 0;
+    //! Wait until now() >= time, returns immediately if time has passed.
+    virtual void sleepUntil(uint64_t time) = 0;
+};
+
+/*!
+Monotonic clock, ie CLOCK_MONOTONIC on Linux, which is not changed when the system time is set.
+On Linux, sleepUntil is an absolute sleep, so the wakeup time does not drift by the time taken to calculate it.
+*/
+class PIDFMonotonicClock : public PIDFClock {
+public:
+    uint64_t now() override;
+    void sleepUntil(uint64_t time) override;
+};
+
+/*!
+Simulated clock, for deterministic testing. Time only moves forward when sleepUntil or advance is called, so sleeping takes
+no real time. A sensor or actuator callback can call advance to simulate the time it takes to run.
+*/
+class PIDFSimulatedClock : public PIDFClock {
+public:
+    explicit PIDFSimulatedClock(uint64_t time = 0) : _time(time) {}
+public:
+    uint64_t now() override { return _time.load(std::memory_order_acquire); }
+    void sleepUntil(uint64_t time) override {
+        uint64_t current = _time.load(std::memory_order_acquire);
+        while (current < time && !_time.compare_exchange_weak(current, time, std::memory_order_acq_rel)) {}
+    }
+    void advance(uint64_t duration) { _time.fetch_add(duration, std::memory_order_acq_rel); }
+private:
+    std::atomic<uint64_t> _time;
+};
+
+/*!
+Hierarchical timer wheel, with LEVEL_COUNT levels of SLOT_COUNT slots.
+
+A timer that expires within SLOT_COUNT ticks is held in level 0, in the slot for its expiry tick. A timer that expires within
+SLOT_COUNT^2 ticks is held in level 1, in the slot for its expiry tick/SLOT_COUNT, and so on. When the tick reaches the start
+of a level 1 slot, the timers in that slot are moved down to level 0 (cascaded), and similarly for the higher levels.
+So scheduling and expiring a timer take constant time, however many timers there are.
+
+Each level has a bitmap of its occupied slots, so the next tick at which a timer expires (or is cascaded) is found with a
+count of trailing zeros, and the wheel can be advanced straight to it, rather than one tick at a time.
+
+Timers are identified by index, from 0 to timerCount - 1, and the timers are held in intrusive lists, so scheduling does
+not allocate. A timer must not be scheduled again until it has expired.
+*/
+class PIDFTimerWheel {
+public:
+    enum { LEVEL_BITS = 6, SLOT_COUNT = 1U << LEVEL_BITS, LEVEL_COUNT = 4 };
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint64_t SLOT_MASK = SLOT_COUNT - 1;
+    //! Timers further ahead than this are cascaded down as time passes, so they still expire on time.
+    static constexpr uint64_t MAX_DELTA = (1ULL << (LEVEL_BITS*LEVEL_COUNT)) - 1;
+public:
+    explicit PIDFTimerWheel(size_t timerCount = 0) { resize(timerCount); }
+public:
+    //! Set the number of timers, and clear all the timers.
+    void resize(size_t timerCount) {
+        _next.assign(timerCount, NONE);
+        _expiry.assign(timerCount, 0);
+        reset(_tick);
+    }
+    //! Clear all the timers and set the current tick.
+    void reset(uint64_t tick) {
+        for (auto& level : _slots) {
+            level.fill(NONE);
+        }
+        _occupied.fill(0);
+        _tick = tick;
+    }
+    inline uint64_t getTick() const { return _tick; }
+    inline size_t getTimerCount() const { return _next.size(); }
+
+    //! Schedule the timer to expire at expiryTick, or at the next tick if expiryTick has passed.
+    void schedule(uint32_t timer, uint64_t expiryTick) {
+        _expiry[timer] = std::max(expiryTick, _tick + 1);
+        insert(timer);
+    }
+    //! The next tick at which a timer expires or is cascaded, always after the current tick. UINT64_MAX if there are no timers.
+    uint64_t getNextTick() const;
+
+    /*!
+    Advance the current tick to tick, calling expired(timer) for each timer that expires, in order of expiry.
+    expired may schedule timers, including the timer that has just expired.
+    */
+    template <typename F>
+    void advance(uint64_t tick, F&& expired);
+private:
+    void insert(uint32_t timer);
+    //! Detach the list in a slot, and return its first timer.
+    uint32_t take(size_t level, size_t slot) {
+        const uint32_t timer = _slots[level][slot];
+        _slots[level][slot] = NONE;
+        _occupied[level] &= ~(1ULL << slot);
+        return timer;
+    }
+private:
+    std::array<std::array<uint32_t, SLOT_COUNT>, LEVEL_COUNT> _slots {};
+    std::array<uint64_t, LEVEL_COUNT> _occupied {};
+    std::vector<uint32_t> _next; //!< next timer in the same slot
+    std::vector<uint64_t> _expiry;
+    uint64_t _tick {0};
+};
+
+inline void PIDFTimerWheel::insert(uint32_t timer)
+{
+    // delta is 0 only for a timer cascaded on its expiry tick, it goes in the current level 0 slot, which is expired next
+    const uint64_t expiry = _expiry[timer];
+    const uint64_t delta = expiry - std::min(expiry, _tick);
+    size_t level = LEVEL_COUNT - 1;
+    uint64_t position = _tick + MAX_DELTA;
+    if (delta <= MAX_DELTA) {
+        level = 0;
+        while (delta >> (LEVEL_BITS*(level + 1)) != 0) {
+            ++level;
+        }
+        position = expiry;
+    }
+    const auto slot = static_cast<size_t>((position >> (LEVEL_BITS*level)) & SLOT_MASK);
+    _next[timer] = _slots[level][slot];
+    _slots[level][slot] = timer;
+    _occupied[level] |= 1ULL << slot;
+}
+
+inline uint64_t PIDFTimerWheel::getNextTick() const
+{
+    uint64_t next = UINT64_MAX;
+    for (size_t level = 0; level < LEVEL_COUNT; ++level) {
+        const uint64_t occupied = _occupied[level];
+        if (occupied == 0) {
+            continue;
+        }
+        // the timers in a level are 1 to SLOT_COUNT slots ahead of the current position, so rotate the bitmap so that
+        // the slot after the current position is bit 0
+        const unsigned shift = LEVEL_BITS*static_cast<unsigned>(level);
+        const uint64_t position = _tick >> shift;
+        const auto rotation = static_cast<unsigned>((position + 1) & SLOT_MASK);
+        const uint64_t rotated = rotation == 0 ? occupied : (occupied >> rotation) | (occupied << (SLOT_COUNT - rotation));
+        const auto slotsAhead = static_cast<uint64_t>(__builtin_ctzll(rotated)) + 1;
+        next = std::min(next, (position + slotsAhead) << shift);
+    }
+    return next;
+}
+
+template <typename F>
+void PIDFTimerWheel::advance(uint64_t tick, F&& expired)
+{
+    for (;;) {
+        const uint64_t next = getNextTick();
+        if (next > tick) {
+            // no timer expires or is cascaded before tick, so the current tick can jump straight to it
+            _tick = std::max(_tick, tick);
+            return;
+        }
+        _tick = next;
+        // cascade from the highest level down, so a timer can move down several levels at once
+        for (size_t level = LEVEL_COUNT - 1; level > 0; --level) {
+            const unsigned shift = LEVEL_BITS*static_cast<unsigned>(level);
+            if ((next & ((1ULL << shift) - 1)) != 0) {
+                continue;
+            }
+            uint32_t timer = take(level, static_cast<size_t>((next >> shift) & SLOT_MASK));
+            while (timer != NONE) {
+                const uint32_t following = _next[timer];
+                insert(timer);
+                timer = following;
+            }
+        }
+        uint32_t timer = take(0, static_cast<size_t>(next & SLOT_MASK));
+        while (timer != NONE) {
+            const uint32_t following = _next[timer];
+            _next[timer] = NONE;
+            expired(timer);
+            timer = following;
+        }
+    }
+}
+
+
+/*!
+Multi-rate scheduler, for running many PIDF loops at different rates (eg current loops at 1kHz, velocity loops at 250Hz,
+and temperature loops at 50Hz) from one timer wheel and a small pool of threads, rather than a thread and timer per loop.
+
+Each loop is a controller with a period, a sensor callback that returns the measurement, and an actuator callback that is
+given the output. When a loop is released, its sensor is read, the controller is updated, and the output is passed to its
+actuator. deltaT is the time between the starts of successive runs, from the monotonic clock, so any jitter in the release
+is compensated for by the controller. Releases are at exact multiples of the period, so the rate does not drift.
+The sensor callback runs on the loop's thread just before the update, so it is a good place to update the setpoint.
+
+Thread 0 is the dispatcher: it sleeps until the next release, expires the timer wheel, and passes the released loops to
+their threads. Loops released at the same time are run in rate-monotonic order (shortest period first). Each loop is assigned
+to a thread, so its controller stays in that thread's cache. With more than one thread, loops are assigned to the threads other
+than the dispatcher, so the dispatcher is never delayed by a loop, to the thread with the lowest total rate.
+The threads can be pinned to CPUs and given a real-time priority.
+
+A run that completes after its deadline (by default its period after its release) is counted as a miss. A release that occurs
+while the previous run of the loop is still queued or running, or that the dispatcher was too late to dispatch before the
+following release, is skipped and counted. The counts, and the worst latency and execution time of each loop, can be read
+at any time from any thread.
+
+runUntil runs the scheduler on the calling thread, with every loop run on that thread, so with a PIDFSimulatedClock the
+results are deterministic, for testing. start runs the scheduler on its threads until stop is called.
+
+Loops must be added before the scheduler is first run. The scheduler is only built for hosts (this header needs std::thread,
+so must not be included in embedded builds), and the threads can only be pinned and given a priority on Linux.
+*/
+class PIDFScheduler {
+public:
+    static constexpr size_t ANY_THREAD = SIZE_MAX;
+    static constexpr uint64_t DEFAULT_TICK = 50000; //!< 50us
+    static constexpr uint64_t MAX_SLEEP = 10000000; //!< 10ms, the dispatcher checks for stop at least this often
+    typedef std::function<float()> sensor_t;
+    typedef std::function<void(float)> actuator_t;
+    struct stats_t {
+        uint32_t runCount;
+        uint32_t missCount; //!< runs that completed after their deadline
+        uint32_t skipCount; //!< releases that were not run
+        uint32_t maxLatency; //!< longest time from release to the start of a run, ns
+        uint32_t maxExecutionTime; //!< longest run, including the sensor and actuator callbacks, ns
+    };
+public:
+    //! threadCount includes the dispatcher thread. tick is the resolution of the timer wheel, in ns.
+    explicit PIDFScheduler(PIDFClock& clock, size_t threadCount = 1, uint64_t tick = DEFAULT_TICK) :
+        _clock(clock),
+        _tick(std::max(tick, static_cast<uint64_t>(1))),
+        _threadCount(std::max(threadCount, static_cast<size_t>(1))),
+        _threadRates(_threadCount, 0.0),
+        _workers(_threadCount)
+    {}
+    ~PIDFScheduler() { stop(); }
+    PIDFScheduler(const PIDFScheduler&) = delete;
+    PIDFScheduler& operator=(const PIDFScheduler&) = delete;
+    PIDFScheduler(PIDFScheduler&&) = delete;
+    PIDFScheduler& operator=(PIDFScheduler&&) = delete;
+public:
+    /*!
+    Add a loop, run every period ns, on the given thread, or on the least loaded thread. Returns the index of the loop.
+    The controller and callbacks must outlive the scheduler.
+    */
+    size_t addLoop(PIDF& pid, uint64_t period, sensor_t sensor, actuator_t actuator, size_t thread = ANY_THREAD);
+    //! Set the deadline of a loop, relative to its release, by default it is the loop's period.
+    void setDeadline(size_t loop, uint64_t deadline) { _loops[loop].deadline = deadline; }
+
+    inline size_t getLoopCount() const { return _loops.size(); }
+    inline size_t getThreadCount() const { return _threadCount; }
+    inline size_t getThread(size_t loop) const { return _loops[loop].thread; }
+    inline uint64_t getTick() const { return _tick; }
+    //! Consistent snapshot of the statistics of a loop, can be called from any thread.
+    stats_t getStats(size_t loop) const;
+
+    /*!
+    Run the loops on the scheduler's threads, until stop is called. If cpus is not empty, thread ii is pinned to
+    cpus[ii % cpus.size()]. If priority is non-zero, the threads are given that SCHED_FIFO priority.
+    Returns false if the threads could not be pinned or given the priority (eg without the required privilege),
+    the scheduler still runs.
+    */
+    bool start(const std::vector<int>& cpus = {}, int priority = 0);
+    void stop();
+    inline bool isRunning() const { return _running.load(std::memory_order_acquire); }
+
+    //! Run the scheduler on the calling thread until the clock reaches time. Must not be called while the scheduler is started.
+    void runUntil(uint64_t time);
+private:
+    struct loop_t {
+        loop_t(PIDF& pid_, uint64_t period_, sensor_t sensor_, actuator_t actuator_, size_t thread_) :
+            sensor(std::move(sensor_)), actuator(std::move(actuator_)), pid(&pid_), period(period_), deadline(period_), thread(thread_) {}
+        sensor_t sensor;
+        actuator_t actuator;
+        PIDF* pid;
+        uint64_t period;
+        uint64_t deadline;
+        uint64_t nextRelease {0}; //!< used by the dispatcher
+        uint64_t release {0}; //!< release of the queued or running run, set by the dispatcher before queuing the loop
+        uint64_t previousStart {0}; //!< used by the loop's thread
+        size_t thread;
+        stats_t stats {}; //!< used by the loop's thread, and published after every run
+        PIDFSeqlock<stats_t> published;
+        std::atomic<uint32_t> skipCount {0}; //!< written by the dispatcher
+        std::atomic<bool> busy {false}; //!< queued or running
+        std::array<uint8_t, 7> _unused {};
+    };
+    struct worker_t {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<uint32_t> queue;
+    };
+    void prepare();
+    uint64_t tickToTime(uint64_t tick) const {
+        return tick >= (UINT64_MAX - _epoch)/_tick ? UINT64_MAX : _epoch + tick*_tick;
+    }
+    uint64_t timeToTick(uint64_t time) const { return (time - std::min(time, _epoch))/_tick; }
+    //! Expire the timer wheel up to now, and queue the released loops. With runInline, every loop is queued for thread 0.
+    void dispatch(uint64_t now, bool runInline);
+    void runQueued(std::vector<uint32_t>& queue);
+    void runLoop(loop_t& loop);
+    void dispatcherLoop();
+    void workerLoop(size_t thread);
+    static bool configureThread(std::thread& thread, const std::vector<int>& cpus, size_t index, int priority);
+private:
+    PIDFClock& _clock;
+    uint64_t _tick;
+    uint64_t _epoch {0}; //!< time of tick 0
+    size_t _threadCount;
+    std::vector<double> _threadRates; //!< sum of the rates of the loops on each thread, used to assign loops
+    std::deque<loop_t> _loops; // a deque, since loops contain atomics and so cannot be moved
+    std::deque<worker_t> _workers;
+    PIDFTimerWheel _wheel;
+    std::vector<uint32_t> _released;
+    std::vector<uint32_t> _inline;
+    std::atomic<bool> _running {false};
+    bool _prepared {false};
+    std::array<uint8_t, 6> _unused {};
+};
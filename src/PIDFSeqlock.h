@@ -0,0 +1,84 @@
+# pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*!
+Sequence lock, for publishing a small struct (eg PIDF::error_t) from one writer to any number of readers on other
+threads or cores, without the writer taking a lock or ever waiting.
+
+The writer increments the sequence number before and after writing the data, so the sequence number is odd while a
+write is in progress. A reader reads the sequence number, the data, and the sequence number again, and if the two
+sequence numbers differ (or are odd) the data may be torn and is discarded.
+
+The data is held as an array of 32-bit atomic words, so it can be read while being written without a data race, and
+so it works on cores without atomic read-modify-write instructions (eg Cortex-M0+), since the single writer only
+needs atomic loads and stores.
+*/
+template <typename T>
+class PIDFSeqlock {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "size of T must be a multiple of 4 bytes");
+    static constexpr size_t WORD_COUNT = sizeof(T) / sizeof(uint32_t);
+public:
+    PIDFSeqlock() = default;
+    // copying takes a snapshot of the other seqlock's data, so objects containing a seqlock remain copyable
+    PIDFSeqlock(const PIDFSeqlock& other) { publish(other.read()); }
+    PIDFSeqlock& operator=(const PIDFSeqlock& other) { if (this != &other) { publish(other.read()); } return *this; }
+    PIDFSeqlock(PIDFSeqlock&&) = delete;
+    PIDFSeqlock& operator=(PIDFSeqlock&&) = delete;
+    ~PIDFSeqlock() = default;
+public:
+    /*!
+    Publish value. Must only be called by one writer. Wait-free.
+    */
+    void publish(const T& value) {
+        std::array<uint32_t, WORD_COUNT> words;
+        std::memcpy(&words[0], &value, sizeof(T));
+        const uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed); // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t ii = 0; ii < WORD_COUNT; ++ii) {
+            _words[ii].store(words[ii], std::memory_order_relaxed);
+        }
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+    /*!
+    Single attempt to read a consistent value. Never waits.
+    Returns false, leaving value unchanged, if the read overlapped a write.
+    */
+    bool tryRead(T& value) const {
+        const uint32_t sequence = _sequence.load(std::memory_order_acquire);
+        if (sequence & 1U) {
+            return false;
+        }
+        std::array<uint32_t, WORD_COUNT> words;
+        for (size_t ii = 0; ii < WORD_COUNT; ++ii) {
+            words[ii] = _words[ii].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_sequence.load(std::memory_order_relaxed) != sequence) {
+            return false;
+        }
+        std::memcpy(&value, &words[0], sizeof(T));
+        return true;
+    }
+    /*!
+    Read a consistent value, retrying if the read overlapped a write. The writer is never blocked.
+    Since a write is a handful of stores, a retry is rare and the reader only spins while the writer is mid-publish.
+    */
+    T read() const {
+        T value {};
+        while (!tryRead(value)) {}
+        return value;
+    }
+    //! Number of values published, useful for a reader to detect whether there is new data.
+    uint32_t getPublishCount() const { return _sequence.load(std::memory_order_acquire) / 2; }
+private:
+    std::atomic<uint32_t> _sequence {0};
+    std::array<std::atomic<uint32_t>, WORD_COUNT> _words {};
+};
@@ -0,0 +1,160 @@
+# pragma once
+
+/*!
+Minimal SIMD abstraction used by the multi-controller PIDF kernels.
+
+Each traits struct provides the same set of operations over its vector type `v` and comparison mask type `m`, so a kernel
+can be written once and instantiated for scalar, SSE2, AVX2 or NEON execution.
+
+Only operations that give IEEE-identical results to the scalar operations used in PIDF.cpp are provided
+(add, sub, mul, div, min, max, compare, select), so a kernel instantiated with any of these traits calculates the
+same values as the scalar code, provided the compiler does not apply floating point contraction (fused multiply-add)
+differently in the two paths.
+*/
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+
+struct pidf_simd_scalar_t {
+    using v = float;
+    using m = bool;
+    static constexpr size_t WIDTH = 1;
+    static inline v load(const float* p) { return *p; }
+    static inline v loadu(const float* p) { return *p; }
+    static inline void store(float* p, v a) { *p = a; }
+    static inline void storeu(float* p, v a) { *p = a; }
+    static inline v set1(float a) { return a; }
+    static inline v zero() { return 0.0F; }
+    static inline v add(v a, v b) { return a + b; }
+    static inline v sub(v a, v b) { return a - b; }
+    static inline v mul(v a, v b) { return a * b; }
+    static inline v div(v a, v b) { return a / b; }
+    static inline v neg(v a) { return -a; }
+    static inline v abs(v a) { return fabsf(a); }
+    static inline v max(v a, v b) { return a > b ? a : b; }
+    static inline v min(v a, v b) { return a < b ? a : b; }
+    static inline m eq(v a, v b) { return a == b; }
+    static inline m gt(v a, v b) { return a > b; }
+    static inline m ge(v a, v b) { return a >= b; }
+    static inline m lt(v a, v b) { return a < b; }
+    static inline m mand(m a, m b) { return a && b; }
+    static inline m mor(m a, m b) { return a || b; }
+    static inline v select(m mask, v a, v b) { return mask ? a : b; } //!< mask ? a : b
+};
+
+#if defined(__SSE2__)
+struct pidf_simd_sse2_t {
+    using v = __m128;
+    using m = __m128;
+    static constexpr size_t WIDTH = 4;
+    static inline v load(const float* p) { return _mm_load_ps(p); }
+    static inline v loadu(const float* p) { return _mm_loadu_ps(p); }
+    static inline void store(float* p, v a) { _mm_store_ps(p, a); }
+    static inline void storeu(float* p, v a) { _mm_storeu_ps(p, a); }
+    static inline v set1(float a) { return _mm_set1_ps(a); }
+    static inline v set4(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); } //!< lanes in memory order
+    static inline v zero() { return _mm_setzero_ps(); }
+    static inline v add(v a, v b) { return _mm_add_ps(a, b); }
+    static inline v sub(v a, v b) { return _mm_sub_ps(a, b); }
+    static inline v mul(v a, v b) { return _mm_mul_ps(a, b); }
+    static inline v div(v a, v b) { return _mm_div_ps(a, b); }
+    static inline v neg(v a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0F)); }
+    static inline v abs(v a) { return _mm_andnot_ps(_mm_set1_ps(-0.0F), a); }
+    static inline v max(v a, v b) { return _mm_max_ps(a, b); }
+    static inline v min(v a, v b) { return _mm_min_ps(a, b); }
+    static inline m eq(v a, v b) { return _mm_cmpeq_ps(a, b); }
+    static inline m gt(v a, v b) { return _mm_cmpgt_ps(a, b); }
+    static inline m ge(v a, v b) { return _mm_cmpge_ps(a, b); }
+    static inline m lt(v a, v b) { return _mm_cmplt_ps(a, b); }
+    static inline m mand(m a, m b) { return _mm_and_ps(a, b); }
+    static inline m mor(m a, m b) { return _mm_or_ps(a, b); }
+    static inline v select(m mask, v a, v b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+};
+#endif
+
+#if defined(__AVX2__)
+struct pidf_simd_avx2_t {
+    using v = __m256;
+    using m = __m256;
+    static constexpr size_t WIDTH = 8;
+    static inline v load(const float* p) { return _mm256_load_ps(p); }
+    static inline v loadu(const float* p) { return _mm256_loadu_ps(p); }
+    static inline void store(float* p, v a) { _mm256_store_ps(p, a); }
+    static inline void storeu(float* p, v a) { _mm256_storeu_ps(p, a); }
+    static inline v set1(float a) { return _mm256_set1_ps(a); }
+    static inline v zero() { return _mm256_setzero_ps(); }
+    static inline v add(v a, v b) { return _mm256_add_ps(a, b); }
+    static inline v sub(v a, v b) { return _mm256_sub_ps(a, b); }
+    static inline v mul(v a, v b) { return _mm256_mul_ps(a, b); }
+    static inline v div(v a, v b) { return _mm256_div_ps(a, b); }
+    static inline v neg(v a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0F)); }
+    static inline v abs(v a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0F), a); }
+    static inline v max(v a, v b) { return _mm256_max_ps(a, b); }
+    static inline v min(v a, v b) { return _mm256_min_ps(a, b); }
+    static inline m eq(v a, v b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static inline m gt(v a, v b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static inline m ge(v a, v b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static inline m lt(v a, v b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static inline m mand(m a, m b) { return _mm256_and_ps(a, b); }
+    static inline m mor(m a, m b) { return _mm256_or_ps(a, b); }
+    static inline v select(m mask, v a, v b) { return _mm256_blendv_ps(b, a, mask); }
+};
+#endif
+
+// NEON is only used on AArch64: 32-bit NEON has no vector divide and flushes denormals, so is not IEEE compliant.
+#if defined(__ARM_NEON) && defined(__aarch64__)
+struct pidf_simd_neon_t {
+    using v = float32x4_t;
+    using m = uint32x4_t;
+    static constexpr size_t WIDTH = 4;
+    static inline v load(const float* p) { return vld1q_f32(p); }
+    static inline v loadu(const float* p) { return vld1q_f32(p); }
+    static inline void store(float* p, v a) { vst1q_f32(p, a); }
+    static inline void storeu(float* p, v a) { vst1q_f32(p, a); }
+    static inline v set1(float a) { return vdupq_n_f32(a); }
+    static inline v set4(float a, float b, float c, float d) { const float lanes[4] { a, b, c, d }; return vld1q_f32(&lanes[0]); } // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+    static inline v zero() { return vdupq_n_f32(0.0F); }
+    static inline v add(v a, v b) { return vaddq_f32(a, b); }
+    static inline v sub(v a, v b) { return vsubq_f32(a, b); }
+    static inline v mul(v a, v b) { return vmulq_f32(a, b); }
+    static inline v div(v a, v b) { return vdivq_f32(a, b); }
+    static inline v neg(v a) { return vnegq_f32(a); }
+    static inline v abs(v a) { return vabsq_f32(a); }
+    static inline v max(v a, v b) { return vbslq_f32(vcgtq_f32(a, b), a, b); } // same semantics as SSE, rather than vmaxq_f32
+    static inline v min(v a, v b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+    static inline m eq(v a, v b) { return vceqq_f32(a, b); }
+    static inline m gt(v a, v b) { return vcgtq_f32(a, b); }
+    static inline m ge(v a, v b) { return vcgeq_f32(a, b); }
+    static inline m lt(v a, v b) { return vcltq_f32(a, b); }
+    static inline m mand(m a, m b) { return vandq_u32(a, b); }
+    static inline m mor(m a, m b) { return vorrq_u32(a, b); }
+    static inline v select(m mask, v a, v b) { return vbslq_f32(mask, a, b); }
+};
+#endif
+
+#if defined(__AVX2__)
+using pidf_simd_t = pidf_simd_avx2_t;
+#elif defined(__SSE2__)
+using pidf_simd_t = pidf_simd_sse2_t;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+using pidf_simd_t = pidf_simd_neon_t;
+#else
+using pidf_simd_t = pidf_simd_scalar_t;
+#endif
+
+// 4-wide traits, for kernels that pack up to 4 values (eg the axes of a vector controller) into one vector
+#if defined(__SSE2__)
+using pidf_simd4_t = pidf_simd_sse2_t;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+using pidf_simd4_t = pidf_simd_neon_t;
+#else
+using pidf_simd4_t = pidf_simd_scalar_t;
+#endif
@@ -0,0 +1,251 @@
+# pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+Plant models and a closed-loop scenario runner, for simulating PID controllers natively.
+
+The plants are discretized with a fixed sample time, using Euler integration, and are cheap enough to simulate hours of
+8kHz control in seconds. Dead time is modelled as a delay of a whole number of samples, so is a template parameter.
+*/
+
+/*!
+Pure delay of DELAY_SAMPLES samples, used to add dead time to the plant models.
+*/
+template <size_t DELAY_SAMPLES>
+class PIDFDelay {
+public:
+    inline float update(float input) {
+        const float output = _buffer[_index];
+        _buffer[_index] = input;
+        ++_index;
+        if (_index == DELAY_SAMPLES) {
+            _index = 0;
+        }
+        return output;
+    }
+    inline void reset() { _buffer.fill(0.0F); _index = 0; }
+private:
+    std::array<float, DELAY_SAMPLES> _buffer {};
+    uint32_t _index {0};
+};
+
+// no delay, empty so takes no space when used as a base class
+template <>
+class PIDFDelay<0> {
+public:
+    inline float update(float input) { return input; }
+    inline void reset() {}
+};
+
+/*!
+First order plus dead time plant: gain*exp(-DELAY_SAMPLES*deltaT*s)/(timeConstant*s + 1).
+*/
+template <size_t DELAY_SAMPLES = 0>
+class PIDFPlantFOPDT : private PIDFDelay<DELAY_SAMPLES> {
+public:
+    PIDFPlantFOPDT(float gain, float timeConstant, float deltaT) : _gain(gain), _alpha(deltaT / timeConstant) {}
+    inline float update(float input) {
+        _output += (_gain*PIDFDelay<DELAY_SAMPLES>::update(input) - _output)*_alpha;
+        return _output;
+    }
+    inline float getOutput() const { return _output; }
+    inline void reset() { PIDFDelay<DELAY_SAMPLES>::reset(); _output = 0.0F; }
+private:
+    float _gain;
+    float _alpha; //!< deltaT/timeConstant
+    float _output {0.0F};
+};
+
+/*!
+Integrating plus dead time plant: gain*exp(-DELAY_SAMPLES*deltaT*s)/s.
+*/
+template <size_t DELAY_SAMPLES = 0>
+class PIDFPlantIntegrating : private PIDFDelay<DELAY_SAMPLES> {
+public:
+    PIDFPlantIntegrating(float gain, float deltaT) : _gainDeltaT(gain*deltaT) {}
+    inline float update(float input) {
+        _output += _gainDeltaT*PIDFDelay<DELAY_SAMPLES>::update(input);
+        return _output;
+    }
+    inline float getOutput() const { return _output; }
+    inline void reset() { PIDFDelay<DELAY_SAMPLES>::reset(); _output = 0.0F; }
+private:
+    float _gainDeltaT;
+    float _output {0.0F};
+};
+
+/*!
+Second order plant: gain*omega^2/(s^2 + 2*zeta*omega*s + omega^2), with natural frequency omega and damping ratio zeta.
+Uses semi-implicit Euler integration, which is stable for omega*deltaT < 2.
+*/
+class PIDFPlantSecondOrder {
+public:
+    PIDFPlantSecondOrder(float gain, float naturalFrequency, float dampingRatio, float deltaT) :
+        _gain(gain),
+        _omega2DeltaT(naturalFrequency*naturalFrequency*deltaT),
+        _twoZetaOmegaDeltaT(2.0F*dampingRatio*naturalFrequency*deltaT),
+        _deltaT(deltaT) {}
+    inline float update(float input) {
+        _velocity += (_gain*input - _output)*_omega2DeltaT - _velocity*_twoZetaOmegaDeltaT;
+        _output += _velocity*_deltaT;
+        return _output;
+    }
+    inline float getOutput() const { return _output; }
+    inline float getVelocity() const { return _velocity; }
+    inline void reset() { _output = 0.0F; _velocity = 0.0F; }
+private:
+    float _gain;
+    float _omega2DeltaT;
+    float _twoZetaOmegaDeltaT;
+    float _deltaT;
+    float _output {0.0F};
+    float _velocity {0.0F};
+};
+
+/*!
+DC motor with inertia, viscous friction, and Coulomb (dry) friction, driven by torqueConstant*input.
+The output is the speed. When stationary, the motor stays stationary until the drive torque exceeds the Coulomb friction (stiction).
+*/
+class PIDFPlantMotor {
+public:
+    PIDFPlantMotor(float torqueConstant, float inertia, float viscousFriction, float coulombFriction, float deltaT) :
+        _torqueConstant(torqueConstant),
+        _deltaTOverInertia(deltaT / inertia),
+        _viscousFriction(viscousFriction),
+        _coulombFriction(coulombFriction),
+        _deltaT(deltaT) {}
+    inline float update(float input) {
+        const float torque = _torqueConstant*input - _viscousFriction*_speed;
+        if (_speed == 0.0F && std::fabs(torque) <= _coulombFriction) {
+            return _speed; // stiction
+        }
+        const float friction = (_speed > 0.0F || (_speed == 0.0F && torque > 0.0F)) ? _coulombFriction : -_coulombFriction;
+        const float speed = _speed + (torque - friction)*_deltaTOverInertia;
+        // Coulomb friction cannot reverse the direction of motion
+        _speed = (_speed != 0.0F && (speed > 0.0F) != (_speed > 0.0F)) ? 0.0F : speed;
+        _position += _speed*_deltaT;
+        return _speed;
+    }
+    inline float getOutput() const { return _speed; }
+    inline float getSpeed() const { return _speed; }
+    inline float getPosition() const { return _position; }
+    inline void reset() { _speed = 0.0F; _position = 0.0F; }
+private:
+    float _torqueConstant;
+    float _deltaTOverInertia;
+    float _viscousFriction;
+    float _coulombFriction;
+    float _deltaT;
+    float _speed {0.0F};
+    float _position {0.0F};
+};
+
+/*!
+Closed-loop scenario runner.
+
+The setpoint is a step of stepAmplitude at time zero plus a ramp of rampRate, and a disturbance of disturbanceAmplitude is
+added to the plant input from disturbanceTime onwards. The controller output is limited to +/-outputLimit (if outputLimit is
+non-zero) before being applied to the plant.
+
+The step metrics are only calculated when stepAmplitude is non-zero. The overshoot is measured against the current setpoint
+(so a measurement that tracks a ramp perfectly has no overshoot), in the direction of the step and as a fraction of it.
+The rise time uses thresholds of 10% and 90% of the step, so is only calculated when rampRate is zero.
+*/
+class PIDFSimulation {
+public:
+    struct scenario_t {
+        float deltaT;
+        float duration; //!< simulated time, in seconds
+        float stepAmplitude;
+        float rampRate; //!< setpoint units per second
+        float disturbanceTime;
+        float disturbanceAmplitude; //!< added to the plant input
+        float outputLimit; //!< 0 for no limit
+        float settlingBand; //!< settled when the error is within settlingBand*stepAmplitude, eg 0.02
+    };
+    struct metrics_t {
+        float riseTime; //!< time for the measurement to go from 10% to 90% of the step, in seconds, negative if it never does (or if the setpoint ramps)
+        float overshoot; //!< maximum of (measurement - setpoint)/stepAmplitude, ie the overshoot past the current setpoint as a fraction of the step
+        float settlingTime; //!< time after which the error stays within the settling band, in seconds, negative if it never settles
+        float saturationTime; //!< total time the controller output is at the output limit, in seconds
+        float finalError;
+        float peakOutput; //!< maximum magnitude of the controller output, before limiting
+        double iae; //!< integral of absolute error
+        double itae; //!< integral of time multiplied by absolute error
+        double effort; //!< integral of the squared controller output, after limiting
+    };
+public:
+    /*!
+    Run the scenario. update(setpoint, measurement) is called at each time step and must return the controller output,
+    so any of the PIDF update functions can be simulated, eg
+    `[&pid](float setpoint, float measurement) { pid.setSetpoint(setpoint); return pid.update(measurement); }`
+    */
+    template <typename PLANT, typename UPDATE>
+    static metrics_t run(PLANT& plant, const scenario_t& scenario, UPDATE&& update) {
+        const auto steps = static_cast<uint64_t>(std::llround(static_cast<double>(scenario.duration) / static_cast<double>(scenario.deltaT)));
+        const auto disturbanceStep = static_cast<uint64_t>(std::llround(static_cast<double>(scenario.disturbanceTime) / static_cast<double>(scenario.deltaT)));
+        const float step = scenario.stepAmplitude;
+        const float settlingBand = std::fabs(scenario.settlingBand*step);
+        const auto deltaT = static_cast<double>(scenario.deltaT);
+
+        metrics_t metrics { -1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0, 0.0, 0.0 };
+        double riseStart = -1.0;
+        double saturationTime = 0.0;
+        double settled = 0.0;
+        float maxExcursion = 0.0F;
+        float peakOutput = 0.0F;
+        float measurement = plant.getOutput();
+        float error = 0.0F;
+        for (uint64_t ii = 0; ii < steps; ++ii) {
+            const double time = static_cast<double>(ii)*deltaT;
+            const float setpoint = step + scenario.rampRate*static_cast<float>(time);
+            error = setpoint - measurement;
+            float output = update(setpoint, measurement);
+            peakOutput = std::fmax(peakOutput, std::fabs(output));
+            if (scenario.outputLimit > 0.0F) {
+                if (output >= scenario.outputLimit) {
+                    output = scenario.outputLimit;
+                    saturationTime += deltaT;
+                } else if (output <= -scenario.outputLimit) {
+                    output = -scenario.outputLimit;
+                    saturationTime += deltaT;
+                }
+            }
+            metrics.effort += static_cast<double>(output*output)*deltaT;
+            if (ii >= disturbanceStep) {
+                output += scenario.disturbanceAmplitude;
+            }
+            measurement = plant.update(output);
+
+            const auto absError = static_cast<double>(std::fabs(error));
+            metrics.iae += absError*deltaT;
+            metrics.itae += time*absError*deltaT;
+            if (step != 0.0F) {
+                // rise time and overshoot are measured in the direction of the step
+                if (scenario.rampRate == 0.0F) {
+                    const float fraction = measurement / step;
+                    if (riseStart < 0.0 && fraction >= 0.1F) {
+                        riseStart = time;
+                    }
+                    if (metrics.riseTime < 0.0F && fraction >= 0.9F) {
+                        metrics.riseTime = static_cast<float>(time - riseStart);
+                    }
+                }
+                maxExcursion = std::fmax(maxExcursion, (measurement - setpoint) / step);
+                if (std::fabs(setpoint - measurement) > settlingBand) {
+                    settled = time + deltaT;
+                }
+            }
+        }
+        metrics.overshoot = maxExcursion;
+        metrics.settlingTime = (settled >= static_cast<double>(steps)*deltaT) ? -1.0F : static_cast<float>(settled);
+        metrics.saturationTime = static_cast<float>(saturationTime);
+        metrics.finalError = error;
+        metrics.peakOutput = peakOutput;
+        return metrics;
+    }
+};
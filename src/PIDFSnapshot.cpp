@@ -0,0 +1,28 @@
+#include "PIDFSnapshot.h"
+#include <array>
+
+
+uint32_t PIDFSnapshot::crc32(const uint8_t* data, size_t size)
+{
+    // reflected polynomial 0xEDB88320, processed a nibble at a time
+    static constexpr std::array<uint32_t, 16> table {{
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    }};
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t ii = 0; ii < size; ++ii) {
+        crc ^= data[ii];
+        crc = (crc >> 4U) ^ table[crc & 0x0FU];
+        crc = (crc >> 4U) ^ table[crc & 0x0FU];
+    }
+    return ~crc;
+}
+
+const PIDFSnapshot::snapshot_t* PIDFSnapshot::find(const void* data, size_t size)
+{
+    if (data == nullptr || size < sizeof(snapshot_t) || (reinterpret_cast<uintptr_t>(data) % alignof(snapshot_t)) != 0) { // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        return nullptr;
+    }
+    const auto* snapshot = static_cast<const snapshot_t*>(data);
+    return isValid(*snapshot) ? snapshot : nullptr;
+}
@@ -0,0 +1,110 @@
+# pragma once
+
+#include "PIDFT.h"
+#include <cstddef>
+#include <cstdint>
+
+/*!
+Compact persistent snapshot of a controller's gains, limits, and optionally its live state, for writing to flash or EEPROM,
+so that after a reset the controller can warm-start with its integral rather than starting cold.
+
+A snapshot is a 64-byte, 4-byte aligned, trivially copyable snapshot_t, so it fits in a single flash page or EEPROM row
+write, and can be written as bytes and read back in place without parsing. It is protected by a magic number, a version
+number, and a CRC-32 of the preceding bytes, so an erased, partially written, or out of date snapshot is rejected.
+Values are stored in native byte order (little-endian on all supported targets).
+
+    PIDFSnapshot::snapshot_t snapshot = PIDFSnapshot::capture(pid, PIDFSnapshot::STATE);
+    flashWrite(address, &snapshot, sizeof(snapshot));
+    ...
+    // at boot, zero-copy read from memory mapped flash
+    const PIDFSnapshot::snapshot_t* saved = PIDFSnapshot::find(flashAddress, sizeof(PIDFSnapshot::snapshot_t));
+    if (saved != nullptr) { PIDFSnapshot::restore(pid, *saved); }
+
+Only the gains, limits, and state of the controller's selected terms are captured and restored, so a snapshot can be
+restored into a controller with different terms. The back-calculation tracking gain is not stored.
+*/
+class PIDFSnapshot {
+public:
+    static constexpr uint32_t MAGIC = 0x53444950; //!< "PIDS" in little-endian byte order
+    static constexpr uint16_t VERSION = 1;
+    // snapshot flags
+    static constexpr uint16_t STATE = 0x01; //!< the snapshot contains the live state
+    struct snapshot_t {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t flags;
+        PIDFBase::PIDF_t pid;
+        float integralMax;
+        float integralMin;
+        float integralThreshold;
+        float outputSaturationValue;
+        float sampleTime; //!< 0 for a controller without a fixed sample time
+        // live state, valid if flags & STATE
+        float errorIntegral;
+        float measurementPrevious;
+        float setpoint;
+        uint32_t crc; //!< CRC-32 of all the preceding bytes
+    };
+    static_assert(sizeof(snapshot_t) == 64, "snapshot_t must be 64 bytes");
+public:
+    //! CRC-32 (IEEE 802.3, as used by zlib), using a 16-entry table so it is small enough for any target.
+    static uint32_t crc32(const uint8_t* data, size_t size);
+    static inline uint32_t calculateCrc(const snapshot_t& snapshot) { return crc32(reinterpret_cast<const uint8_t*>(&snapshot), offsetof(snapshot_t, crc)); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    //! Returns true if the snapshot has the correct magic number, version, and CRC.
+    static inline bool isValid(const snapshot_t& snapshot) { return snapshot.magic == MAGIC && snapshot.version == VERSION && snapshot.crc == calculateCrc(snapshot); }
+    /*!
+    Returns the snapshot stored at data, without copying, or nullptr if there is no valid snapshot there
+    (size too small, data not 4-byte aligned, or isValid false).
+    */
+    static const snapshot_t* find(const void* data, size_t size);
+
+    template <uint32_t TERMS, typename T>
+    static snapshot_t capture(const PIDFT<TERMS, T>& pid, uint16_t flags);
+    //! Restore the gains, limits, and sample time, and the state if the snapshot contains it. The snapshot must be valid.
+    template <uint32_t TERMS, typename T>
+    static void restore(PIDFT<TERMS, T>& pid, const snapshot_t& snapshot);
+};
+
+template <uint32_t TERMS, typename T>
+PIDFSnapshot::snapshot_t PIDFSnapshot::capture(const PIDFT<TERMS, T>& pid, uint16_t flags)
+{
+    using PID = PIDFT<TERMS, T>;
+    const typename PID::PIDF_t gains = pid.getPID();
+    snapshot_t snapshot {
+        MAGIC,
+        VERSION,
+        flags,
+        { static_cast<float>(gains.kp), static_cast<float>(gains.ki), static_cast<float>(gains.kd), static_cast<float>(gains.ks), static_cast<float>(gains.kk) },
+        static_cast<float>(pid.getIntegralMax()),
+        static_cast<float>(pid.getIntegralMin()),
+        static_cast<float>(pid.getIntegralThreshold()),
+        static_cast<float>(pid.getOutputSaturationValue()),
+        static_cast<float>(pid.getSampleTime()),
+        (flags & STATE) ? static_cast<float>(pid.getErrorI()) : 0.0F,
+        (flags & STATE) ? static_cast<float>(pid.getPreviousMeasurement()) : 0.0F,
+        (flags & STATE) ? static_cast<float>(pid.getSetpoint()) : 0.0F,
+        0
+    };
+    snapshot.crc = calculateCrc(snapshot);
+    return snapshot;
+}
+
+template <uint32_t TERMS, typename T>
+void PIDFSnapshot::restore(PIDFT<TERMS, T>& pid, const snapshot_t& snapshot)
+{
+    using PID = PIDFT<TERMS, T>;
+    const PIDFBase::PIDF_t& gains = snapshot.pid;
+    pid.setPID(typename PID::PIDF_t { T(gains.kp), T(gains.ki), T(gains.kd), T(gains.ks), T(gains.kk) });
+    if constexpr (PID::HAS_FIXED_RATE) {
+        if (snapshot.sampleTime > 0.0F) { pid.setSampleTime(T(snapshot.sampleTime)); }
+    }
+    if constexpr (PID::HAS_INTEGRAL_LIMIT) {
+        pid.setIntegralMax(T(snapshot.integralMax));
+        pid.setIntegralMin(T(snapshot.integralMin));
+    }
+    if constexpr (PID::HAS_INTEGRAL_THRESHOLD) { pid.setIntegralThreshold(T(snapshot.integralThreshold)); }
+    if constexpr (PID::HAS_OUTPUT_SATURATION) { pid.setOutputSaturationValue(T(snapshot.outputSaturationValue)); }
+    if (snapshot.flags & STATE) {
+        pid.setState(T(snapshot.errorIntegral), T(snapshot.measurementPrevious), T(snapshot.setpoint));
+    }
+}
@@ -0,0 +1,861 @@
+# pragma once
+
+#include "PIDFInstrumentation.h"
+#include "PIDFRecorder.h"
+#include "PIDFSeqlock.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+/*!
+Term selection flags for PIDFT.
+*/
+struct PIDFTerms {
+    static constexpr uint32_t P = 0x01; //!< proportional term
+    static constexpr uint32_t I = 0x02; //!< integral term
+    static constexpr uint32_t D = 0x04; //!< derivative term
+    static constexpr uint32_t S = 0x08; //!< setpoint term
+    static constexpr uint32_t K = 0x10; //!< setpoint derivative term ('kick')
+    static constexpr uint32_t INTEGRAL_THRESHOLD = 0x20; //!< only integrate when the error is above a threshold
+    static constexpr uint32_t INTEGRAL_LIMIT = 0x40; //!< anti-windup via integral clamping
+    static constexpr uint32_t OUTPUT_SATURATION = 0x80; //!< anti-windup by avoiding output saturation
+    static constexpr uint32_t FIXED_RATE = 0x100; //!< fixed sample time, with precomputed coefficients, set using setSampleTime()
+    static constexpr uint32_t ERROR_SNAPSHOT = 0x200; //!< publish the error terms at the end of each update, for reading from another thread or core
+    static constexpr uint32_t RECORDER = 0x400; //!< write a record of each update to a PIDFRecorder, set using setRecorder()
+    static constexpr uint32_t INCREMENTAL = 0x800; //!< velocity (incremental) form update functions, that return the change in output
+    static constexpr uint32_t BACK_CALCULATION = 0x1000; //!< anti-windup by back-calculation (tracking) on output saturation, with gain set using setTrackingGain()
+    static constexpr uint32_t INSTRUMENTATION = 0x2000; //!< record update timing to a PIDFInstrumentation, set using setInstrumentation()
+    static constexpr uint32_t FLUSH_DENORMALS = 0x4000; //!< flush tiny state and inputs to zero, avoiding slow subnormal arithmetic when the error decays towards zero
+
+    static constexpr uint32_t INTEGRAL_ALL = I | INTEGRAL_THRESHOLD | INTEGRAL_LIMIT | OUTPUT_SATURATION;
+    static constexpr uint32_t PI = P | I;
+    static constexpr uint32_t PD = P | D;
+    static constexpr uint32_t PID = P | I | D;
+    //! options included in PIDF only if enabled at build time, since they add to its size and update time
+    static constexpr uint32_t BUILD_OPTIONS = 0
+#if defined(USE_PIDF_ERROR_SNAPSHOT)
+        | ERROR_SNAPSHOT
+#endif
+#if defined(USE_PIDF_RECORDER)
+        | RECORDER
+#endif
+#if defined(USE_PIDF_INCREMENTAL)
+        | INCREMENTAL
+#endif
+#if defined(USE_PIDF_INSTRUMENTATION)
+        | INSTRUMENTATION
+#endif
+#if defined(USE_PIDF_FLUSH_DENORMALS)
+        | FLUSH_DENORMALS
+#endif
+        ;
+    static constexpr uint32_t ALL = P | D | S | K | INTEGRAL_ALL | FIXED_RATE | BUILD_OPTIONS;
+};
+
+/*!
+Types shared by all PIDFT instantiations with the same value type, so that, for example, PIDF::PIDF_t and
+PIDFT<PIDFTerms::PI>::PIDF_t are the same type.
+*/
+template <typename T>
+struct PIDFBaseT {
+    struct PIDF_t {
+        T kp; // proportional gain
+        T ki; // integral gain
+        T kd; // derivative gain
+        T ks; // setpoint gain
+        T kk; // setpoint derivative gain ('kick')
+    };
+    struct error_t {
+        T P;
+        T I;
+        T D;
+        T S;
+        T K;
+    };
+};
+using PIDFBase = PIDFBaseT<float>;
+
+/*!
+Math functions used by PIDFT, for each value type. float and double use the standard library functions.
+Other types (eg _Float16 or a fixed-point wrapper) use the generic versions, which only need comparison and negation,
+or can provide their own overloads.
+*/
+inline float pidfAbs(float x) { return std::fabs(x); }
+inline double pidfAbs(double x) { return std::fabs(x); }
+template <typename T> inline T pidfAbs(T x) { return (x < T(0)) ? -x : x; }
+
+inline bool pidfSignbit(float x) { return std::signbit(x); }
+inline bool pidfSignbit(double x) { return std::signbit(x); }
+//! The sign of a zero is preserved by the conversion to float, so switching integration off is detected for types with a negative zero.
+template <typename T> inline bool pidfSignbit(T x) { return std::signbit(static_cast<float>(x)); }
+
+/*!
+Values tiny enough that their products may be subnormal, ie smaller in magnitude than the square root of the smallest normal
+value (2^-62, about 2e-19, for float), are replaced by a zero of the same sign, other values are unchanged.
+Flushing subnormal values alone is not enough, since the product of two tiny normal values (eg ki*error*deltaT as the error
+decays) is subnormal. Compiles to a compare and select. Types other than float and double are returned unchanged.
+*/
+inline float pidfFlushTiny(float x) { return (std::fabs(x) < 0x1p-62F) ? std::copysign(0.0F, x) : x; }
+inline double pidfFlushTiny(double x) { return (std::fabs(x) < 0x1p-510) ? std::copysign(0.0, x) : x; }
+template <typename T> inline T pidfFlushTiny(T x) { return x; }
+
+// Per-term storage for PIDFT. Each is empty when its term is not selected, so takes no space (empty base optimization).
+template <bool, typename T> struct PIDFT_P {};
+template <typename T> struct PIDFT_P<true, T> { T _kp {0}; };
+
+template <bool, typename T> struct PIDFT_I {};
+template <typename T> struct PIDFT_I<true, T> {
+    T _ki {0};
+    T _kiSaved {0}; //!< saved value of _ki, so integration can be switched on and off
+    T _errorIntegral {0};
+};
+
+template <bool, typename T> struct PIDFT_D {};
+template <typename T> struct PIDFT_D<true, T> { T _kd {0}; T _errorDerivative {0}; };
+
+template <bool, typename T> struct PIDFT_S {};
+template <typename T> struct PIDFT_S<true, T> { T _ks {0}; };
+
+template <bool, typename T> struct PIDFT_K {};
+template <typename T> struct PIDFT_K<true, T> { T _kk {0}; T _setpointDerivative {0}; };
+
+template <bool, typename T> struct PIDFT_IntegralThreshold {};
+template <typename T> struct PIDFT_IntegralThreshold<true, T> {
+    T _integralThreshold {0}; //!< Threshold for PID integration. Can be set to avoid integral wind-up due to movement in motor's backlash zone.
+};
+
+template <bool, typename T> struct PIDFT_IntegralLimit {};
+template <typename T> struct PIDFT_IntegralLimit<true, T> {
+    T _integralMax {0}; //!< Integral windup limit for positive integral
+    T _integralMin {0}; //!< Integral windup limit for negative integral
+};
+
+template <bool, typename T> struct PIDFT_OutputSaturation {};
+template <typename T> struct PIDFT_OutputSaturation<true, T> { T _outputSaturationValue {0}; }; //!< For integral windup control
+
+template <bool, typename T> struct PIDFT_BackCalculation {};
+template <typename T> struct PIDFT_BackCalculation<true, T> {
+    T _trackingGain {0}; //!< back-calculation tracking gain, 0 to use integral limiting on output saturation instead
+    T _trackingGainDeltaT {0}; //!< _trackingGain*_deltaT, for the fixed-rate update functions
+};
+
+template <bool, typename T> struct PIDFT_FixedRate {};
+template <typename T> struct PIDFT_FixedRate<true, T> {
+    T _deltaT {0}; //!< fixed sample time
+    T _deltaTReciprocal {0}; //!< 1/_deltaT, so the derivative calculation is a multiplication rather than a division
+    T _kiDeltaT {0}; //!< discrete integral coefficient, ki*_deltaT
+};
+
+template <bool, typename T> struct PIDFT_ErrorSnapshot {};
+template <typename T> struct PIDFT_ErrorSnapshot<true, T> { PIDFSeqlock<typename PIDFBaseT<T>::error_t> _errorSnapshot; };
+
+// state for the S-term and K-term increments of the incremental form
+template <bool, typename T> struct PIDFT_IncrementalS {};
+template <typename T> struct PIDFT_IncrementalS<true, T> { T _setpointUpdatePrevious {0}; }; //!< setpoint at the previous incremental update
+
+template <bool, typename T> struct PIDFT_IncrementalK {};
+template <typename T> struct PIDFT_IncrementalK<true, T> { T _setpointDerivativePrevious {0}; }; //!< setpoint derivative at the previous incremental update
+
+template <bool> struct PIDFT_Recorder {};
+template <> struct PIDFT_Recorder<true> { PIDFRecorder* _recorder {nullptr}; };
+
+template <bool> struct PIDFT_Instrumentation {};
+template <> struct PIDFT_Instrumentation<true> { PIDFInstrumentation* _instrumentation {nullptr}; };
+
+
+/*!
+PID controller with Feedforward, with the terms selected at compile time.
+
+TERMS is a combination of PIDFTerms flags. Only the state for the selected terms is stored, and the update function
+only contains the calculations and branches for the selected terms, so, for example, `PIDFT<PIDFTerms::PI | PIDFTerms::K>`
+is 40 bytes (rather than the 80 bytes of PIDF) and its update has no derivative calculation, no threshold test, and no saturation test.
+
+The calculation is the same as for PIDF (which is the all-terms instantiation): deselecting a term gives the same result as
+setting its gain (or limit) to zero.
+
+T is the value type of the gains, setpoint, measurement, and output, float by default. It may be double (eg for host-side
+simulation or high precision position loops), _Float16, or a custom numeric type with the arithmetic and comparison operators,
+construction from int, and conversion to float (used by the recorder and pidfSignbit).
+*/
+template <uint32_t TERMS, typename T = float>
+class PIDFT : public PIDFBaseT<T>,
+    private PIDFT_Recorder<(TERMS & PIDFTerms::RECORDER) != 0>, // first, so the pointer does not need padding
+    private PIDFT_Instrumentation<(TERMS & PIDFTerms::INSTRUMENTATION) != 0>,
+    private PIDFT_P<(TERMS & PIDFTerms::P) != 0, T>,
+    private PIDFT_I<(TERMS & PIDFTerms::I) != 0, T>,
+    private PIDFT_D<(TERMS & PIDFTerms::D) != 0, T>,
+    private PIDFT_S<(TERMS & PIDFTerms::S) != 0, T>,
+    private PIDFT_K<(TERMS & PIDFTerms::K) != 0, T>,
+    private PIDFT_IntegralThreshold<(TERMS & PIDFTerms::INTEGRAL_THRESHOLD) != 0, T>,
+    private PIDFT_IntegralLimit<(TERMS & PIDFTerms::INTEGRAL_LIMIT) != 0, T>,
+    private PIDFT_OutputSaturation<(TERMS & PIDFTerms::OUTPUT_SATURATION) != 0, T>,
+    private PIDFT_BackCalculation<(TERMS & PIDFTerms::BACK_CALCULATION) != 0, T>,
+    private PIDFT_FixedRate<(TERMS & PIDFTerms::FIXED_RATE) != 0, T>,
+    private PIDFT_ErrorSnapshot<(TERMS & PIDFTerms::ERROR_SNAPSHOT) != 0, T>,
+    private PIDFT_IncrementalS<(TERMS & PIDFTerms::INCREMENTAL) != 0 && (TERMS & PIDFTerms::S) != 0, T>,
+    private PIDFT_IncrementalK<(TERMS & PIDFTerms::INCREMENTAL) != 0 && (TERMS & PIDFTerms::K) != 0, T>
+{
+public:
+    static constexpr bool HAS_P = (TERMS & PIDFTerms::P) != 0;
+    static constexpr bool HAS_I = (TERMS & PIDFTerms::I) != 0;
+    static constexpr bool HAS_D = (TERMS & PIDFTerms::D) != 0;
+    static constexpr bool HAS_S = (TERMS & PIDFTerms::S) != 0;
+    static constexpr bool HAS_K = (TERMS & PIDFTerms::K) != 0;
+    static constexpr bool HAS_INTEGRAL_THRESHOLD = (TERMS & PIDFTerms::INTEGRAL_THRESHOLD) != 0;
+    static constexpr bool HAS_INTEGRAL_LIMIT = (TERMS & PIDFTerms::INTEGRAL_LIMIT) != 0;
+    static constexpr bool HAS_OUTPUT_SATURATION = (TERMS & PIDFTerms::OUTPUT_SATURATION) != 0;
+    static constexpr bool HAS_FIXED_RATE = (TERMS & PIDFTerms::FIXED_RATE) != 0;
+    static constexpr bool HAS_ERROR_SNAPSHOT = (TERMS & PIDFTerms::ERROR_SNAPSHOT) != 0;
+    static constexpr bool HAS_RECORDER = (TERMS & PIDFTerms::RECORDER) != 0;
+    static constexpr bool HAS_INCREMENTAL = (TERMS & PIDFTerms::INCREMENTAL) != 0;
+    static constexpr bool HAS_BACK_CALCULATION = (TERMS & PIDFTerms::BACK_CALCULATION) != 0;
+    static constexpr bool HAS_INSTRUMENTATION = (TERMS & PIDFTerms::INSTRUMENTATION) != 0;
+    static constexpr bool HAS_FLUSH_DENORMALS = (TERMS & PIDFTerms::FLUSH_DENORMALS) != 0;
+    static_assert(HAS_I || (TERMS & PIDFTerms::INTEGRAL_ALL) == 0, "integral threshold, limit and output saturation require the I-term");
+    static_assert(HAS_OUTPUT_SATURATION || !HAS_BACK_CALCULATION, "back-calculation requires output saturation");
+    using value_type = T;
+    using PIDF_t = typename PIDFBaseT<T>::PIDF_t;
+    using error_t = typename PIDFBaseT<T>::error_t;
+public:
+    explicit PIDFT(const PIDF_t& pid) { setPID(pid); }
+    PIDFT() = default;
+public:
+    inline void setP(T p) { static_assert(HAS_P, "no P-term"); this->_kp = p; }
+    inline void setI(T i) { static_assert(HAS_I, "no I-term"); this->_ki = i; this->_kiSaved = i; updateCoefficients(); }
+    inline void setD(T d) { static_assert(HAS_D, "no D-term"); this->_kd = d; }
+    inline void setS(T s) { static_assert(HAS_S, "no S-term"); this->_ks = s; }
+    inline void setK(T k) { static_assert(HAS_K, "no K-term"); this->_kk = k; }
+    //! Sets the gains of the selected terms, gains for terms that are not selected are ignored.
+    inline void setPID(const PIDF_t& pid) {
+        if constexpr (HAS_P) { this->_kp = pid.kp; }
+        if constexpr (HAS_I) { this->_ki = pid.ki; this->_kiSaved = pid.ki; }
+        if constexpr (HAS_D) { this->_kd = pid.kd; }
+        if constexpr (HAS_S) { this->_ks = pid.ks; }
+        if constexpr (HAS_K) { this->_kk = pid.kk; }
+        updateCoefficients();
+    }
+    inline T getP() const { if constexpr (HAS_P) { return this->_kp; } else { return T(0); } }
+    inline T getI() const { if constexpr (HAS_I) { return this->_kiSaved; } else { return T(0); } } // returns the set value of ki, whether integration is turned on or not
+    inline T getD() const { if constexpr (HAS_D) { return this->_kd; } else { return T(0); } }
+    inline T getS() const { if constexpr (HAS_S) { return this->_ks; } else { return T(0); } }
+    inline T getK() const { if constexpr (HAS_K) { return this->_kk; } else { return T(0); } }
+    inline const PIDF_t getPID() const { return PIDF_t { getP(), getI(), getD(), getS(), getK() }; }  // returns the set value of ki, whether integration is turned on or not
+
+    inline void resetIntegral() { if constexpr (HAS_I) { this->_errorIntegral = T(0); } }
+    // when integration is switched off, _ki is set to negative zero, so that switched off can be distinguished from a ki of zero
+    inline void switchIntegrationOff() { static_assert(HAS_I, "no I-term"); if (isIntegrationOn()) { this->_kiSaved = this->_ki; } this->_ki = -T(0); this->_errorIntegral = T(0); updateCoefficients(); }
+    inline void switchIntegrationOn() { static_assert(HAS_I, "no I-term"); this->_ki = this->_kiSaved; this->_errorIntegral = T(0); updateCoefficients(); }
+    inline bool isIntegrationOn() const { if constexpr (HAS_I) { return this->_ki != T(0) || !pidfSignbit(this->_ki); } else { return false; } }
+
+    /*!
+    Sets the gains of the selected terms, for use by a gain scheduler.
+    Unlike setPID, does not switch integration on: if integration is switched off then the new ki is saved and used
+    when integration is switched back on. The integral is not changed, and since it is stored already multiplied by ki,
+    changing ki does not cause a jump in the output.
+    */
+    inline void setScheduledPID(const PIDF_t& pid) {
+        if constexpr (HAS_P) { this->_kp = pid.kp; }
+        if constexpr (HAS_I) {
+            if (isIntegrationOn()) { this->_ki = pid.ki; }
+            this->_kiSaved = pid.ki;
+        }
+        if constexpr (HAS_D) { this->_kd = pid.kd; }
+        if constexpr (HAS_S) { this->_ks = pid.ks; }
+        if constexpr (HAS_K) { this->_kk = pid.kk; }
+        updateCoefficients();
+    }
+
+    /*!
+    Set the sample time for the fixed-rate update functions, ie those without a deltaT parameter.
+    The discrete coefficients are recalculated whenever the sample time or the gains change, so the fixed-rate
+    updates use only multiplications and additions. The gain getters continue to return the continuous-time gains.
+    The sample time must be set before the first fixed-rate update: until it is, the I and D terms are zero.
+    A deltaT that is not positive (including NaN) is ignored, and the previous sample time is kept.
+    */
+    inline void setSampleTime(T deltaT) {
+        static_assert(HAS_FIXED_RATE, "no fixed rate");
+        if (!(deltaT > T(0))) {
+            return;
+        }
+        this->_deltaT = deltaT;
+        this->_deltaTReciprocal = T(1) / deltaT;
+        updateCoefficients();
+    }
+    inline T getSampleTime() const { if constexpr (HAS_FIXED_RATE) { return this->_deltaT; } else { return T(0); } }
+
+    inline void setIntegralMax(T integralMax) { static_assert(HAS_INTEGRAL_LIMIT, "no integral limit"); this->_integralMax = integralMax; }
+    inline void setIntegralMin(T integralMin) { static_assert(HAS_INTEGRAL_LIMIT, "no integral limit"); this->_integralMin = integralMin; }
+    inline void setIntegralLimit(T integralLimit) { setIntegralMax(integralLimit); setIntegralMin(-integralLimit); }
+    inline void setIntegralThreshold(T integralThreshold) { static_assert(HAS_INTEGRAL_THRESHOLD, "no integral threshold"); this->_integralThreshold = integralThreshold; }
+    inline void setOutputSaturationValue(T outputSaturationValue) { static_assert(HAS_OUTPUT_SATURATION, "no output saturation"); this->_outputSaturationValue = outputSaturationValue; }
+    inline T getIntegralMax() const { if constexpr (HAS_INTEGRAL_LIMIT) { return this->_integralMax; } else { return T(0); } }
+    inline T getIntegralMin() const { if constexpr (HAS_INTEGRAL_LIMIT) { return this->_integralMin; } else { return T(0); } }
+    inline T getIntegralThreshold() const { if constexpr (HAS_INTEGRAL_THRESHOLD) { return this->_integralThreshold; } else { return T(0); } }
+    inline T getOutputSaturationValue() const { if constexpr (HAS_OUTPUT_SATURATION) { return this->_outputSaturationValue; } else { return T(0); } }
+    /*!
+    Set the tracking gain for back-calculation anti-windup. When the output (partial sum plus integral) is beyond the
+    output saturation value, trackingGain*(saturatedOutput - output)*deltaT is added to the integral, so the integral
+    tracks the saturated output with time constant 1/trackingGain, rather than being limited immediately.
+    A tracking gain of zero uses integral limiting on output saturation, as without PIDFTerms::BACK_CALCULATION.
+    */
+    inline void setTrackingGain(T trackingGain) { static_assert(HAS_BACK_CALCULATION, "no back-calculation"); this->_trackingGain = trackingGain; updateCoefficients(); }
+    inline T getTrackingGain() const { if constexpr (HAS_BACK_CALCULATION) { return this->_trackingGain; } else { return T(0); } }
+
+    inline void setSetpoint(T setpoint) { _setpointPrevious = _setpoint; _setpoint = setpoint; }
+    inline void setSetpoint(T setpoint, T deltaT) {
+        _setpointPrevious = _setpoint;
+        _setpoint = setpoint;
+        if constexpr (HAS_K) { this->_setpointDerivative = (_setpoint - _setpointPrevious)/deltaT; }
+    }
+    inline void setSetpointDerivative(T setpointDerivative) { static_assert(HAS_K, "no K-term"); this->_setpointDerivative = setpointDerivative; }
+
+    inline T getSetpoint() const { return _setpoint; }
+    inline T getPreviousSetpoint() const { return _setpointPrevious; }
+    inline T getSetpointDelta() const { return _setpoint - _setpointPrevious; }
+
+    inline T getPreviousMeasurement() const { return _measurementPrevious; } //!< get previous measurement, useful for DTerm filtering
+
+    /*!
+    Restore a saved state, eg from a PIDFSnapshot, so the controller warm-starts rather than starting with a zero integral.
+    The previous measurement is restored so the first update has no derivative kick. The derivative and setpoint derivative
+    are set to zero, and the integral is ignored if there is no I-term.
+    */
+    inline void setState(T errorIntegral, T measurementPrevious, T setpoint) {
+        if constexpr (HAS_I) { this->_errorIntegral = errorIntegral; } else { (void)errorIntegral; }
+        if constexpr (HAS_D) { this->_errorDerivative = T(0); }
+        if constexpr (HAS_K) { this->_setpointDerivative = T(0); }
+        if constexpr (HAS_INCREMENTAL && HAS_S) { this->_setpointUpdatePrevious = setpoint; }
+        if constexpr (HAS_INCREMENTAL && HAS_K) { this->_setpointDerivativePrevious = T(0); }
+        _measurementPrevious = measurementPrevious;
+        _setpoint = setpoint;
+        _setpointPrevious = setpoint;
+        _errorPrevious = setpoint - measurementPrevious;
+    }
+
+    inline T update(T measurement, T deltaT) {
+        measurement = flushDenormal(measurement);
+        return updateDelta(measurement, measurement - _measurementPrevious, deltaT);
+    }
+    inline T updateDelta(T measurement, T measurementDelta, T deltaT) {
+        return updateDeltaITerm(measurement, measurementDelta, _setpoint - measurement, deltaT);
+    }
+
+    T updateDeltaITerm(T measurement, T measurementDelta, T iTermError, T deltaT);
+
+    // fixed-rate update functions, using the sample time set by setSampleTime(), which must be called first
+    inline T update(T measurement) {
+        measurement = flushDenormal(measurement);
+        return updateDelta(measurement, measurement - _measurementPrevious);
+    }
+    inline T updateDelta(T measurement, T measurementDelta) {
+        return updateDeltaITerm(measurement, measurementDelta, _setpoint - measurement);
+    }
+    inline T updateDeltaITerm(T measurement, T measurementDelta, T iTermError) {
+        return updateTermsFixedRate<TERMS>(measurement, measurementDelta, iTermError);
+    }
+
+    /*!
+    Block update functions, for running the controller over a time series (eg for replay, simulation, or block-based processing).
+    Each gives exactly the same outputs, and leaves the controller in exactly the same state, as calling, for each sample,
+    `setSetpoint(setpoints[ii])` and then the corresponding scalar update function, eg `outputs[ii] = update(measurements[ii], deltaT)`.
+    setpoints may be nullptr, to keep the current setpoint for the whole block.
+
+    The controller is copied to a local for the block, so its state is held in registers rather than being stored and reloaded
+    at every sample. (With PIDFTerms::ERROR_SNAPSHOT every update must publish to the controller's own snapshot, so the scalar
+    update functions are called instead.)
+    */
+    void updateBlock(const T* measurements, const T* setpoints, T deltaT, T* outputs, size_t count) {
+        updateBlockKernel<false>(measurements, nullptr, nullptr, setpoints, deltaT, outputs, count);
+    }
+    void updateDeltaBlock(const T* measurements, const T* measurementDeltas, const T* setpoints, T deltaT, T* outputs, size_t count) { // NOLINT(bugprone-easily-swappable-parameters)
+        updateBlockKernel<false>(measurements, measurementDeltas, nullptr, setpoints, deltaT, outputs, count);
+    }
+    void updateDeltaITermBlock(const T* measurements, const T* measurementDeltas, const T* iTermErrors, const T* setpoints, T deltaT, T* outputs, size_t count) { // NOLINT(bugprone-easily-swappable-parameters)
+        updateBlockKernel<false>(measurements, measurementDeltas, iTermErrors, setpoints, deltaT, outputs, count);
+    }
+    // fixed-rate block update functions, using the sample time set by setSampleTime()
+    void updateBlock(const T* measurements, const T* setpoints, T* outputs, size_t count) {
+        updateBlockKernel<true>(measurements, nullptr, nullptr, setpoints, T(0), outputs, count);
+    }
+    void updateDeltaBlock(const T* measurements, const T* measurementDeltas, const T* setpoints, T* outputs, size_t count) { // NOLINT(bugprone-easily-swappable-parameters)
+        updateBlockKernel<true>(measurements, measurementDeltas, nullptr, setpoints, T(0), outputs, count);
+    }
+    void updateDeltaITermBlock(const T* measurements, const T* measurementDeltas, const T* iTermErrors, const T* setpoints, T* outputs, size_t count) { // NOLINT(bugprone-easily-swappable-parameters)
+        updateBlockKernel<true>(measurements, measurementDeltas, iTermErrors, setpoints, T(0), outputs, count);
+    }
+#if defined(__cpp_lib_span)
+    // span versions, the number of samples is the size of outputs, and setpoints may be empty
+    void updateBlock(std::span<const T> measurements, std::span<const T> setpoints, T deltaT, std::span<T> outputs) {
+        updateBlock(measurements.data(), setpoints.empty() ? nullptr : setpoints.data(), deltaT, outputs.data(), outputs.size());
+    }
+    void updateDeltaBlock(std::span<const T> measurements, std::span<const T> measurementDeltas, std::span<const T> setpoints, T deltaT, std::span<T> outputs) {
+        updateDeltaBlock(measurements.data(), measurementDeltas.data(), setpoints.empty() ? nullptr : setpoints.data(), deltaT, outputs.data(), outputs.size());
+    }
+    void updateDeltaITermBlock(std::span<const T> measurements, std::span<const T> measurementDeltas, std::span<const T> iTermErrors, std::span<const T> setpoints, T deltaT, std::span<T> outputs) {
+        updateDeltaITermBlock(measurements.data(), measurementDeltas.data(), iTermErrors.data(), setpoints.empty() ? nullptr : setpoints.data(), deltaT, outputs.data(), outputs.size());
+    }
+    void updateBlock(std::span<const T> measurements, std::span<const T> setpoints, std::span<T> outputs) {
+        updateBlock(measurements.data(), setpoints.empty() ? nullptr : setpoints.data(), outputs.data(), outputs.size());
+    }
+    void updateDeltaBlock(std::span<const T> measurements, std::span<const T> measurementDeltas, std::span<const T> setpoints, std::span<T> outputs) {
+        updateDeltaBlock(measurements.data(), measurementDeltas.data(), setpoints.empty() ? nullptr : setpoints.data(), outputs.data(), outputs.size());
+    }
+    void updateDeltaITermBlock(std::span<const T> measurements, std::span<const T> measurementDeltas, std::span<const T> iTermErrors, std::span<const T> setpoints, std::span<T> outputs) {
+        updateDeltaITermBlock(measurements.data(), measurementDeltas.data(), iTermErrors.data(), setpoints.empty() ? nullptr : setpoints.data(), outputs.data(), outputs.size());
+    }
+#endif
+
+    /*!
+    Velocity (incremental) form update functions, for actuators that take incremental commands.
+    Return the change in output, calculated from the change in each term's input multiplied by its current gain:
+    `deltaOutput = kp*deltaError + ki*error*deltaT + kd*deltaErrorDerivative + ks*deltaSetpoint + kk*deltaSetpointDerivative`
+    so changing the gains (eg with setPID) does not cause a jump in the output. The accumulated output is held by the
+    actuator, so there is no integral to wind up, and the integral limit and output saturation value are not used
+    (the integral threshold is). The error getters still return the contribution of each term, with getErrorI() returning
+    the sum of the I-term increments, and the recorded output (if recording) is the change in output.
+    Requires PIDFTerms::INCREMENTAL (for PIDF, build with USE_PIDF_INCREMENTAL defined).
+    */
+    inline T updateIncremental(T measurement, T deltaT) {
+        measurement = flushDenormal(measurement);
+        return updateDeltaIncremental(measurement, measurement - _measurementPrevious, deltaT);
+    }
+    inline T updateDeltaIncremental(T measurement, T measurementDelta, T deltaT) {
+        T kiError {};
+        if constexpr (HAS_I) { kiError = this->_ki*flushDenormal(_setpoint - measurement); }
+        return updateIncrementalKernel(measurement, -flushDenormal(measurementDelta) / deltaT, kiError, deltaT);
+    }
+    // fixed-rate incremental update functions, using the sample time set by setSampleTime()
+    inline T updateIncremental(T measurement) {
+        measurement = flushDenormal(measurement);
+        return updateDeltaIncremental(measurement, measurement - _measurementPrevious);
+    }
+    inline T updateDeltaIncremental(T measurement, T measurementDelta) {
+        static_assert(HAS_FIXED_RATE, "no fixed rate");
+        T kiDeltaT {};
+        if constexpr (HAS_I) { kiDeltaT = this->_kiDeltaT; }
+        return updateIncrementalKernel(measurement, -flushDenormal(measurementDelta) * this->_deltaTReciprocal, kiDeltaT, flushDenormal(_setpoint - measurement));
+    }
+
+    // accessor functions to obtain error values
+    error_t getError() const;
+    error_t getErrorRaw() const;
+    inline T getErrorP() const { return _errorPrevious*getP(); }
+    inline T getErrorI() const { if constexpr (HAS_I) { return this->_errorIntegral; } else { return T(0); } } // _erroIntegral is already multiplied by ki
+    inline T getErrorD() const { if constexpr (HAS_D) { return this->_errorDerivative*this->_kd; } else { return T(0); } }
+    inline T getErrorS() const { return _setpoint*getS(); }
+    inline T getErrorK() const { return getErrorRawK()*getK(); }
+
+    inline T getErrorRawP() const { return _errorPrevious; }
+    inline T getErrorRawI() const { if constexpr (HAS_I) { return (this->_ki == T(0)) ? T(0) : this->_errorIntegral / this->_ki; } else { return T(0); } }
+    inline T getErrorRawD() const { if constexpr (HAS_D) { return this->_errorDerivative; } else { return T(0); } }
+    inline T getErrorRawS() const { return _setpoint; }
+    inline T getErrorRawK() const { if constexpr (HAS_K) { return this->_setpointDerivative; } else { return T(0); } }
+
+    inline T getPreviousError() const { return _errorPrevious; } //!< get previous error, for test code
+
+    /*!
+    Consistent snapshot of the error terms, as published at the end of the most recent update.
+    Safe to call from another thread or core while the update is in progress: never returns a mix of old and new values
+    and never blocks the update. Requires PIDFTerms::ERROR_SNAPSHOT (for PIDF, build with USE_PIDF_ERROR_SNAPSHOT defined).
+    */
+    inline error_t getErrorSnapshot() const { static_assert(HAS_ERROR_SNAPSHOT, "no error snapshot"); return this->_errorSnapshot.read(); }
+    inline bool tryGetErrorSnapshot(error_t& error) const { static_assert(HAS_ERROR_SNAPSHOT, "no error snapshot"); return this->_errorSnapshot.tryRead(error); }
+
+    /*!
+    Set the recorder that each update writes a record to, or nullptr to stop recording. The record contains the setpoint,
+    the measurement, the P, I, D, S, and K contributions (as returned by getError), and the output, converted to float.
+    Requires PIDFTerms::RECORDER (for PIDF, build with USE_PIDF_RECORDER defined).
+    Note that PIDF::updateSKPI adds the K-term after the record is written, so the recorded output does not include it.
+    */
+    inline void setRecorder(PIDFRecorder* recorder) { static_assert(HAS_RECORDER, "no recorder"); this->_recorder = recorder; }
+    inline PIDFRecorder* getRecorder() const { if constexpr (HAS_RECORDER) { return this->_recorder; } else { return nullptr; } }
+
+    /*!
+    Set the instrumentation that each update records its timing to, or nullptr to stop recording.
+    The update calculation is timed, and the interval between the starts of successive updates is recorded as the actual deltaT.
+    Requires PIDFTerms::INSTRUMENTATION (for PIDF, build with USE_PIDF_INSTRUMENTATION defined).
+    */
+    inline void setInstrumentation(PIDFInstrumentation* instrumentation) { static_assert(HAS_INSTRUMENTATION, "no instrumentation"); this->_instrumentation = instrumentation; }
+    inline PIDFInstrumentation* getInstrumentation() const { if constexpr (HAS_INSTRUMENTATION) { return this->_instrumentation; } else { return nullptr; } }
+
+    void resetAll(); //!< reset all, for test code
+protected:
+    template <uint32_t KERNEL>
+    T updateTerms(T measurement, T measurementDelta, T iTermError, T deltaT);
+    template <uint32_t KERNEL>
+    T updateTermsFixedRate(T measurement, T measurementDelta, T iTermError);
+private:
+    template <uint32_t KERNEL>
+    T updateTermsKernel(T measurement, T errorDerivative, T integralFactor, T integralMultiplier, T trackingFactor);
+    T updateIncrementalKernel(T measurement, T errorDerivative, T integralFactor, T integralMultiplier);
+    template <bool FIXED_RATE_BLOCK>
+    void updateBlockKernel(const T* measurements, const T* measurementDeltas, const T* iTermErrors, const T* setpoints, T deltaT, T* outputs, size_t count);
+    //! With PIDFTerms::FLUSH_DENORMALS, flush a tiny value to zero, so neither it nor its products are subnormal.
+    static inline T flushDenormal(T x) { if constexpr (HAS_FLUSH_DENORMALS) { return pidfFlushTiny(x); } else { return x; } }
+    inline void updateCoefficients() {
+        if constexpr (HAS_FIXED_RATE && HAS_I) { this->_kiDeltaT = this->_ki*this->_deltaT; }
+        if constexpr (HAS_FIXED_RATE && HAS_BACK_CALCULATION) { this->_trackingGainDeltaT = this->_trackingGain*this->_deltaT; }
+    }
+private:
+    T _measurementPrevious {0};
+    T _setpoint {0};
+    T _setpointPrevious {0};
+    T _errorPrevious {0};
+};
+
+
+template <uint32_t TERMS, typename T>
+typename PIDFT<TERMS, T>::error_t PIDFT<TERMS, T>::getError() const
+{
+    return error_t {
+        .P = getErrorP(),
+        .I = getErrorI(), // _erroIntegral is already multiplied by ki
+        .D = getErrorD(),
+        .S = getErrorS(),
+        .K = getErrorK()
+    };
+}
+
+template <uint32_t TERMS, typename T>
+typename PIDFT<TERMS, T>::error_t PIDFT<TERMS, T>::getErrorRaw() const
+{
+    return error_t {
+        .P = getErrorRawP(),
+        .I = getErrorRawI(),
+        .D = getErrorRawD(),
+        .S = getErrorRawS(),
+        .K = getErrorRawK()
+    };
+}
+
+template <uint32_t TERMS, typename T>
+void PIDFT<TERMS, T>::resetAll()
+{
+    _setpoint = T(0);
+    _setpointPrevious = T(0);
+    if constexpr (HAS_K) { this->_setpointDerivative = T(0); }
+    if constexpr (HAS_D) { this->_errorDerivative = T(0); }
+    if constexpr (HAS_I) { this->_errorIntegral = T(0); }
+    if constexpr (HAS_INCREMENTAL && HAS_S) { this->_setpointUpdatePrevious = T(0); }
+    if constexpr (HAS_INCREMENTAL && HAS_K) { this->_setpointDerivativePrevious = T(0); }
+    _errorPrevious = T(0);
+    _measurementPrevious = T(0);
+}
+
+/*!
+Calculate PID output using the provided measurementRate and ITerm error.
+This allows the measurementRate to be filtered and the ITerm error to be attenuated
+before the PID update is called.
+*/
+template <uint32_t TERMS, typename T>
+T PIDFT<TERMS, T>::updateDeltaITerm(T measurement, T measurementDelta, T iTermError, T deltaT) // NOLINT(bugprone-easily-swappable-parameters)
+{
+    return updateTerms<TERMS>(measurement, measurementDelta, iTermError, deltaT);
+}
+
+/*!
+PID calculation for the subset KERNEL of the controller's terms, with a variable sample time deltaT.
+Terms not in KERNEL are neither calculated nor have their state updated.
+*/
+template <uint32_t TERMS, typename T>
+template <uint32_t KERNEL>
+T PIDFT<TERMS, T>::updateTerms(T measurement, T measurementDelta, T iTermError, T deltaT) // NOLINT(bugprone-easily-swappable-parameters)
+{
+    T errorDerivative {};
+    if constexpr ((KERNEL & PIDFTerms::D) != 0) {
+        errorDerivative = -flushDenormal(measurementDelta) / deltaT; // note minus sign, error delta has reverse polarity to measurement delta
+    }
+    T kiError {};
+    if constexpr ((KERNEL & PIDFTerms::I) != 0) {
+        kiError = this->_ki*flushDenormal(iTermError);
+        //kiError = _ki*0.5F*(iTermError + _errorPrevious); // integration using trapezoid rule
+    }
+    T trackingFactor {};
+    if constexpr ((KERNEL & PIDFTerms::BACK_CALCULATION) != 0) {
+        trackingFactor = this->_trackingGain*deltaT;
+    }
+    // Euler integration, integral increment is kiError*deltaT
+    return updateTermsKernel<KERNEL>(measurement, errorDerivative, kiError, deltaT, trackingFactor);
+}
+
+/*!
+PID calculation for the subset KERNEL of the controller's terms, with the fixed sample time set by setSampleTime().
+The division by deltaT is replaced by multiplication by its precomputed reciprocal, and ki*deltaT is precomputed.
+*/
+template <uint32_t TERMS, typename T>
+template <uint32_t KERNEL>
+T PIDFT<TERMS, T>::updateTermsFixedRate(T measurement, T measurementDelta, T iTermError) // NOLINT(bugprone-easily-swappable-parameters)
+{
+    static_assert(HAS_FIXED_RATE, "no fixed rate");
+    T errorDerivative {};
+    if constexpr ((KERNEL & PIDFTerms::D) != 0) {
+        errorDerivative = -flushDenormal(measurementDelta) * this->_deltaTReciprocal; // note minus sign, error delta has reverse polarity to measurement delta
+    }
+    T kiDeltaT {};
+    if constexpr ((KERNEL & PIDFTerms::I) != 0) {
+        kiDeltaT = this->_kiDeltaT;
+    }
+    T trackingFactor {};
+    if constexpr ((KERNEL & PIDFTerms::BACK_CALCULATION) != 0) {
+        trackingFactor = this->_trackingGainDeltaT;
+    }
+    // Euler integration, integral increment is kiDeltaT*iTermError
+    return updateTermsKernel<KERNEL>(measurement, errorDerivative, kiDeltaT, flushDenormal(iTermError), trackingFactor);
+}
+
+/*!
+The update calculation common to the variable-rate and fixed-rate update functions.
+The integral is incremented by integralFactor*integralMultiplier, and trackingFactor is the back-calculation tracking gain*deltaT.
+
+The integral limit and output saturation tests are written as selects rather than branches, so they compile to conditional
+moves and min/max instructions, which do not mispredict when the output is close to saturation.
+With PIDFTerms::FLUSH_DENORMALS the measurement, the error, the derivative, and the integral are flushed to zero when they are
+tiny (as are the measurement delta and I-term error, by the callers), so neither the state nor the arithmetic is ever subnormal.
+*/
+template <uint32_t TERMS, typename T>
+template <uint32_t KERNEL>
+T PIDFT<TERMS, T>::updateTermsKernel(T measurement, T errorDerivative, T integralFactor, T integralMultiplier, T trackingFactor) // NOLINT(bugprone-easily-swappable-parameters)
+{
+    static_assert((KERNEL & ~TERMS) == 0, "kernel terms must be a subset of the controller terms");
+    constexpr bool P = (KERNEL & PIDFTerms::P) != 0;
+    constexpr bool I = (KERNEL & PIDFTerms::I) != 0;
+    constexpr bool D = (KERNEL & PIDFTerms::D) != 0;
+    constexpr bool S = (KERNEL & PIDFTerms::S) != 0;
+    constexpr bool K = (KERNEL & PIDFTerms::K) != 0;
+
+    uint32_t instrumentationStart = 0;
+    if constexpr (HAS_INSTRUMENTATION) {
+        if (this->_instrumentation != nullptr) { instrumentationStart = pidfCycleCount(); }
+    }
+    measurement = flushDenormal(measurement);
+    _measurementPrevious = measurement;
+    const T error = flushDenormal(_setpoint - measurement);
+    if constexpr (D) {
+        this->_errorDerivative = flushDenormal(errorDerivative);
+    } else {
+        (void)errorDerivative;
+    }
+    // Partial PID sum, excludes ITerm
+    // has additional S setpoint(openloop) and F feedforward(setpoint derivative) terms
+    // -T(0) is the additive identity, so the sum is the same as if only the selected terms were written out
+    //                                  P               +  D                                     + S                      + K (no ITerm)
+    T partialSum = -T(0);
+    if constexpr (P) { partialSum += this->_kp*error; }
+    if constexpr (D) { partialSum += this->_kd*this->_errorDerivative; }
+    if constexpr (S) { partialSum += this->_ks*_setpoint; }
+    if constexpr (K) { partialSum += this->_kk*this->_setpointDerivative; }
+
+    if constexpr (I) {
+        bool integrate = true;
+        if constexpr ((KERNEL & PIDFTerms::INTEGRAL_THRESHOLD) != 0) {
+            integrate = this->_integralThreshold == T(0) || pidfAbs(error) >= this->_integralThreshold;
+        }
+        if (integrate) {
+            // "integrate" the error
+            this->_errorIntegral = flushDenormal(this->_errorIntegral + integralFactor*integralMultiplier);
+            if constexpr ((KERNEL & PIDFTerms::INTEGRAL_LIMIT) != 0) {
+                // Anti-windup via integral clamping
+                // (if the integral is clamped to _integralMax it is not below _integralMin, so this is the same as an if-else)
+                const T integral = this->_errorIntegral;
+                const T clampedMax = ((this->_integralMax > T(0)) & (integral > this->_integralMax)) ? this->_integralMax : integral;
+                this->_errorIntegral = ((this->_integralMin < T(0)) & (clampedMax < this->_integralMin)) ? this->_integralMin : clampedMax;
+            }
+        }
+    }
+    _errorPrevious = error;
+
+    if constexpr (I && (KERNEL & PIDFTerms::OUTPUT_SATURATION) != 0) {
+        // Anti-windup by avoiding output saturation.
+        // Check if partialSum + _errorIntegral saturates the output
+        // If so, the excess value above saturation does not help convergence to the setpoint and will result in
+        // overshoot when the P value eventually comes down.
+        // So limit the _errorIntegral to a value that avoids output saturation.
+        const T saturationValue = this->_outputSaturationValue;
+        const T upper = saturationValue - partialSum;
+        const T lower = -saturationValue - partialSum;
+        const T integral = this->_errorIntegral;
+        // std::max(x, T(0)) and std::min(x, T(0)) give the same result as std::fmax and std::fmin (for non-NaN x), including the sign of a zero result
+        T limited = (integral > upper) ? std::max(upper, T(0)) : ((integral < lower) ? std::min(lower, T(0)) : integral);
+        if constexpr ((KERNEL & PIDFTerms::BACK_CALCULATION) != 0) {
+            // Back-calculation: rather than being limited immediately, the integral tracks the saturated output
+            const T unsaturated = partialSum + integral;
+            const T saturated = std::min(std::max(unsaturated, -saturationValue), saturationValue);
+            limited = (this->_trackingGain > T(0)) ? flushDenormal(integral + trackingFactor*(saturated - unsaturated)) : limited;
+        } else {
+            (void)trackingFactor;
+        }
+        this->_errorIntegral = (saturationValue > T(0)) ? limited : integral;
+    } else {
+        (void)trackingFactor;
+    }
+
+    // The PID calculation with additional S setpoint(openloop) and F feedforward(setpoint derivative) terms
+    //                   P+D+S+F    +  I
+    T output = partialSum;
+    if constexpr (I) {
+        output = partialSum + this->_errorIntegral;
+    } else {
+        (void)integralFactor;
+        (void)integralMultiplier;
+    }
+
+    if constexpr (HAS_ERROR_SNAPSHOT) {
+        this->_errorSnapshot.publish(getError());
+    }
+    if constexpr (HAS_RECORDER) {
+        if (this->_recorder != nullptr) {
+            const error_t e = getError();
+            this->_recorder->record({
+                static_cast<float>(_setpoint), static_cast<float>(measurement),
+                static_cast<float>(e.P), static_cast<float>(e.I), static_cast<float>(e.D), static_cast<float>(e.S), static_cast<float>(e.K),
+                static_cast<float>(output)
+            });
+        }
+    }
+    if constexpr (HAS_INSTRUMENTATION) {
+        if (this->_instrumentation != nullptr) { this->_instrumentation->record(instrumentationStart, pidfCycleCount()); }
+    } else {
+        (void)instrumentationStart;
+    }
+
+    return output;
+}
+
+/*!
+The block update calculation. measurementDeltas and iTermErrors may be nullptr, in which case they are calculated as by
+update and updateDelta. The kernel is run for each sample on a local copy of the controller, which is copied back at the end.
+
+The stateless inputs to the kernel (the derivative and the I-term input) are calculated in the same loop as the kernel rather
+than in a separate pass, since the update is bound by the integral's loop-carried dependency, and a separate pass was slower.
+*/
+template <uint32_t TERMS, typename T>
+template <bool FIXED_RATE_BLOCK>
+void PIDFT<TERMS, T>::updateBlockKernel(const T* measurements, const T* measurementDeltas, const T* iTermErrors, const T* setpoints, T deltaT, T* outputs, size_t count) // NOLINT(bugprone-easily-swappable-parameters,readability-function-cognitive-complexity)
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    static_assert(!FIXED_RATE_BLOCK || HAS_FIXED_RATE, "no fixed rate");
+    if constexpr (HAS_ERROR_SNAPSHOT) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            if (setpoints != nullptr) { setSetpoint(setpoints[ii]); }
+            const T measurementDelta = (measurementDeltas != nullptr) ? measurementDeltas[ii] : measurements[ii] - _measurementPrevious;
+            const T iTermError = (iTermErrors != nullptr) ? iTermErrors[ii] : _setpoint - measurements[ii];
+            if constexpr (FIXED_RATE_BLOCK) {
+                outputs[ii] = updateTermsFixedRate<TERMS>(measurements[ii], measurementDelta, iTermError);
+            } else {
+                outputs[ii] = updateTerms<TERMS>(measurements[ii], measurementDelta, iTermError, deltaT);
+            }
+        }
+    } else {
+        // local copy, which the outputs cannot alias, so its state can be kept in registers
+        PIDFT pid(*this);
+        T integralConstant {}; // deltaT, or kiDeltaT for fixed rate
+        T trackingFactor {};
+        if constexpr (FIXED_RATE_BLOCK) {
+            if constexpr (HAS_I) { integralConstant = this->_kiDeltaT; }
+            if constexpr (HAS_BACK_CALCULATION) { trackingFactor = this->_trackingGainDeltaT; }
+        } else {
+            integralConstant = deltaT;
+            if constexpr (HAS_BACK_CALCULATION) { trackingFactor = this->_trackingGain*deltaT; }
+        }
+        T measurementPrevious = _measurementPrevious;
+        for (size_t ii = 0; ii < count; ++ii) {
+            const T measurement = flushDenormal(measurements[ii]);
+            if (setpoints != nullptr) { pid.setSetpoint(setpoints[ii]); }
+            const T setpoint = pid._setpoint;
+            T errorDerivative {};
+            if constexpr (HAS_D) {
+                const T measurementDelta = (measurementDeltas != nullptr) ? measurementDeltas[ii] : measurement - measurementPrevious;
+                if constexpr (FIXED_RATE_BLOCK) { errorDerivative = -flushDenormal(measurementDelta) * this->_deltaTReciprocal; } else { errorDerivative = -flushDenormal(measurementDelta) / deltaT; }
+            }
+            T integralInput {};
+            if constexpr (HAS_I) {
+                const T iTermError = flushDenormal((iTermErrors != nullptr) ? iTermErrors[ii] : setpoint - measurement);
+                if constexpr (FIXED_RATE_BLOCK) { integralInput = iTermError; } else { integralInput = this->_ki*iTermError; }
+            }
+            if constexpr (FIXED_RATE_BLOCK) {
+                outputs[ii] = pid.template updateTermsKernel<TERMS>(measurement, errorDerivative, integralConstant, integralInput, trackingFactor);
+            } else {
+                outputs[ii] = pid.template updateTermsKernel<TERMS>(measurement, errorDerivative, integralInput, integralConstant, trackingFactor);
+            }
+            measurementPrevious = measurement;
+        }
+        *this = pid;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+/*!
+The velocity (incremental) form calculation. Returns the change in output.
+The I-term increment is integralFactor*integralMultiplier, and is also added to the integral, so getErrorI() remains meaningful.
+*/
+template <uint32_t TERMS, typename T>
+T PIDFT<TERMS, T>::updateIncrementalKernel(T measurement, T errorDerivative, T integralFactor, T integralMultiplier) // NOLINT(bugprone-easily-swappable-parameters)
+{
+    static_assert(HAS_INCREMENTAL, "no incremental form");
+
+    uint32_t instrumentationStart = 0;
+    if constexpr (HAS_INSTRUMENTATION) {
+        if (this->_instrumentation != nullptr) { instrumentationStart = pidfCycleCount(); }
+    }
+    measurement = flushDenormal(measurement);
+    const T error = flushDenormal(_setpoint - measurement);
+    // -T(0) is the additive identity, so the sum is the same as if only the selected terms were written out
+    T outputDelta = -T(0);
+    if constexpr (HAS_P) { outputDelta += this->_kp*(error - _errorPrevious); }
+    if constexpr (HAS_D) {
+        errorDerivative = flushDenormal(errorDerivative);
+        outputDelta += this->_kd*(errorDerivative - this->_errorDerivative);
+        this->_errorDerivative = errorDerivative;
+    } else {
+        (void)errorDerivative;
+    }
+    if constexpr (HAS_S) {
+        outputDelta += this->_ks*(_setpoint - this->_setpointUpdatePrevious);
+        this->_setpointUpdatePrevious = _setpoint;
+    }
+    if constexpr (HAS_K) {
+        outputDelta += this->_kk*(this->_setpointDerivative - this->_setpointDerivativePrevious);
+        this->_setpointDerivativePrevious = this->_setpointDerivative;
+    }
+    if constexpr (HAS_I) {
+        T integralDelta = integralFactor*integralMultiplier;
+        if constexpr (HAS_INTEGRAL_THRESHOLD) {
+            if (this->_integralThreshold != T(0) && pidfAbs(error) < this->_integralThreshold) {
+                integralDelta = T(0);
+            }
+        }
+        this->_errorIntegral = flushDenormal(this->_errorIntegral + integralDelta);
+        outputDelta += integralDelta;
+    } else {
+        (void)integralFactor;
+        (void)integralMultiplier;
+    }
+    _measurementPrevious = measurement;
+    _errorPrevious = error;
+
+    if constexpr (HAS_ERROR_SNAPSHOT) {
+        this->_errorSnapshot.publish(getError());
+    }
+    if constexpr (HAS_RECORDER) {
+        if (this->_recorder != nullptr) {
+            const error_t e = getError();
+            this->_recorder->record({
+                static_cast<float>(_setpoint), static_cast<float>(measurement),
+                static_cast<float>(e.P), static_cast<float>(e.I), static_cast<float>(e.D), static_cast<float>(e.S), static_cast<float>(e.K),
+                static_cast<float>(outputDelta)
+            });
+        }
+    }
+    if constexpr (HAS_INSTRUMENTATION) {
+        if (this->_instrumentation != nullptr) { this->_instrumentation->record(instrumentationStart, pidfCycleCount()); }
+    } else {
+        (void)instrumentationStart;
+    }
+
+    return outputDelta;
+}
@@ -0,0 +1,111 @@
+#include "PIDFTrajectory.h"
+#include <cmath>
+
+
+PIDFTrajectory::PIDFTrajectory(const limits_t& limits, float deltaT) :
+    _limits(limits),
+    _deltaT(deltaT)
+{
+}
+
+void PIDFTrajectory::reset(float position)
+{
+    _point = point_t { position, 0.0F, 0.0F };
+    _target = position;
+    _duration = 0.0F;
+    _finished = true;
+    _pending = false;
+}
+
+void PIDFTrajectory::setTarget(float target)
+{
+    if (_finished) {
+        start(target);
+    } else {
+        _pendingTarget = target;
+        _pending = true;
+    }
+}
+
+/*!
+Plan the move from the current position to target.
+The segment durations are calculated in double precision, as are the segment start points, which are propagated
+through the segments, so the rounding of the end point is that of the float segment coefficients only.
+*/
+void PIDFTrajectory::start(float target)
+{
+    const double distance = static_cast<double>(target) - static_cast<double>(_point.position);
+    const double direction = distance < 0.0 ? -1.0 : 1.0;
+    const double d = std::fabs(distance);
+    const auto vMax = static_cast<double>(_limits.velocity);
+    const auto aMax = static_cast<double>(_limits.acceleration);
+    const auto jMax = static_cast<double>(_limits.jerk);
+    _target = target;
+    _tick = 0;
+    _segment = 0;
+    if (d == 0.0 || vMax <= 0.0 || aMax <= 0.0 || jMax <= 0.0) {
+        _point = point_t { target, 0.0F, 0.0F };
+        _duration = 0.0F;
+        _finished = true;
+        return;
+    }
+
+    // jerk time tj, acceleration phase time ta (including the two jerk segments), constant velocity time tv
+    double tj = aMax / jMax;
+    double ta = (vMax*jMax >= aMax*aMax) ? tj + vMax / aMax : 2.0*std::sqrt(vMax / jMax);
+    if (ta < 2.0*tj) {
+        // maximum acceleration is not reached before the maximum velocity
+        tj = 0.5*ta;
+    }
+    const double v = jMax*tj*(ta - tj); // peak velocity
+    double tv = (d - v*ta) / v;
+    if (tv < 0.0) {
+        // maximum velocity is not reached, reduce the acceleration phase so the distance is d, with no constant velocity segment
+        tv = 0.0;
+        tj = aMax / jMax;
+        ta = 0.5*(tj + std::sqrt(tj*tj + 4.0*d / aMax));
+        if (ta < 2.0*tj) {
+            // maximum acceleration is not reached either
+            tj = std::cbrt(0.5*d / jMax);
+            ta = 2.0*tj;
+        }
+    }
+
+    const double j = direction*jMax;
+    const std::array<double, SEGMENT_COUNT> durations {{ tj, ta - 2.0*tj, tj, tv, tj, ta - 2.0*tj, tj }};
+    const std::array<double, SEGMENT_COUNT> jerks {{ j, 0.0, -j, 0.0, -j, 0.0, j }};
+    double time = 0.0;
+    double position = static_cast<double>(_point.position);
+    double velocity = 0.0;
+    double acceleration = 0.0;
+    for (size_t ii = 0; ii < SEGMENT_COUNT; ++ii) {
+        _segments[ii] = segment_t {
+            static_cast<float>(time),
+            static_cast<float>(jerks[ii]),
+            { static_cast<float>(position), static_cast<float>(velocity), static_cast<float>(acceleration) }
+        };
+        const double t = durations[ii];
+        position += t*(velocity + t*(0.5*acceleration + jerks[ii]*t / 6.0));
+        velocity += t*(acceleration + 0.5*jerks[ii]*t);
+        acceleration += jerks[ii]*t;
+        time += t;
+    }
+    _duration = static_cast<float>(time);
+    _finished = false;
+}
+
+size_t PIDFTrajectory::plan(float startPosition, float target, point_t* points, size_t capacity) const
+{
+    PIDFTrajectory trajectory(_limits, _deltaT);
+    trajectory.reset(startPosition);
+    trajectory.setTarget(target);
+    size_t count = 0;
+    while (!trajectory.isFinished()) {
+        const point_t& point = trajectory.update();
+        if (count < capacity) {
+            points[count] = point;
+        }
+        ++count;
+    }
+    return count;
+}
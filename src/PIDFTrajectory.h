@@ -0,0 +1,129 @@
+# pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+Jerk-limited (S-curve) setpoint trajectory generator, for feeding the setpoint and the K-term setpoint derivative of a controller.
+
+`setTarget` plans a rest-to-rest move from the current position to the target, with the velocity, acceleration, and jerk
+limited. The move has up to seven segments of constant jerk (+j, 0, -j, 0, -j, 0, +j): the constant acceleration segments
+are omitted when the maximum acceleration is not reached, and the constant velocity segment when the maximum velocity is not
+reached. The plan is calculated once, when the target is set. Each `update` then advances one sample and evaluates the
+position, velocity, and acceleration polynomials of the current segment at the sample time, so there is no division and
+no accumulated rounding error, and the exact (not finite difference) velocity is available for the K-term.
+
+    PIDFTrajectory trajectory({ maxVelocity, maxAcceleration, maxJerk }, deltaT);
+    trajectory.setTarget(target);
+    ...
+    trajectory.update(pid); // sets the setpoint and setpoint derivative
+    const float output = pid.update(measurement);
+
+A target set during a move is started when the current move finishes. Profiles can also be planned in advance into
+a buffer, using `plan`, and replayed with `apply`.
+*/
+class PIDFTrajectory {
+public:
+    struct limits_t {
+        float velocity;
+        float acceleration;
+        float jerk;
+    };
+    struct point_t {
+        float position;
+        float velocity;
+        float acceleration;
+    };
+    enum { SEGMENT_COUNT = 7 };
+    struct segment_t {
+        float startTime; //!< time of the start of the segment, from the start of the move
+        float jerk;
+        point_t start; //!< position, velocity, and acceleration at the start of the segment
+    };
+public:
+    PIDFTrajectory(const limits_t& limits, float deltaT);
+public:
+    inline const limits_t& getLimits() const { return _limits; }
+    inline void setLimits(const limits_t& limits) { _limits = limits; } //!< takes effect at the next move
+    inline float getSampleTime() const { return _deltaT; }
+
+    //! Set the position, at rest, cancelling any move.
+    void reset(float position);
+    //! Set the target position. If a move is in progress, the move to the target starts when the current move finishes.
+    void setTarget(float target);
+    inline float getTarget() const { return _pending ? _pendingTarget : _target; }
+    inline bool isFinished() const { return _finished && !_pending; }
+    inline float getDuration() const { return _duration; } //!< duration of the current move
+    inline const std::array<segment_t, SEGMENT_COUNT>& getSegments() const { return _segments; }
+    inline const point_t& getPoint() const { return _point; }
+
+    //! Advance one sample, and return the new setpoint, velocity and acceleration.
+    inline const point_t& update() {
+        if (_finished) {
+            if (!_pending) {
+                return _point;
+            }
+            _pending = false;
+            start(_pendingTarget);
+            if (_finished) {
+                return _point;
+            }
+        }
+        ++_tick;
+        const float time = static_cast<float>(_tick)*_deltaT;
+        if (time >= _duration) {
+            _point = point_t { _target, 0.0F, 0.0F };
+            _finished = true;
+            return _point;
+        }
+        while (_segment < SEGMENT_COUNT - 1 && time >= _segments[_segment + 1].startTime) {
+            ++_segment;
+        }
+        const segment_t& segment = _segments[_segment];
+        const float t = time - segment.startTime;
+        const float jt = segment.jerk*t;
+        const float a = segment.start.acceleration;
+        const float v = segment.start.velocity;
+        _point.acceleration = a + jt;
+        _point.velocity = v + t*(a + 0.5F*jt);
+        _point.position = segment.start.position + t*(v + t*(0.5F*a + ONE_SIXTH*jt));
+        return _point;
+    }
+    //! Advance one sample, and set the setpoint and setpoint derivative of pid.
+    template <typename PID>
+    inline const point_t& update(PID& pid) {
+        const point_t& point = update();
+        apply(pid, point);
+        return point;
+    }
+    //! Set the setpoint and setpoint derivative of pid, eg from a point of a planned profile.
+    template <typename PID>
+    static inline void apply(PID& pid, const point_t& point) {
+        pid.setSetpoint(point.position);
+        if constexpr (PID::HAS_K) { pid.setSetpointDerivative(point.velocity); }
+    }
+
+    /*!
+    Plan a move from start to target into points, one point per sample, the same as the points returned by `update`.
+    Returns the number of points in the move (the last point is at the target), which may be more than capacity,
+    in which case only capacity points are written. Does not change the current move.
+    */
+    size_t plan(float startPosition, float target, point_t* points, size_t capacity) const;
+private:
+    void start(float target);
+    static constexpr float ONE_SIXTH = 1.0F / 6.0F;
+private:
+    limits_t _limits;
+    float _deltaT;
+    std::array<segment_t, SEGMENT_COUNT> _segments {};
+    point_t _point {};
+    float _target {0.0F};
+    float _pendingTarget {0.0F};
+    float _duration {0.0F};
+    uint32_t _tick {0};
+    uint32_t _segment {0};
+    bool _finished {true};
+    bool _pending {false};
+    std::array<uint8_t, 2> _unused {};
+};
@@ -0,0 +1,230 @@
+# pragma once
+
+#include "PIDF.h"
+#include "PIDFSimd.h"
+#include <array>
+#include <cstddef>
+
+/*!
+Multi-axis PIDF controller, for example roll, pitch, and yaw, with the axes packed into the lanes of one 4-wide vector.
+
+All axes are updated with a single call, which calculates the reciprocal of deltaT once, and does the integral threshold,
+integral limit and output saturation tests for all axes with branch-free vector selects. Each axis has its own gains,
+limits and setpoint. The update uses SSE2 on x86, NEON on AArch64, and scalar code otherwise.
+
+The derivative is calculated by multiplying by the reciprocal of deltaT, and the integral increment is (ki*deltaT)*error,
+so each axis calculates the same output as the fixed-rate `PIDF::updateDelta` (or, with a non-zero tracking gain,
+`PIDFT<PIDFTerms::ALL | PIDFTerms::BACK_CALCULATION>::updateDelta`) with the sample time set to deltaT,
+subject to the same caveats about fused multiply-adds as PIDFBank.
+*/
+template <size_t N>
+class PIDFVec {
+public:
+    static_assert(N >= 1 && N <= 4, "PIDFVec supports 1 to 4 axes");
+    static constexpr size_t LANES = 4;
+    static constexpr size_t ALIGNMENT = 16;
+    using PIDF_t = PIDF::PIDF_t;
+    using error_t = PIDF::error_t;
+    using values_t = std::array<float, N>;
+public:
+    inline size_t size() const { return N; }
+
+    inline void setPID(size_t axis, const PIDF_t& pid) {
+        _kp[axis] = pid.kp; _ki[axis] = pid.ki; _kd[axis] = pid.kd; _ks[axis] = pid.ks; _kk[axis] = pid.kk;
+        _kiDeltaT[axis] = _ki[axis]*_deltaT[axis];
+    }
+    inline PIDF_t getPID(size_t axis) const { return PIDF_t { _kp[axis], _ki[axis], _kd[axis], _ks[axis], _kk[axis] }; }
+
+    // an unused integral limit (ie zero) is stored as infinity, so the limits can be applied with min and max
+    inline void setIntegralMax(size_t axis, float integralMax) { _integralMax[axis] = integralMax > 0.0F ? integralMax : INFINITY; }
+    inline void setIntegralMin(size_t axis, float integralMin) { _integralMin[axis] = integralMin < 0.0F ? integralMin : -INFINITY; }
+    inline void setIntegralLimit(size_t axis, float integralLimit) { setIntegralMax(axis, integralLimit); setIntegralMin(axis, -integralLimit); }
+    inline void setIntegralThreshold(size_t axis, float integralThreshold) { _integralThreshold[axis] = integralThreshold; }
+    inline void setOutputSaturationValue(size_t axis, float outputSaturationValue) { _outputSaturationValue[axis] = outputSaturationValue; }
+    //! Back-calculation tracking gain, see PIDFT::setTrackingGain. Zero (the default) uses integral limiting on output saturation.
+    inline void setTrackingGain(size_t axis, float trackingGain) {
+        _trackingGain[axis] = trackingGain;
+        _trackingGainDeltaT[axis] = trackingGain*_deltaT[axis];
+    }
+
+    //! Set the sample time used by the fixed-rate update functions, which have no deltaT parameter.
+    inline void setSampleTime(float deltaT) {
+        for (size_t ii = 0; ii < LANES; ++ii) {
+            _deltaT[ii] = deltaT;
+            _deltaTReciprocal[ii] = 1.0F / deltaT;
+            _kiDeltaT[ii] = _ki[ii]*deltaT;
+            _trackingGainDeltaT[ii] = _trackingGain[ii]*deltaT;
+        }
+    }
+    inline float getSampleTime() const { return _deltaT[0]; }
+
+    inline void setSetpoint(size_t axis, float setpoint) { _setpoint[axis] = setpoint; }
+    //! Set the setpoints of all axes. Preferable to setting them individually just before an update, see updateAxes.
+    inline void setSetpoints(const values_t& setpoints) {
+        if constexpr (pidf_simd4_t::WIDTH == LANES) {
+            pidf_simd4_t::store(&_setpoint[0], lanes<pidf_simd4_t>(setpoints));
+        } else {
+            for (size_t ii = 0; ii < N; ++ii) { _setpoint[ii] = setpoints[ii]; }
+        }
+    }
+    inline void setSetpointDerivative(size_t axis, float setpointDerivative) { _setpointDerivative[axis] = setpointDerivative; }
+    inline float getSetpoint(size_t axis) const { return _setpoint[axis]; }
+    inline float getPreviousMeasurement(size_t axis) const { return _measurementPrevious[axis]; }
+
+    inline void resetIntegral(size_t axis) { _errorIntegral[axis] = 0.0F; }
+    void resetAll() {
+        _setpoint.fill(0.0F);
+        _setpointDerivative.fill(0.0F);
+        _errorIntegral.fill(0.0F);
+        _errorPrevious.fill(0.0F);
+        _errorDerivative.fill(0.0F);
+        _measurementPrevious.fill(0.0F);
+    }
+
+    //! Error terms of one axis, the same as PIDF::getError.
+    inline error_t getError(size_t axis) const {
+        return error_t {
+            _errorPrevious[axis]*_kp[axis],
+            _errorIntegral[axis],
+            _errorDerivative[axis]*_kd[axis],
+            _setpoint[axis]*_ks[axis],
+            _setpointDerivative[axis]*_kk[axis]
+        };
+    }
+    inline float getErrorI(size_t axis) const { return _errorIntegral[axis]; }
+    inline float getPreviousError(size_t axis) const { return _errorPrevious[axis]; }
+
+    inline values_t update(const values_t& measurements, float deltaT) {
+        return updateDelta(measurements, deltas(measurements), deltaT);
+    }
+    //! Update all axes, returning the output of each axis.
+    inline values_t updateDelta(const values_t& measurements, const values_t& measurementDeltas, float deltaT) {
+        return updateAxes<false>(measurements, measurementDeltas, deltaT, 1.0F / deltaT);
+    }
+    // fixed-rate update functions, using the sample time set by setSampleTime()
+    inline values_t update(const values_t& measurements) {
+        return updateDelta(measurements, deltas(measurements));
+    }
+    inline values_t updateDelta(const values_t& measurements, const values_t& measurementDeltas) {
+        return updateAxes<true>(measurements, measurementDeltas, 0.0F, 0.0F);
+    }
+private:
+    inline values_t deltas(const values_t& measurements) const {
+        values_t measurementDeltas {};
+        for (size_t ii = 0; ii < N; ++ii) {
+            measurementDeltas[ii] = measurements[ii] - _measurementPrevious[ii];
+        }
+        return measurementDeltas;
+    }
+    //! Vector of the N values, with the unused lanes zero. Unused lanes have zero gains, so their output is zero.
+    template <typename V>
+    static inline typename V::v lanes(const values_t& values) {
+        return V::set4(values[0], N > 1 ? values[N > 1 ? 1 : 0] : 0.0F, N > 2 ? values[N > 2 ? 2 : 0] : 0.0F, N > 3 ? values[N - 1] : 0.0F);
+    }
+    template <bool FIXED_RATE>
+    values_t updateAxes(const values_t& measurements, const values_t& measurementDeltas, float deltaT, float deltaTReciprocal) { // NOLINT(bugprone-easily-swappable-parameters)
+        using V = pidf_simd4_t;
+        alignas(ALIGNMENT) std::array<float, LANES> outputs {};
+        if constexpr (V::WIDTH == LANES) {
+            // the inputs are assembled in registers, rather than copied to an aligned array and loaded, since loading a vector
+            // just after storing its elements individually stalls the load until the stores complete (store forwarding fails)
+            updateLanes<V, FIXED_RATE>(0, lanes<V>(measurements), lanes<V>(measurementDeltas), deltaT, deltaTReciprocal, &outputs[0]);
+        } else {
+            for (size_t ii = 0; ii < N; ++ii) {
+                updateLanes<pidf_simd_scalar_t, FIXED_RATE>(ii, measurements[ii], measurementDeltas[ii], deltaT, deltaTReciprocal, &outputs[0]);
+            }
+        }
+        values_t ret {};
+        for (size_t ii = 0; ii < N; ++ii) {
+            ret[ii] = outputs[ii];
+        }
+        return ret;
+    }
+    /*!
+    Branch-free form of the PIDF fixed-rate update, operating on V::WIDTH lanes starting at index.
+    */
+    template <typename V, bool FIXED_RATE>
+    void updateLanes(size_t index, typename V::v measurement, typename V::v measurementDelta, float deltaT, float deltaTReciprocal, float* outputs) { // NOLINT(bugprone-easily-swappable-parameters)
+        using v = typename V::v;
+        using m = typename V::m;
+        const v zero = V::zero();
+        v dTReciprocal {};
+        v kiDeltaT {};
+        v trackingGainDeltaT {};
+        if constexpr (FIXED_RATE) {
+            (void)deltaT;
+            (void)deltaTReciprocal;
+            dTReciprocal = V::load(&_deltaTReciprocal[index]);
+            kiDeltaT = V::load(&_kiDeltaT[index]);
+            trackingGainDeltaT = V::load(&_trackingGainDeltaT[index]);
+        } else {
+            const v dT = V::set1(deltaT);
+            dTReciprocal = V::set1(deltaTReciprocal);
+            kiDeltaT = V::mul(V::load(&_ki[index]), dT);
+            trackingGainDeltaT = V::mul(V::load(&_trackingGain[index]), dT);
+        }
+
+        const v setpoint = V::load(&_setpoint[index]);
+        const v error = V::sub(setpoint, measurement);
+        const v errorDerivative = V::mul(V::neg(measurementDelta), dTReciprocal);
+        //                                      P                                    + D                                                     + S                                        + K
+        const v partialSum = V::add(V::add(V::add(V::mul(V::load(&_kp[index]), error), V::mul(V::load(&_kd[index]), errorDerivative)), V::mul(V::load(&_ks[index]), setpoint)),
+                                    V::mul(V::load(&_kk[index]), V::load(&_setpointDerivative[index])));
+
+        // integrate the error, with integral clamping, if the error is above the integral threshold
+        v errorIntegral = V::load(&_errorIntegral[index]);
+        const v integralThreshold = V::load(&_integralThreshold[index]);
+        const m integrate = V::mor(V::eq(integralThreshold, zero), V::ge(V::abs(error), integralThreshold));
+        // the limits are infinite when not used, so min and max give the same result as PIDF's clamping, with a shorter dependency chain
+        const v integrated = V::max(V::min(V::add(errorIntegral, V::mul(kiDeltaT, error)), V::load(&_integralMax[index])), V::load(&_integralMin[index]));
+        errorIntegral = V::select(integrate, integrated, errorIntegral);
+
+        // anti-windup by avoiding output saturation, or by back-calculation
+        const v outputSaturationValue = V::load(&_outputSaturationValue[index]);
+        const v upper = V::sub(outputSaturationValue, partialSum);
+        const v lower = V::sub(V::neg(outputSaturationValue), partialSum);
+        v limited = V::select(V::gt(errorIntegral, upper), V::max(upper, zero),
+                              V::select(V::lt(errorIntegral, lower), V::min(lower, zero), errorIntegral));
+        const v unsaturated = V::add(partialSum, errorIntegral);
+        const v saturated = V::min(V::max(unsaturated, V::neg(outputSaturationValue)), outputSaturationValue);
+        const v tracked = V::add(errorIntegral, V::mul(trackingGainDeltaT, V::sub(saturated, unsaturated)));
+        limited = V::select(V::gt(V::load(&_trackingGain[index]), zero), tracked, limited);
+        errorIntegral = V::select(V::gt(outputSaturationValue, zero), limited, errorIntegral);
+
+        V::store(&_errorIntegral[index], errorIntegral);
+        V::store(&_errorPrevious[index], error);
+        V::store(&_errorDerivative[index], errorDerivative);
+        V::store(&_measurementPrevious[index], measurement);
+        V::store(outputs + index, V::add(partialSum, errorIntegral));
+    }
+private:
+    alignas(ALIGNMENT) std::array<float, LANES> _kp {};
+    alignas(ALIGNMENT) std::array<float, LANES> _ki {};
+    alignas(ALIGNMENT) std::array<float, LANES> _kd {};
+    alignas(ALIGNMENT) std::array<float, LANES> _ks {};
+    alignas(ALIGNMENT) std::array<float, LANES> _kk {};
+
+    alignas(ALIGNMENT) std::array<float, LANES> _setpoint {};
+    alignas(ALIGNMENT) std::array<float, LANES> _setpointDerivative {};
+
+    alignas(ALIGNMENT) std::array<float, LANES> _errorIntegral {};
+    alignas(ALIGNMENT) std::array<float, LANES> _errorPrevious {};
+    alignas(ALIGNMENT) std::array<float, LANES> _errorDerivative {};
+    alignas(ALIGNMENT) std::array<float, LANES> _measurementPrevious {};
+
+    // integral anti-windup parameters
+    alignas(ALIGNMENT) std::array<float, LANES> _integralMax { INFINITY, INFINITY, INFINITY, INFINITY };
+    alignas(ALIGNMENT) std::array<float, LANES> _integralMin { -INFINITY, -INFINITY, -INFINITY, -INFINITY };
+    alignas(ALIGNMENT) std::array<float, LANES> _integralThreshold {};
+    alignas(ALIGNMENT) std::array<float, LANES> _outputSaturationValue {};
+    alignas(ALIGNMENT) std::array<float, LANES> _trackingGain {};
+
+    // fixed-rate coefficients, in every lane so they can be loaded as vectors
+    alignas(ALIGNMENT) std::array<float, LANES> _deltaT {};
+    alignas(ALIGNMENT) std::array<float, LANES> _deltaTReciprocal {};
+    alignas(ALIGNMENT) std::array<float, LANES> _kiDeltaT {};
+    alignas(ALIGNMENT) std::array<float, LANES> _trackingGainDeltaT {};
+};
+
+using PIDFVec3 = PIDFVec<3>;
+using PIDFVec4 = PIDFVec<4>;
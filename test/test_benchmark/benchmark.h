@@ -0,0 +1,67 @@
+# pragma once
+
+/*!
+Helpers for the native benchmarks.
+
+Each result is printed as a human-readable line, followed by a line starting with "BENCHMARK " containing the result as JSON.
+If the environment variable PIDF_BENCHMARK_FILE is set, the JSON results are also appended to that file, one per line,
+so that results from different builds can be compared to catch performance regressions.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+struct benchmark_result_t {
+    const char* name;
+    const char* scenario;
+    double nsPerUpdate;
+    double updatesPerSecond;
+};
+
+inline volatile float benchmarkSink; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) stops the optimizer removing the benchmarked code
+
+/*!
+Times run(), which must perform updateCount updates and return a value derived from the outputs.
+Reports the best of repeatCount runs, after one warm-up run.
+*/
+template <typename F>
+benchmark_result_t benchmarkRun(const char* name, const char* scenario, size_t updateCount, F&& run, int repeatCount = 7)
+{
+    benchmarkSink = run(); // warm up caches and branch predictors
+    double bestNs = 1.0e30;
+    for (int ii = 0; ii < repeatCount; ++ii) {
+        const auto start = std::chrono::steady_clock::now();
+        const float result = run();
+        const auto end = std::chrono::steady_clock::now();
+        benchmarkSink = result;
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        if (ns < bestNs) {
+            bestNs = ns;
+        }
+    }
+    const double nsPerUpdate = bestNs / static_cast<double>(updateCount);
+    return benchmark_result_t { name, scenario, nsPerUpdate, 1.0e9 / nsPerUpdate };
+}
+
+inline void benchmarkReport(const benchmark_result_t& result)
+{
+    std::printf("%-36s %-24s %8.2f ns/update %12.0f updates/s\n", result.name, result.scenario, result.nsPerUpdate, result.updatesPerSecond);
+    std::printf("BENCHMARK {\"name\":\"%s\",\"scenario\":\"%s\",\"ns_per_update\":%.3f,\"updates_per_second\":%.0f}\n",
+        result.name, result.scenario, result.nsPerUpdate, result.updatesPerSecond);
+    const char* fileName = std::getenv("PIDF_BENCHMARK_FILE"); // NOLINT(concurrency-mt-unsafe)
+    if (fileName != nullptr) {
+        FILE* file = std::fopen(fileName, "a"); // NOLINT(cppcoreguidelines-owning-memory)
+        if (file != nullptr) {
+            std::fprintf(file, "{\"name\":\"%s\",\"scenario\":\"%s\",\"ns_per_update\":%.3f,\"updates_per_second\":%.0f}\n",
+                result.name, result.scenario, result.nsPerUpdate, result.updatesPerSecond);
+            std::fclose(file); // NOLINT(cppcoreguidelines-owning-memory)
+        }
+    }
+}
+
+template <typename F>
+void benchmark(const char* name, const char* scenario, size_t updateCount, F&& run)
+{
+    benchmarkReport(benchmarkRun(name, scenario, updateCount, run));
+}
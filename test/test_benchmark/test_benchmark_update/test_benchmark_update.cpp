@@ -0,0 +1,643 @@
+#include "../benchmark.h"
+#include <PIDF.h>
+#include <PIDFBank.h>
+#include <PIDFDenormalGuard.h>
+#include <PIDFDirectForm.h>
+#include <PIDFFixed.h>
+#include <PIDFFrequencyResponse.h>
+#include <PIDFGainScheduler.h>
+#include <PIDFInstrumentation.h>
+#include <PIDFOptimizer.h>
+#include <PIDFReplay.h>
+#include <PIDFScheduler.h>
+#include <PIDFSimulation.h>
+#include <PIDFTrajectory.h>
+#include <PIDFVec.h>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables)
+enum { SAMPLE_COUNT = 8000 }; // one second of control at 8kHz
+static constexpr float DELTA_T = 1.0F / 8000.0F;
+
+struct stream_t {
+    std::array<float, SAMPLE_COUNT> setpoints;
+    std::array<float, SAMPLE_COUNT> measurements;
+    std::array<float, SAMPLE_COUNT> measurementDeltas;
+};
+static stream_t stream {};
+
+/*!
+Realistic setpoint and measurement stream: setpoint steps and ramps, with the measurement following the setpoint
+with a first order lag plus noise. The stream is precomputed so its generation is not included in the timings.
+*/
+static void createStream()
+{
+    uint32_t seed = 1;
+    float measurement = 0.0F;
+    for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+        const size_t phase = ii / 1000;
+        const float setpoint = (phase % 4 == 3) ? static_cast<float>(ii % 1000) * 0.002F : ((phase & 1U) ? 1.0F : -0.5F);
+        seed = seed*1664525U + 1013904223U;
+        const float noise = 0.01F*(static_cast<float>(seed >> 8U)/8388608.0F - 1.0F);
+        const float previous = measurement;
+        measurement += (setpoint - measurement)*0.002F + noise;
+        stream.setpoints[ii] = setpoint;
+        stream.measurements[ii] = measurement;
+        stream.measurementDeltas[ii] = measurement - previous;
+    }
+}
+
+struct scenario_t {
+    const char* name;
+    float integralLimit;
+    float integralThreshold;
+    float outputSaturationValue;
+    float iTermErrorScale; //!< used to attenuate the ITerm error in the updateDeltaITerm benchmark
+};
+static constexpr std::array<scenario_t, 6> scenarios {{
+    { "plain", 0.0F, 0.0F, 0.0F, 1.0F },
+    { "integral_limit", 0.2F, 0.0F, 0.0F, 1.0F },
+    { "integral_threshold", 0.0F, 0.05F, 0.0F, 1.0F },
+    { "output_saturation", 0.0F, 0.0F, 1.0F, 1.0F },
+    { "near_saturation", 0.0F, 0.0F, 0.3F, 1.0F }, // output often at the saturation value, so the saturation tests are unpredictable
+    { "limit_threshold_saturation", 0.2F, 0.05F, 1.0F, 0.5F },
+}};
+
+template <typename T>
+static T createPID(const scenario_t& scenario)
+{
+    T pid({ 1.5F, 40.0F, 0.002F, 0.1F, 0.001F });
+    if constexpr (T::HAS_FIXED_RATE) {
+        pid.setSampleTime(DELTA_T);
+    }
+    if constexpr (T::HAS_INTEGRAL_LIMIT) {
+        pid.setIntegralLimit(scenario.integralLimit);
+    }
+    if constexpr (T::HAS_INTEGRAL_THRESHOLD) {
+        pid.setIntegralThreshold(scenario.integralThreshold);
+    }
+    if constexpr (T::HAS_OUTPUT_SATURATION) {
+        pid.setOutputSaturationValue(scenario.outputSaturationValue);
+    }
+    if constexpr (T::HAS_BACK_CALCULATION) {
+        pid.setTrackingGain(20.0F);
+    }
+    return pid;
+}
+
+template <typename T, typename F>
+static void benchmarkUpdate(const char* name, const scenario_t& scenario, F&& update)
+{
+    T pid = createPID<T>(scenario);
+    benchmark(name, scenario.name, SAMPLE_COUNT, [&pid, &update]() {
+        float sum = 0.0F;
+        for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+            pid.setSetpoint(stream.setpoints[ii]);
+            sum += update(pid, ii);
+        }
+        return sum;
+    });
+}
+
+void test_benchmark_PIDF()
+{
+    for (const auto& scenario : scenarios) {
+        benchmarkUpdate<PIDF>("PIDF::update", scenario, [](PIDF& pid, size_t ii) {
+            return pid.update(stream.measurements[ii], DELTA_T);
+        });
+        benchmarkUpdate<PIDF>("PIDF::updateDelta", scenario, [](PIDF& pid, size_t ii) {
+            return pid.updateDelta(stream.measurements[ii], stream.measurementDeltas[ii], DELTA_T);
+        });
+        benchmarkUpdate<PIDF>("PIDF::updateDeltaITerm", scenario, [&scenario](PIDF& pid, size_t ii) {
+            return pid.updateDeltaITerm(stream.measurements[ii], stream.measurementDeltas[ii], scenario.iTermErrorScale*(stream.setpoints[ii] - stream.measurements[ii]), DELTA_T);
+        });
+        benchmarkUpdate<PIDF>("PIDF::update fixed rate", scenario, [](PIDF& pid, size_t ii) {
+            return pid.update(stream.measurements[ii]);
+        });
+        benchmarkUpdate<PIDF>("PIDF::updateDelta fixed rate", scenario, [](PIDF& pid, size_t ii) {
+            return pid.updateDelta(stream.measurements[ii], stream.measurementDeltas[ii]);
+        });
+        benchmarkUpdate<PIDF>("PIDF::updateSPI", scenario, [](PIDF& pid, size_t ii) {
+            return pid.updateSPI(stream.measurements[ii], DELTA_T);
+        });
+        benchmarkUpdate<PIDF>("PIDF::updateSKPI", scenario, [](PIDF& pid, size_t ii) {
+            return pid.updateSKPI(stream.measurements[ii], DELTA_T);
+        });
+        benchmarkUpdate<PIDF>("PIDF::updateSPI fixed rate", scenario, [](PIDF& pid, size_t ii) {
+            return pid.updateSPI(stream.measurements[ii]);
+        });
+    }
+    // the P and PD updates do not use the integral limits, so only need to be run once
+    benchmarkUpdate<PIDF>("PIDF::updateSP", scenarios[0], [](PIDF& pid, size_t ii) {
+        return pid.updateSP(stream.measurements[ii]);
+    });
+    benchmarkUpdate<PIDF>("PIDF::updateSPD", scenarios[0], [](PIDF& pid, size_t ii) {
+        return pid.updateSPD(stream.measurements[ii], stream.measurementDeltas[ii], DELTA_T);
+    });
+    benchmarkUpdate<PIDF>("PIDF::updateSKPD", scenarios[0], [](PIDF& pid, size_t ii) {
+        return pid.updateSKPD(stream.measurements[ii], stream.measurementDeltas[ii], DELTA_T);
+    });
+    benchmarkUpdate<PIDF>("PIDF::updateSPD fixed rate", scenarios[0], [](PIDF& pid, size_t ii) {
+        return pid.updateSPD(stream.measurements[ii], stream.measurementDeltas[ii]);
+    });
+}
+
+void test_benchmark_PIDF_block()
+{
+    // block updates over the whole stream, compare with "PIDF::update" and "PIDF::update fixed rate"
+    static std::array<float, SAMPLE_COUNT> outputs {};
+    for (const auto& scenario : scenarios) {
+        PIDF pid = createPID<PIDF>(scenario);
+        benchmark("PIDF::updateBlock", scenario.name, SAMPLE_COUNT, [&pid]() {
+            pid.updateBlock(&stream.measurements[0], &stream.setpoints[0], DELTA_T, &outputs[0], SAMPLE_COUNT);
+            return outputs[SAMPLE_COUNT - 1];
+        });
+        benchmark("PIDF::updateBlock fixed rate", scenario.name, SAMPLE_COUNT, [&pid]() {
+            pid.updateBlock(&stream.measurements[0], &stream.setpoints[0], &outputs[0], SAMPLE_COUNT);
+            return outputs[SAMPLE_COUNT - 1];
+        });
+        benchmark("PIDF::updateDeltaBlock fixed rate", scenario.name, SAMPLE_COUNT, [&pid]() {
+            pid.updateDeltaBlock(&stream.measurements[0], &stream.measurementDeltas[0], &stream.setpoints[0], &outputs[0], SAMPLE_COUNT);
+            return outputs[SAMPLE_COUNT - 1];
+        });
+    }
+}
+
+/*!
+Reference PID with integral limit and output saturation, written with the nested if-else clamping PIDFT used before its
+clamps were made branch-free, for comparison with "PIDFT<PID|LIMIT|SAT>::updateDelta", particularly in the near_saturation
+scenario where the branches are unpredictable. It gives the same outputs as PIDFT<PID|LIMIT|SAT> (to within a few ULP).
+*/
+class PIDFReferenceBranchy {
+public:
+    static constexpr bool HAS_FIXED_RATE = false;
+    static constexpr bool HAS_INTEGRAL_LIMIT = true;
+    static constexpr bool HAS_INTEGRAL_THRESHOLD = false;
+    static constexpr bool HAS_OUTPUT_SATURATION = true;
+    static constexpr bool HAS_BACK_CALCULATION = false;
+public:
+    explicit PIDFReferenceBranchy(const PIDF::PIDF_t& pid) : _kp(pid.kp), _ki(pid.ki), _kd(pid.kd) {}
+    void setIntegralLimit(float integralLimit) { _integralMax = integralLimit; _integralMin = -integralLimit; }
+    void setOutputSaturationValue(float outputSaturationValue) { _outputSaturationValue = outputSaturationValue; }
+    void setSetpoint(float setpoint) { _setpoint = setpoint; }
+    float updateDelta(float measurement, float measurementDelta, float deltaT) {
+        const float error = _setpoint - measurement;
+        const float partialSum = _kp*error + _kd*(-measurementDelta/deltaT);
+        _errorIntegral += _ki*error*deltaT;
+        if (_integralMax > 0.0F && _errorIntegral > _integralMax) {
+            _errorIntegral = _integralMax;
+        } else if (_integralMin < 0.0F && _errorIntegral < _integralMin) {
+            _errorIntegral = _integralMin;
+        }
+        if (_outputSaturationValue > 0.0F) {
+            if (_errorIntegral > _outputSaturationValue - partialSum) {
+                _errorIntegral = std::fmax(_outputSaturationValue - partialSum, 0.0F);
+            } else if (_errorIntegral < -_outputSaturationValue - partialSum) {
+                _errorIntegral = std::fmin(-_outputSaturationValue - partialSum, 0.0F);
+            }
+        }
+        return partialSum + _errorIntegral;
+    }
+private:
+    float _kp;
+    float _ki;
+    float _kd;
+    float _setpoint {0.0F};
+    float _errorIntegral {0.0F};
+    float _integralMax {0.0F};
+    float _integralMin {0.0F};
+    float _outputSaturationValue {0.0F};
+};
+
+void test_benchmark_PIDFT()
+{
+    using PIDF_PI = PIDFT<PIDFTerms::PI>;
+    using PIDF_PIK = PIDFT<PIDFTerms::PI | PIDFTerms::K>;
+    using PIDF_PID_LIMITS = PIDFT<PIDFTerms::PID | PIDFTerms::INTEGRAL_LIMIT | PIDFTerms::OUTPUT_SATURATION>;
+    benchmarkUpdate<PIDFT<PIDFTerms::P>>("PIDFT<P>::update", scenarios[0], [](auto& pid, size_t ii) {
+        return pid.update(stream.measurements[ii], DELTA_T);
+    });
+    benchmarkUpdate<PIDF_PI>("PIDFT<PI>::update", scenarios[0], [](auto& pid, size_t ii) {
+        return pid.update(stream.measurements[ii], DELTA_T);
+    });
+    benchmarkUpdate<PIDF_PIK>("PIDFT<PI|K>::update", scenarios[0], [](auto& pid, size_t ii) {
+        return pid.update(stream.measurements[ii], DELTA_T);
+    });
+    benchmarkUpdate<PIDFT<PIDFTerms::PD>>("PIDFT<PD>::updateDelta", scenarios[0], [](auto& pid, size_t ii) {
+        return pid.updateDelta(stream.measurements[ii], stream.measurementDeltas[ii], DELTA_T);
+    });
+    using PIDF_PID_BACK_CALCULATION = PIDFT<PIDFTerms::PID | PIDFTerms::OUTPUT_SATURATION | PIDFTerms::BACK_CALCULATION>;
+    for (const auto& scenario : scenarios) {
+        benchmarkUpdate<PIDF_PID_LIMITS>("PIDFT<PID|LIMIT|SAT>::updateDelta", scenario, [](auto& pid, size_t ii) {
+            return pid.updateDelta(stream.measurements[ii], stream.measurementDeltas[ii], DELTA_T);
+        });
+        benchmarkUpdate<PIDF_PID_BACK_CALCULATION>("PIDFT<PID|SAT|BC>::updateDelta", scenario, [](auto& pid, size_t ii) {
+            return pid.updateDelta(stream.measurements[ii], stream.measurementDeltas[ii], DELTA_T);
+        });
+        benchmarkUpdate<PIDFReferenceBranchy>("reference branchy PID|LIMIT|SAT", scenario, [](auto& pid, size_t ii) {
+            return pid.updateDelta(stream.measurements[ii], stream.measurementDeltas[ii], DELTA_T);
+        });
+    }
+    // the incremental form has no integral limits, so is compared with the positional form without limits
+    using PIDF_PID_INCREMENTAL = PIDFT<PIDFTerms::PID | PIDFTerms::FIXED_RATE | PIDFTerms::INCREMENTAL>;
+    benchmarkUpdate<PIDFT<PIDFTerms::PID | PIDFTerms::FIXED_RATE>>("PIDFT<PID>::updateDelta fixed rate", scenarios[0], [](auto& pid, size_t ii) {
+        return pid.updateDelta(stream.measurements[ii], stream.measurementDeltas[ii]);
+    });
+    benchmarkUpdate<PIDF_PID_INCREMENTAL>("PIDFT<PID|INCR>::updateDeltaIncremental", scenarios[0], [](auto& pid, size_t ii) {
+        return pid.updateDeltaIncremental(stream.measurements[ii], stream.measurementDeltas[ii]);
+    });
+}
+
+/*!
+Setpoint held at zero, with the measurement an oscillation decaying towards zero. Starting from a small amplitude, the
+error and the controller state decay through the subnormal range, where arithmetic is many times slower on most hosts.
+*/
+template <typename T, typename F>
+static void benchmarkSettling(const char* name, F&& update)
+{
+    static std::array<float, SAMPLE_COUNT> measurements {};
+    for (const auto& [scenario, startAmplitude] : { std::pair { "settling", 1.0F }, std::pair { "settling_subnormal", 1.0e-36F } }) {
+        float amplitude = startAmplitude;
+        for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+            measurements[ii] = amplitude*std::cos(0.05F*static_cast<float>(ii));
+            amplitude *= 0.99856F;
+        }
+        benchmark(name, scenario, SAMPLE_COUNT, [&update]() {
+            T pid({ 0.5F, 2.0F, 0.01F, 0.0F, 0.0F }); // a new controller for each run, so each run decays from the start
+            float sum = 0.0F;
+            for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+                sum += update(pid, measurements[ii]);
+            }
+            return sum;
+        });
+    }
+}
+
+void test_benchmark_denormals()
+{
+    benchmarkSettling<PIDF>("PIDF::update", [](auto& pid, float measurement) {
+        return pid.update(measurement, DELTA_T);
+    });
+    benchmarkSettling<PIDFT<PIDFTerms::ALL | PIDFTerms::FLUSH_DENORMALS>>("PIDFT<ALL|FLUSH_DENORMALS>::update", [](auto& pid, float measurement) {
+        return pid.update(measurement, DELTA_T);
+    });
+    const PIDFDenormalGuard guard;
+    benchmarkSettling<PIDF>("PIDF::update, PIDFDenormalGuard", [](auto& pid, float measurement) {
+        return pid.update(measurement, DELTA_T);
+    });
+}
+
+void test_benchmark_PIDFBank()
+{
+    enum { CONTROLLER_COUNT = 64 };
+    for (const auto& scenario : scenarios) {
+        static PIDFBank<CONTROLLER_COUNT> bank;
+        bank.setPIDAll({ 1.5F, 40.0F, 0.002F, 0.1F, 0.001F });
+        for (size_t ii = 0; ii < CONTROLLER_COUNT; ++ii) {
+            bank.setIntegralLimit(ii, scenario.integralLimit);
+            bank.setIntegralThreshold(ii, scenario.integralThreshold);
+            bank.setOutputSaturationValue(ii, scenario.outputSaturationValue);
+        }
+        static std::array<float, CONTROLLER_COUNT> outputs {};
+        enum { STEPS = SAMPLE_COUNT / 8 };
+        auto run = [](auto update) {
+            float sum = 0.0F;
+            for (size_t step = 0; step < STEPS; ++step) {
+                // each controller sees the stream offset by its index, read directly from the stream
+                const size_t offset = (step*8) % (SAMPLE_COUNT - CONTROLLER_COUNT);
+                if (step % 125 == 0) {
+                    for (size_t ii = 0; ii < CONTROLLER_COUNT; ++ii) {
+                        bank.setSetpoint(ii, stream.setpoints[offset + ii]);
+                    }
+                }
+                update(&stream.measurements[offset], &stream.measurementDeltas[offset]);
+                sum += outputs[0] + outputs[CONTROLLER_COUNT - 1];
+            }
+            return sum;
+        };
+        benchmark("PIDFBank<64>::update", scenario.name, STEPS*CONTROLLER_COUNT, [&run]() {
+            return run([](const float* measurements, const float* deltas) { bank.update(measurements, deltas, DELTA_T, &outputs[0]); });
+        });
+        benchmark("PIDFBank<64>::updateScalar", scenario.name, STEPS*CONTROLLER_COUNT, [&run]() {
+            return run([](const float* measurements, const float* deltas) { bank.updateScalar(measurements, deltas, DELTA_T, &outputs[0]); });
+        });
+    }
+}
+void test_benchmark_PIDFVec()
+{
+    // three axes, each reading the stream at a different offset, reported per update of all three axes
+    enum { AXIS_OFFSET = 1000, STEPS = SAMPLE_COUNT - 2*AXIS_OFFSET };
+    for (const auto& scenario : scenarios) {
+        std::array<PIDF, 3> pids { createPID<PIDF>(scenario), createPID<PIDF>(scenario), createPID<PIDF>(scenario) };
+        benchmark("3 x PIDF::updateDelta", scenario.name, STEPS, [&pids]() {
+            float sum = 0.0F;
+            for (size_t ii = 0; ii < STEPS; ++ii) {
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    const size_t index = ii + axis*AXIS_OFFSET;
+                    pids[axis].setSetpoint(stream.setpoints[index]);
+                    sum += pids[axis].updateDelta(stream.measurements[index], stream.measurementDeltas[index], DELTA_T);
+                }
+            }
+            return sum;
+        });
+        static PIDFVec3 vec;
+        vec.resetAll();
+        for (size_t axis = 0; axis < 3; ++axis) {
+            vec.setPID(axis, { 1.5F, 40.0F, 0.002F, 0.1F, 0.001F });
+            vec.setIntegralLimit(axis, scenario.integralLimit);
+            vec.setIntegralThreshold(axis, scenario.integralThreshold);
+            vec.setOutputSaturationValue(axis, scenario.outputSaturationValue);
+        }
+        benchmark("PIDFVec3::updateDelta", scenario.name, STEPS, []() {
+            float sum = 0.0F;
+            for (size_t ii = 0; ii < STEPS; ++ii) {
+                PIDFVec3::values_t setpoints {};
+                PIDFVec3::values_t measurements {};
+                PIDFVec3::values_t measurementDeltas {};
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    const size_t index = ii + axis*AXIS_OFFSET;
+                    setpoints[axis] = stream.setpoints[index];
+                    measurements[axis] = stream.measurements[index];
+                    measurementDeltas[axis] = stream.measurementDeltas[index];
+                }
+                vec.setSetpoints(setpoints);
+                const PIDFVec3::values_t outputs = vec.updateDelta(measurements, measurementDeltas, DELTA_T);
+                sum += outputs[0] + outputs[1] + outputs[2];
+            }
+            return sum;
+        });
+    }
+}
+
+void test_benchmark_PIDFGainScheduler()
+{
+    // gains scheduled on a throttle value in the range [0, 1], which sweeps the range once every 1000 samples
+    const PIDFGainScheduler<9> scheduler(0.0F, 1.0F, {{
+        { 1.0F, 40.0F, 0.002F, 0.1F, 0.001F }, { 1.1F, 38.0F, 0.002F, 0.1F, 0.001F }, { 1.2F, 36.0F, 0.0022F, 0.1F, 0.001F },
+        { 1.3F, 34.0F, 0.0024F, 0.1F, 0.001F }, { 1.5F, 32.0F, 0.0026F, 0.1F, 0.001F }, { 1.7F, 30.0F, 0.0028F, 0.1F, 0.001F },
+        { 1.9F, 28.0F, 0.003F, 0.1F, 0.001F }, { 2.1F, 26.0F, 0.0032F, 0.1F, 0.001F }, { 2.4F, 24.0F, 0.0034F, 0.1F, 0.001F },
+    }});
+    auto throttle = [](size_t ii) { return static_cast<float>(ii % 1000) * 0.001F; };
+
+    benchmarkUpdate<PIDF>("PIDFGainScheduler::apply", scenarios[0], [&scheduler, &throttle](PIDF& pid, size_t ii) {
+        return scheduler.apply(throttle(ii), pid).kp;
+    });
+    benchmarkUpdate<PIDF>("PIDF::update, scheduled", scenarios[0], [&scheduler, &throttle](PIDF& pid, size_t ii) {
+        scheduler.apply(throttle(ii), pid);
+        return pid.update(stream.measurements[ii], DELTA_T);
+    });
+    benchmarkUpdate<PIDF>("PIDF::update fixed rate, scheduled", scenarios[0], [&scheduler, &throttle](PIDF& pid, size_t ii) {
+        scheduler.apply(throttle(ii), pid);
+        return pid.update(stream.measurements[ii]);
+    });
+    std::array<PIDF, 4> pids {};
+    benchmarkUpdate<PIDF>("PIDFGainScheduler::apply, 4 axes", scenarios[0], [&scheduler, &throttle, &pids](PIDF&, size_t ii) {
+        return scheduler.applyToArray(throttle(ii), &pids[0], pids.size()).kp;
+    });
+}
+
+void test_benchmark_PIDFDirectForm()
+{
+    // the same gains as PIDF::update fixed rate in the plain scenario, with the setpoint derivative for the K-term taken from the stream
+    const PIDF::PIDF_t gains { 1.5F, 40.0F, 0.002F, 0.1F, 0.001F };
+    benchmarkUpdate<PIDF>("PIDF::update fixed rate, K-term", scenarios[0], [](PIDF& pid, size_t ii) {
+        pid.setSetpoint(stream.setpoints[ii], DELTA_T);
+        return pid.update(stream.measurements[ii]);
+    });
+    const std::array<PIDFDirectForm, 3> directForms {{
+        PIDFDirectForm(gains, DELTA_T),
+        PIDFDirectForm(gains, DELTA_T, 4.0F*DELTA_T),
+        PIDFDirectForm(gains, DELTA_T, 4.0F*DELTA_T, PIDFDirectForm::TUSTIN),
+    }};
+    const std::array<const char*, 3> names {{ "backward_euler", "filtered", "tustin_filtered" }};
+    for (size_t jj = 0; jj < directForms.size(); ++jj) {
+        PIDFDirectForm directForm = directForms[jj];
+        benchmark("PIDFDirectForm::update", names[jj], SAMPLE_COUNT, [&directForm]() {
+            float sum = 0.0F;
+            for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+                directForm.setSetpoint(stream.setpoints[ii]);
+                sum += directForm.update(stream.measurements[ii]);
+            }
+            return sum;
+        });
+    }
+}
+
+void test_benchmark_PIDFFixed()
+{
+    // the stream is halved, so it is in the Q15/Q31 range, and converted before timing
+    for (const auto& scenario : scenarios) {
+        benchmarkUpdate<PIDF>("PIDF::update fixed rate, halved", scenario, [](PIDF& pid, size_t ii) {
+            pid.setSetpoint(0.5F*stream.setpoints[ii]);
+            return pid.update(0.5F*stream.measurements[ii]);
+        });
+    }
+    auto run = [](const char* name, auto pid) {
+        using Q = decltype(pid);
+        using T = decltype(pid.getSetpoint());
+        static std::array<T, SAMPLE_COUNT> setpoints {};
+        static std::array<T, SAMPLE_COUNT> measurements {};
+        for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+            setpoints[ii] = Q::fromFloat(0.5F*stream.setpoints[ii]);
+            measurements[ii] = Q::fromFloat(0.5F*stream.measurements[ii]);
+        }
+        for (const auto& scenario : scenarios) {
+            pid.setPID({ 1.5F, 40.0F, 0.002F, 0.1F, 0.001F });
+            pid.setSampleTime(DELTA_T);
+            pid.setIntegralLimit(Q::fromFloat(scenario.integralLimit));
+            pid.setIntegralThreshold(Q::fromFloat(scenario.integralThreshold));
+            pid.setOutputSaturationValue(Q::fromFloat(scenario.outputSaturationValue));
+            pid.resetAll();
+            benchmark(name, scenario.name, SAMPLE_COUNT, [&pid]() {
+                int64_t sum = 0;
+                for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+                    pid.setSetpoint(setpoints[ii]);
+                    sum += pid.update(measurements[ii]);
+                }
+                return static_cast<float>(sum);
+            });
+        }
+    };
+    run("PIDFQ15::update", PIDFQ15());
+    run("PIDFQ31::update", PIDFQ31());
+}
+
+void test_benchmark_PIDFTrajectory()
+{
+    // trajectory generation feeding the K-term, compare with "PIDF::update fixed rate, K-term", where the setpoint derivative
+    // is calculated by setSetpoint(setpoint, deltaT)
+    PIDF pid({ 1.5F, 40.0F, 0.002F, 0.1F, 0.001F });
+    pid.setSampleTime(DELTA_T);
+    PIDFTrajectory trajectory({ 2.0F, 20.0F, 400.0F }, DELTA_T);
+    benchmark("PIDFTrajectory::update, PIDF::update", "moves", SAMPLE_COUNT, [&pid, &trajectory]() {
+        float sum = 0.0F;
+        for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+            if (trajectory.isFinished()) {
+                trajectory.setTarget(stream.setpoints[ii]);
+            }
+            trajectory.update(pid);
+            sum += pid.update(stream.measurements[ii]);
+        }
+        return sum;
+    });
+}
+
+void test_benchmark_PIDFInstrumentation()
+{
+    // the cost of instrumentation: compiled in but not set (a null pointer test), and set (two counter reads and the record)
+    using PIDF_INSTRUMENTED = PIDFT<PIDFTerms::ALL | PIDFTerms::INSTRUMENTATION>;
+    benchmarkUpdate<PIDF_INSTRUMENTED>("PIDFT<ALL|INSTR>::update fixed rate, not set", scenarios[0], [](auto& pid, size_t ii) {
+        return pid.update(stream.measurements[ii]);
+    });
+    PIDFInstrumentation instrumentation(1000, 500, 1000);
+    benchmarkUpdate<PIDF_INSTRUMENTED>("PIDFT<ALL|INSTR>::update fixed rate, set", scenarios[0], [&instrumentation](auto& pid, size_t ii) {
+        if (ii == 0) {
+            pid.setInstrumentation(&instrumentation);
+        }
+        return pid.update(stream.measurements[ii]);
+    });
+}
+
+void test_benchmark_PIDFReplay()
+{
+    // replay of a quantized recorder dump of the stream with four gain sets, reported per update,
+    // compare with "PIDF::update" (the replay also decodes the log and collects the error terms)
+    const PIDFRecorder::config_t config {
+        PIDFRecordFields::SETPOINT | PIDFRecordFields::MEASUREMENT,
+        {{ PIDFRecorder::QUANTIZED, PIDFRecorder::QUANTIZED, 0, 0, 0, 0, 0, 0 }},
+        {{ 10000.0F, 10000.0F, 0, 0, 0, 0, 0, 0 }}
+    };
+    // 6 byte records: the sequence number and two quantized fields
+    static std::array<uint8_t, sizeof(PIDFRecorder::header_t) + SAMPLE_COUNT*6> dump {};
+    PIDFRecorder recorder(&dump[sizeof(PIDFRecorder::header_t)], SAMPLE_COUNT*6, config);
+    memcpy(&dump[0], &recorder.getHeader(), sizeof(PIDFRecorder::header_t));
+    for (size_t ii = 0; ii < SAMPLE_COUNT; ++ii) {
+        recorder.record({ stream.setpoints[ii], stream.measurements[ii], 0, 0, 0, 0, 0, 0 });
+    }
+    const PIDFReplay replay(&dump[0], dump.size());
+    std::array<PIDF, 4> pids {{
+        PIDF({ 1.5F, 40.0F, 0.002F, 0.1F, 0.001F }), PIDF({ 1.0F, 20.0F, 0.002F, 0.1F, 0.001F }),
+        PIDF({ 2.0F, 60.0F, 0.004F, 0.0F, 0.0F }), PIDF({ 0.5F, 10.0F, 0.0F, 0.0F, 0.0F })
+    }};
+    benchmark("PIDFReplay::run", "4 gain sets", SAMPLE_COUNT*pids.size(), [&replay, &pids]() {
+        float sum = 0.0F;
+        replay.run(&pids[0], pids.size(), DELTA_T, [&sum](size_t, size_t, const PIDFRecorder::values_t* values, size_t count) {
+            sum += values[count - 1][7];
+        });
+        return sum;
+    });
+}
+
+void test_benchmark_PIDFScheduler()
+{
+    // 48 loops, 16 each at 1kHz, 250Hz, and 50Hz, on a simulated clock, so this is the cost of the timer wheel and dispatch,
+    // including the sensor read, update, and actuator call, reported per loop run
+    enum { LOOPS_PER_RATE = 16, RUNS_PER_SECOND = LOOPS_PER_RATE*(1000 + 250 + 50) };
+    PIDFSimulatedClock clock;
+    PIDFScheduler scheduler(clock, 1, 50000);
+    static std::array<PIDF, 3*LOOPS_PER_RATE> pids {};
+    float sum = 0.0F;
+    const std::array<uint64_t, 3> periods {{ 1000000, 4000000, 20000000 }};
+    for (size_t ii = 0; ii < pids.size(); ++ii) {
+        pids[ii].setPID({ 0.5F, 2.0F, 0.0F, 0.0F, 0.0F });
+        pids[ii].setSetpoint(1.0F);
+        scheduler.addLoop(pids[ii], periods[ii % periods.size()], [ii]() { return stream.measurements[ii]; }, [&sum](float output) { sum += output; });
+    }
+    benchmark("PIDFScheduler::runUntil", "48_loops_3_rates", RUNS_PER_SECOND, [&]() {
+        scheduler.runUntil(clock.now() + 1000000000);
+        return sum;
+    });
+}
+
+void test_benchmark_PIDFSimulation()
+{
+    // closed loop simulation, one minute of 8kHz control per run, reported per simulated step
+    const PIDFSimulation::scenario_t scenario { DELTA_T, 60.0F, 1.0F, 0.01F, 30.0F, 0.2F, 2.0F, 0.02F };
+    enum { STEPS = 60*8000 };
+    auto simulate = [&scenario](auto& plant) {
+        PIDF pid({ 2.0F, 20.0F, 0.0F, 0.0F, 0.0F });
+        pid.setSampleTime(DELTA_T);
+        plant.reset();
+        const PIDFSimulation::metrics_t metrics = PIDFSimulation::run(plant, scenario, [&pid](float setpoint, float measurement) {
+            pid.setSetpoint(setpoint);
+            return pid.update(measurement);
+        });
+        return static_cast<float>(metrics.iae);
+    };
+    PIDFPlantFOPDT<40> fopdt(1.0F, 0.1F, DELTA_T);
+    benchmark("PIDFSimulation::run", "fopdt", STEPS, [&simulate, &fopdt]() { return simulate(fopdt); });
+    PIDFPlantSecondOrder secondOrder(1.0F, 30.0F, 0.7F, DELTA_T);
+    benchmark("PIDFSimulation::run", "second_order", STEPS, [&simulate, &secondOrder]() { return simulate(secondOrder); });
+    PIDFPlantMotor motor(0.5F, 0.01F, 0.02F, 0.1F, DELTA_T);
+    benchmark("PIDFSimulation::run", "motor", STEPS, [&simulate, &motor]() { return simulate(motor); });
+}
+
+void test_benchmark_PIDFOptimizer()
+{
+    // random search on one thread and on every core, reported per simulated step, to check the scaling with core count
+    const std::array<PIDFSimulation::scenario_t, 1> simulationScenarios {{ { DELTA_T, 0.5F, 1.0F, 0.0F, 0.25F, 0.2F, 2.0F, 0.02F } }};
+    const PIDFSimulationCost<PIDFPlantFOPDT<40>, 1> cost(PIDFPlantFOPDT<40>(1.0F, 0.1F, DELTA_T), simulationScenarios, 0.01F);
+    const PIDFOptimizer::candidate_t minimum { { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const PIDFOptimizer::candidate_t maximum { { 5.0F, 50.0F, 0.01F, 0.0F, 0.0F }, 0.0F, 2.0F };
+    enum { CANDIDATE_COUNT = 256, STEPS = 4000 };
+    PIDFOptimizer single(1);
+    benchmark("PIDFOptimizer::random", "1_thread", CANDIDATE_COUNT*STEPS, [&]() {
+        return single.random(minimum, maximum, CANDIDATE_COUNT, 1, cost)[0].cost;
+    });
+    PIDFOptimizer all;
+    benchmark("PIDFOptimizer::random", "all_threads", CANDIDATE_COUNT*STEPS, [&]() {
+        return all.random(minimum, maximum, CANDIDATE_COUNT, 1, cost)[0].cost;
+    });
+}
+void test_benchmark_PIDFFrequencyResponse()
+{
+    // margins of a PID controller against an FOPDT plant, on a 200 point grid, reported per grid point,
+    // for comparison with the cost per simulated step of PIDFSimulation::run
+    enum { POINT_COUNT = 200, ANALYSIS_COUNT = 100 };
+    PIDFFrequencyResponse response(DELTA_T, 0.1F, 1.0e5F, POINT_COUNT);
+    response.setPlant(PIDFTransferFunction::fopdt(1.0F, 0.1F, 0.005F));
+    benchmark("PIDFFrequencyResponse::analyze", "fopdt_200_points", ANALYSIS_COUNT*POINT_COUNT, [&response]() {
+        float sum = 0.0F;
+        for (size_t ii = 0; ii < ANALYSIS_COUNT; ++ii) {
+            const PIDFFrequencyResponse::margins_t margins = response.analyze({ 1.0F + 0.01F*static_cast<float>(ii), 20.0F, 0.002F, 0.0F, 0.0F });
+            sum += margins.phaseMargin + margins.sensitivityPeak;
+        }
+        return sum;
+    });
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-avoid-non-const-global-variables)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    createStream();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_benchmark_PIDF);
+    RUN_TEST(test_benchmark_PIDF_block);
+    RUN_TEST(test_benchmark_PIDFT);
+    RUN_TEST(test_benchmark_denormals);
+    RUN_TEST(test_benchmark_PIDFBank);
+    RUN_TEST(test_benchmark_PIDFVec);
+    RUN_TEST(test_benchmark_PIDFGainScheduler);
+    RUN_TEST(test_benchmark_PIDFDirectForm);
+    RUN_TEST(test_benchmark_PIDFFixed);
+    RUN_TEST(test_benchmark_PIDFTrajectory);
+    RUN_TEST(test_benchmark_PIDFInstrumentation);
+    RUN_TEST(test_benchmark_PIDFReplay);
+    RUN_TEST(test_benchmark_PIDFScheduler);
+    RUN_TEST(test_benchmark_PIDFSimulation);
+    RUN_TEST(test_benchmark_PIDFOptimizer);
+    RUN_TEST(test_benchmark_PIDFFrequencyResponse);
+
+    UNITY_END();
+}
@@ -555,6 +555,47 @@ void test_integral_saturation_negative()
     TEST_ASSERT_EQUAL_FLOAT(1.1F, error.I);
     TEST_ASSERT_EQUAL_FLOAT(1.5F, output);
 }
+
+void test_fixed_rate()
+{
+    // use a sample time that is a power of two, so 1/deltaT and ki*deltaT are exact and the results are identical
+    const float deltaT {0.125F};
+    PIDF pid(PIDF::PIDF_t { 0.3F, 0.2F, 0.1F, 0.05F, 0.02F });
+    PIDF pidFixed(PIDF::PIDF_t { 0.3F, 0.2F, 0.1F, 0.05F, 0.02F });
+    pid.setIntegralLimit(0.7F);
+    pidFixed.setIntegralLimit(0.7F);
+    pidFixed.setSampleTime(deltaT);
+    TEST_ASSERT_EQUAL_FLOAT(deltaT, pidFixed.getSampleTime());
+    // gain getters return the continuous time values
+    TEST_ASSERT_EQUAL_FLOAT(0.2F, pidFixed.getI());
+    TEST_ASSERT_EQUAL_FLOAT(0.1F, pidFixed.getD());
+
+    pid.setSetpoint(5.0F);
+    pidFixed.setSetpoint(5.0F);
+    TEST_ASSERT_EQUAL_FLOAT(pid.update(1.0F, deltaT), pidFixed.update(1.0F));
+    TEST_ASSERT_EQUAL_FLOAT(pid.getErrorI(), pidFixed.getErrorI());
+    TEST_ASSERT_EQUAL_FLOAT(pid.getErrorD(), pidFixed.getErrorD());
+    TEST_ASSERT_EQUAL_FLOAT(pid.updateDelta(2.0F, 0.5F, deltaT), pidFixed.updateDelta(2.0F, 0.5F));
+    TEST_ASSERT_EQUAL_FLOAT(pid.updateDeltaITerm(3.0F, 0.5F, 0.1F, deltaT), pidFixed.updateDeltaITerm(3.0F, 0.5F, 0.1F));
+    TEST_ASSERT_EQUAL_FLOAT(pid.updateSPI(3.5F, deltaT), pidFixed.updateSPI(3.5F));
+    TEST_ASSERT_EQUAL_FLOAT(pid.updateSKPI(3.5F, deltaT), pidFixed.updateSKPI(3.5F));
+    TEST_ASSERT_EQUAL_FLOAT(pid.updateSPD(4.0F, 0.5F, deltaT), pidFixed.updateSPD(4.0F, 0.5F));
+    TEST_ASSERT_EQUAL_FLOAT(pid.updateSKPD(4.5F, 0.5F, deltaT), pidFixed.updateSKPD(4.5F, 0.5F));
+
+    // changing the gains recalculates the discrete coefficients
+    pid.setI(0.5F);
+    pidFixed.setI(0.5F);
+    TEST_ASSERT_EQUAL_FLOAT(pid.update(4.0F, deltaT), pidFixed.update(4.0F));
+    TEST_ASSERT_EQUAL_FLOAT(pid.getErrorI(), pidFixed.getErrorI());
+    pidFixed.switchIntegrationOff();
+    const float integral = pidFixed.getErrorI();
+    pidFixed.update(3.0F);
+    TEST_ASSERT_EQUAL_FLOAT(integral, pidFixed.getErrorI());
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, pidFixed.getI());
+    pidFixed.switchIntegrationOn();
+    pidFixed.update(3.0F);
+    TEST_ASSERT_EQUAL_FLOAT(0.5F*2.0F*deltaT, pidFixed.getErrorI());
+}
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
@@ -570,6 +611,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     RUN_TEST(test_integral_limit);
     RUN_TEST(test_integral_saturation_positive);
     RUN_TEST(test_integral_saturation_negative);
+    RUN_TEST(test_fixed_rate);
 
     UNITY_END();
 }
@@ -0,0 +1,162 @@
+#include <PIDF.h>
+#include <PIDFAutoTuner.h>
+#include <PIDFSimulation.h>
+#include <cmath>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 0.001F;
+enum { DELAY_SAMPLES = 50 }; // 50ms dead time
+
+static constexpr PIDFAutoTuner::config_t config { 1.0F, 0.0F, 0.0F, 60.0F, 2, 3 };
+
+template <typename PLANT>
+static void runTuner(PIDFAutoTuner& tuner, PLANT& plant, float setpoint, const PIDFAutoTuner::config_t& tunerConfig)
+{
+    tuner.setSampleTime(DELTA_T);
+    tuner.start(setpoint, tunerConfig);
+    while (tuner.isRunning()) {
+        plant.update(tuner.update(plant.getOutput()));
+    }
+}
+
+void test_calculate_pid()
+{
+    PIDF::PIDF_t pid = PIDFAutoTuner::calculatePID(PIDFAutoTuner::ZIEGLER_NICHOLS_PID, 10.0F, 2.0F);
+    TEST_ASSERT_EQUAL_FLOAT(6.0F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(6.0F, pid.ki);
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, pid.kd);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.ks);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.kk);
+    pid = PIDFAutoTuner::calculatePID(PIDFAutoTuner::ZIEGLER_NICHOLS_PI, 10.0F, 2.0F);
+    TEST_ASSERT_EQUAL_FLOAT(4.5F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(2.7F, pid.ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.kd);
+    pid = PIDFAutoTuner::calculatePID(PIDFAutoTuner::TYREUS_LUYBEN_PI, 10.0F, 2.0F);
+    TEST_ASSERT_EQUAL_FLOAT(3.125F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(3.125F/4.4F, pid.ki);
+    pid = PIDFAutoTuner::calculatePID(PIDFAutoTuner::TYREUS_LUYBEN_PID, 10.0F, 2.0F);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F/2.2F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F/2.2F*2.0F/6.3F, pid.kd);
+    pid = PIDFAutoTuner::calculatePID(PIDFAutoTuner::SIMC_PI, 10.0F, 2.0F);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F/PIDFAutoTuner::PI, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F/PIDFAutoTuner::PI/4.0F, pid.ki);
+}
+
+void test_integrating_plant()
+{
+    // relay feedback on k*exp(-theta*s)/s gives a triangle wave with period 4*theta and amplitude relayAmplitude*k*theta
+    PIDFAutoTuner tuner;
+    TEST_ASSERT_EQUAL(PIDFAutoTuner::IDLE, tuner.getState());
+    PIDFPlantIntegrating<DELAY_SAMPLES> plant(2.0F, DELTA_T);
+    runTuner(tuner, plant, 0.0F, config);
+    TEST_ASSERT_TRUE(tuner.isComplete());
+    TEST_ASSERT_EQUAL(5, tuner.getCycleCount()); // 2 settling cycles and 3 measured cycles
+    TEST_ASSERT_FLOAT_WITHIN(0.003F, 0.2F, tuner.getUltimatePeriod());
+    TEST_ASSERT_FLOAT_WITHIN(0.003F, 0.1F, tuner.getOscillationAmplitude());
+    TEST_ASSERT_FLOAT_WITHIN(0.2F, 4.0F/(PIDFAutoTuner::PI*0.1F), tuner.getUltimateGain());
+    // after tuning, output is the relay bias
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, tuner.update(5.0F));
+}
+
+void test_first_order_plant()
+{
+    // relay feedback on K*exp(-theta*s)/(tau*s + 1), with a symmetric relay, oscillates with
+    // period 2*theta + 2*tau*ln(2 - exp(-theta/tau)) and amplitude relayAmplitude*K*(1 - exp(-theta/tau))
+    // (the true ultimate gain is 32, the describing function approximation gives 26)
+    PIDFAutoTuner tuner;
+    PIDFPlantFOPDT<DELAY_SAMPLES> plant(1.0F, 1.0F, DELTA_T);
+    runTuner(tuner, plant, 0.5F, PIDFAutoTuner::config_t { 1.0F, 0.5F, 0.0F, 60.0F, 2, 3 });
+    TEST_ASSERT_TRUE(tuner.isComplete());
+    TEST_ASSERT_FLOAT_WITHIN(0.003F, 0.1F + 2.0F*std::log(2.0F - std::exp(-0.05F)), tuner.getUltimatePeriod());
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 1.0F - std::exp(-0.05F), tuner.getOscillationAmplitude());
+
+    // closed loop with each of the rules settles at the setpoint
+    for (auto rule : { PIDFAutoTuner::ZIEGLER_NICHOLS_PI, PIDFAutoTuner::ZIEGLER_NICHOLS_PID,
+                       PIDFAutoTuner::TYREUS_LUYBEN_PI, PIDFAutoTuner::TYREUS_LUYBEN_PID, PIDFAutoTuner::SIMC_PI }) {
+        PIDF pid(tuner.getPID(rule));
+        pid.setSampleTime(DELTA_T);
+        pid.setSetpoint(1.0F);
+        PIDFPlantFOPDT<DELAY_SAMPLES> closedLoop(1.0F, 1.0F, DELTA_T);
+        for (int ii = 0; ii < 20000; ++ii) {
+            closedLoop.update(pid.update(closedLoop.getOutput()));
+        }
+        TEST_ASSERT_FLOAT_WITHIN(0.01F, 1.0F, closedLoop.getOutput());
+    }
+}
+
+void test_long_run_period()
+{
+    // the period is measured in samples, so does not drift when the tuner runs for a long time before measuring
+    PIDFAutoTuner tuner;
+    PIDFPlantIntegrating<DELAY_SAMPLES> plant(2.0F, DELTA_T);
+    runTuner(tuner, plant, 0.0F, config);
+    const float period = tuner.getUltimatePeriod();
+    PIDFAutoTuner longTuner;
+    PIDFPlantIntegrating<DELAY_SAMPLES> longPlant(2.0F, DELTA_T);
+    runTuner(longTuner, longPlant, 0.0F, PIDFAutoTuner::config_t { 1.0F, 0.0F, 0.0F, 1000.0F, 2000, 3 });
+    TEST_ASSERT_TRUE(longTuner.isComplete());
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, period, longTuner.getUltimatePeriod());
+}
+
+void test_zero_measure_cycles()
+{
+    // measureCycles of zero is treated as one, so the tuner still completes
+    PIDFAutoTuner tuner;
+    PIDFPlantIntegrating<DELAY_SAMPLES> plant(2.0F, DELTA_T);
+    runTuner(tuner, plant, 0.0F, PIDFAutoTuner::config_t { 1.0F, 0.0F, 0.0F, 60.0F, 2, 1 });
+    PIDFAutoTuner zeroTuner;
+    PIDFPlantIntegrating<DELAY_SAMPLES> zeroPlant(2.0F, DELTA_T);
+    runTuner(zeroTuner, zeroPlant, 0.0F, PIDFAutoTuner::config_t { 1.0F, 0.0F, 0.0F, 60.0F, 2, 0 });
+    TEST_ASSERT_TRUE(zeroTuner.isComplete());
+    TEST_ASSERT_EQUAL_FLOAT(tuner.getUltimatePeriod(), zeroTuner.getUltimatePeriod());
+    TEST_ASSERT_EQUAL_FLOAT(tuner.getOscillationAmplitude(), zeroTuner.getOscillationAmplitude());
+}
+
+void test_hysteresis_and_timeout()
+{
+    PIDFAutoTuner tuner;
+    tuner.setSampleTime(DELTA_T);
+    // hysteresis larger than the oscillation: the relay never switches, so tuning times out
+    tuner.start(0.0F, PIDFAutoTuner::config_t { 1.0F, 0.5F, 100.0F, 1.0F, 0, 1 });
+    PIDFPlantIntegrating<DELAY_SAMPLES> plant(2.0F, DELTA_T);
+    for (int ii = 0; ii < 2000 && tuner.isRunning(); ++ii) {
+        plant.update(tuner.update(-plant.getOutput()));
+    }
+    TEST_ASSERT_EQUAL(PIDFAutoTuner::FAILED, tuner.getState());
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, tuner.update(0.0F));
+
+    // with hysteresis the amplitude is larger, and allowed for in the ultimate gain
+    PIDFPlantIntegrating<DELAY_SAMPLES> hysteresisPlant(2.0F, DELTA_T);
+    tuner.start(0.0F, PIDFAutoTuner::config_t { 1.0F, 0.0F, 0.05F, 60.0F, 2, 3 });
+    while (tuner.isRunning()) {
+        hysteresisPlant.update(tuner.update(hysteresisPlant.getOutput()));
+    }
+    TEST_ASSERT_TRUE(tuner.isComplete());
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, 0.15F, tuner.getOscillationAmplitude());
+    const float a = tuner.getOscillationAmplitude();
+    TEST_ASSERT_EQUAL_FLOAT(4.0F/(PIDFAutoTuner::PI*std::sqrt(a*a - 0.05F*0.05F)), tuner.getUltimateGain());
+    tuner.stop();
+    TEST_ASSERT_EQUAL(PIDFAutoTuner::IDLE, tuner.getState());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_calculate_pid);
+    RUN_TEST(test_integrating_plant);
+    RUN_TEST(test_first_order_plant);
+    RUN_TEST(test_long_run_period);
+    RUN_TEST(test_zero_measure_cycles);
+    RUN_TEST(test_hysteresis_and_timeout);
+
+    UNITY_END();
+}
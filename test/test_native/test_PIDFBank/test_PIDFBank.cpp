@@ -0,0 +1,189 @@
+#include <PIDFBank.h>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static uint32_t seed = 12345;
+static float randomFloat(float range)
+{
+    // simple linear congruential generator, so tests are repeatable
+    seed = seed*1664525U + 1013904223U;
+    return range*(static_cast<float>(seed >> 8U)/8388608.0F - 1.0F);
+}
+
+template <size_t N, typename T>
+static void configure(PIDFBank<N>& bank, std::array<T, N>& pids)
+{
+    for (size_t ii = 0; ii < N; ++ii) {
+        const PIDF::PIDF_t gains { 0.5F + 0.1F*static_cast<float>(ii), 0.3F, 0.01F*static_cast<float>(ii), 0.1F, (ii & 1U) ? 0.02F : 0.0F };
+        bank.setPID(ii, gains);
+        pids[ii].setPID(gains);
+        // exercise all combinations of integral limit, threshold and output saturation
+        if (ii & 1U) {
+            bank.setIntegralLimit(ii, 0.4F);
+            pids[ii].setIntegralLimit(0.4F);
+        }
+        if (ii & 2U) {
+            bank.setIntegralThreshold(ii, 0.2F);
+            pids[ii].setIntegralThreshold(0.2F);
+        }
+        if (ii & 4U) {
+            bank.setOutputSaturationValue(ii, 1.0F);
+            pids[ii].setOutputSaturationValue(1.0F);
+        }
+        if constexpr (T::HAS_BACK_CALCULATION) {
+            if (ii & 8U) {
+                bank.setTrackingGain(ii, 20.0F);
+                pids[ii].setTrackingGain(20.0F);
+            }
+        }
+    }
+}
+
+/*!
+Without fused multiply-adds the bank's results are bit-identical to the scalar controller's (except that the sign of a zero
+may differ, which == allows). With them, each fused operation skips one rounding, so the results agree to within a few ULP
+of the largest term, scale.
+*/
+static void assertSameAsScalar(float expected, float actual, float scale)
+{
+#if defined(__FP_FAST_FMAF)
+    TEST_ASSERT_FLOAT_WITHIN(4.0F*FLT_EPSILON*scale, expected, actual);
+#else
+    (void)scale;
+    TEST_ASSERT_TRUE(expected == actual);
+#endif
+}
+
+template <size_t N, typename T = PIDF>
+static void compareWithScalar()
+{
+    PIDFBank<N> bank;
+    std::array<T, N> pids;
+    configure(bank, pids);
+
+    std::array<float, N> measurements {};
+    std::array<float, N> previous {};
+    std::array<float, N> deltas {};
+    std::array<float, N> outputs {};
+    const float deltaT = 0.005F;
+
+    for (size_t step = 0; step < 500; ++step) {
+        if (step % 50 == 0) {
+            for (size_t ii = 0; ii < N; ++ii) {
+                const float setpoint = randomFloat(3.0F);
+                bank.setSetpoint(ii, setpoint);
+                bank.setSetpointDerivative(ii, setpoint*0.1F);
+                pids[ii].setSetpoint(setpoint);
+                pids[ii].setSetpointDerivative(setpoint*0.1F);
+            }
+        }
+        for (size_t ii = 0; ii < N; ++ii) {
+            measurements[ii] = previous[ii] + randomFloat(0.2F);
+            deltas[ii] = measurements[ii] - previous[ii];
+            previous[ii] = measurements[ii];
+        }
+        bank.update(&measurements[0], &deltas[0], deltaT, &outputs[0]);
+        for (size_t ii = 0; ii < N; ++ii) {
+            const float output = pids[ii].updateDelta(measurements[ii], deltas[ii], deltaT);
+            const PIDF::error_t error = pids[ii].getError();
+            const PIDF::error_t bankError = bank.getError(ii);
+            const float scale = std::fmax(std::fmax(std::fmax(std::fabs(error.P), std::fabs(error.I)), std::fmax(std::fabs(error.D), std::fabs(error.S))),
+                std::fmax(std::fabs(error.K), std::fabs(output)));
+            assertSameAsScalar(output, outputs[ii], scale);
+            assertSameAsScalar(error.P, bankError.P, scale);
+            assertSameAsScalar(error.I, bankError.I, scale);
+            assertSameAsScalar(error.D, bankError.D, scale);
+            assertSameAsScalar(error.S, bankError.S, scale);
+            assertSameAsScalar(error.K, bankError.K, scale);
+        }
+    }
+}
+
+void test_PIDFBank_init()
+{
+    const PIDFBank<5> bank;
+    TEST_ASSERT_EQUAL(5, bank.size());
+    TEST_ASSERT_EQUAL(8, PIDFBank<5>::CAPACITY);
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(&bank) % PIDFBank<5>::ALIGNMENT); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    const PIDF::PIDF_t pid = bank.getPID(4);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, bank.getSetpoint(4));
+}
+
+void test_PIDFBank_PI()
+{
+    PIDFBank<2> bank;
+    bank.setPID(0, PIDF::PIDF_t { 0.3F, 0.2F, 0.0F, 0.0F, 0.0F });
+    bank.setSetpoint(0, 5.0F);
+    const std::array<float, 2> measurements { 1.0F, 0.0F };
+    const std::array<float, 2> deltas { 1.0F, 0.0F };
+    std::array<float, 2> outputs {};
+
+    bank.update(&measurements[0], &deltas[0], 1.0F, &outputs[0]);
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, outputs[0]); // 0.3*4 + 0.2*4
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, outputs[1]);
+    TEST_ASSERT_EQUAL_FLOAT(0.8F, bank.getErrorI(0));
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, bank.getPreviousError(0));
+
+    bank.resetAll();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, bank.getErrorI(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, bank.getSetpoint(0));
+}
+
+void test_PIDFBank_matches_PIDF()
+{
+    compareWithScalar<1>();
+    compareWithScalar<8>();
+    compareWithScalar<13>();
+    compareWithScalar<64>();
+    // controllers 8 to 15 use back-calculation
+    compareWithScalar<16, PIDFT<PIDFTerms::ALL | PIDFTerms::BACK_CALCULATION>>();
+}
+
+void test_PIDFBank_scalar_matches_simd()
+{
+    PIDFBank<16> bank;
+    PIDFBank<16> bankScalar;
+    std::array<PIDFT<PIDFTerms::ALL | PIDFTerms::BACK_CALCULATION>, 16> pids;
+    configure(bank, pids);
+    configure(bankScalar, pids);
+    std::array<float, 16> measurements {};
+    std::array<float, 16> deltas {};
+    std::array<float, 16> outputs {};
+    std::array<float, 16> outputsScalar {};
+    for (size_t ii = 0; ii < 16; ++ii) {
+        bank.setSetpoint(ii, 1.0F);
+        bankScalar.setSetpoint(ii, 1.0F);
+    }
+    for (size_t step = 0; step < 100; ++step) {
+        for (size_t ii = 0; ii < 16; ++ii) {
+            deltas[ii] = randomFloat(0.1F);
+            measurements[ii] += deltas[ii];
+        }
+        bank.update(&measurements[0], &deltas[0], 0.01F, &outputs[0]);
+        bankScalar.updateScalar(&measurements[0], &deltas[0], 0.01F, &outputsScalar[0]);
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(&outputsScalar[0], &outputs[0], 16);
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_PIDFBank_init);
+    RUN_TEST(test_PIDFBank_PI);
+    RUN_TEST(test_PIDFBank_matches_PIDF);
+    RUN_TEST(test_PIDFBank_scalar_matches_simd);
+
+    UNITY_END();
+}
@@ -0,0 +1,195 @@
+#include <PIDFCascade.h>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr PIDF::PIDF_t outerGains { 4.0F, 1.0F, 0.0F, 0.0F, 0.0F };
+static constexpr PIDF::PIDF_t innerGains { 0.5F, 2.0F, 0.01F, 0.0F, 0.02F };
+
+void test_cascade_same_as_two_controllers()
+{
+    // deltaT is a power of 2, so 1/deltaT is exact and the results are the same as with separate controllers
+    constexpr float deltaT = 0.125F;
+    PIDFCascade<> cascade(outerGains, innerGains);
+    cascade.setSampleTime(deltaT, 1);
+    PIDF outer(outerGains);
+    PIDF inner(innerGains);
+    outer.setSampleTime(deltaT);
+    inner.setSampleTime(deltaT);
+
+    cascade.setSetpoint(1.0F);
+    outer.setSetpoint(1.0F);
+    float angle = 0.0F;
+    float rate = 0.0F;
+    for (int ii = 0; ii < 20; ++ii) {
+        inner.setSetpoint(outer.update(angle), deltaT);
+        const float expected = inner.update(rate);
+        const float output = cascade.update(angle, rate);
+        TEST_ASSERT_EQUAL_FLOAT(expected, output);
+        TEST_ASSERT_EQUAL_FLOAT(inner.getSetpoint(), cascade.getInnerSetpoint());
+        TEST_ASSERT_EQUAL_FLOAT(inner.getErrorK(), cascade.getInner().getErrorK());
+        rate += 0.1F*output;
+        angle += rate*deltaT;
+    }
+}
+
+void test_cascade_rate_division()
+{
+    constexpr float deltaT = 0.125F;
+    constexpr uint32_t rateDivisor = 4;
+    PIDFCascade<> cascade(outerGains, innerGains);
+    cascade.setSampleTime(deltaT, rateDivisor);
+    TEST_ASSERT_EQUAL(rateDivisor, cascade.getRateDivisor());
+    TEST_ASSERT_EQUAL_FLOAT(deltaT*rateDivisor, cascade.getOuter().getSampleTime());
+    TEST_ASSERT_EQUAL_FLOAT(deltaT, cascade.getInner().getSampleTime());
+    PIDF outer(outerGains);
+    PIDF inner(innerGains);
+    outer.setSampleTime(deltaT*rateDivisor);
+    inner.setSampleTime(deltaT);
+
+    cascade.setSetpoint(1.0F);
+    outer.setSetpoint(1.0F);
+    float angle = 0.0F;
+    float rate = 0.0F;
+    for (uint32_t ii = 0; ii < 40; ++ii) {
+        if (ii % rateDivisor == 0) {
+            inner.setSetpoint(outer.update(angle), deltaT*rateDivisor);
+        }
+        const float expected = inner.update(rate);
+        const float output = cascade.update(angle, rate);
+        TEST_ASSERT_EQUAL_FLOAT(expected, output);
+        rate += 0.1F*output;
+        angle += rate*deltaT;
+    }
+}
+
+void test_cascade_anti_windup()
+{
+    constexpr float deltaT = 0.125F;
+    PIDFCascade<> cascade(outerGains, innerGains);
+    cascade.setSampleTime(deltaT, 2);
+    cascade.setOutputLimit(1.0F);
+    cascade.setSetpoint(10.0F);
+
+    // the measurements do not change, so the inner output saturates and the outer integral is frozen
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, cascade.update(0.0F, 0.0F));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, cascade.getSaturation());
+    const float outerIntegral = cascade.getOuter().getErrorI();
+    TEST_ASSERT_EQUAL_FLOAT(10.0F*1.0F*0.25F, outerIntegral);
+    for (int ii = 0; ii < 10; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(1.0F, cascade.update(0.0F, 0.0F));
+    }
+    TEST_ASSERT_EQUAL_FLOAT(outerIntegral, cascade.getOuter().getErrorI());
+
+    // error in the other direction is integrated
+    cascade.setSetpoint(-10.0F);
+    cascade.update(0.0F, 0.0F);
+    cascade.update(0.0F, 0.0F);
+    TEST_ASSERT_EQUAL_FLOAT(outerIntegral - 10.0F*1.0F*0.25F, cascade.getOuter().getErrorI());
+
+    // limited inner setpoint also freezes the outer integral
+    PIDFCascade<> limited(outerGains, { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    limited.setSampleTime(deltaT, 1);
+    limited.setInnerSetpointLimit(5.0F);
+    limited.setSetpoint(10.0F);
+    limited.update(0.0F, 0.0F);
+    TEST_ASSERT_EQUAL_FLOAT(5.0F, limited.getInnerSetpoint());
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, limited.getSaturation());
+    const float limitedIntegral = limited.getOuter().getErrorI();
+    limited.update(0.0F, 0.0F);
+    TEST_ASSERT_EQUAL_FLOAT(limitedIntegral, limited.getOuter().getErrorI());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, limited.getInner().getErrorRawK()); // inner setpoint unchanged
+
+    limited.resetAll();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, limited.getSaturation());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, limited.getOuter().getErrorI());
+}
+
+void test_cascade_inner_output_saturation()
+{
+    // the inner controller's own output saturation value is also treated as saturation, with no cascade output limit
+    constexpr float deltaT = 0.125F;
+    PIDFCascade<> cascade(outerGains, innerGains);
+    cascade.setSampleTime(deltaT, 2);
+    cascade.getInner().setOutputSaturationValue(1.0F);
+    cascade.setSetpoint(10.0F);
+
+    TEST_ASSERT_TRUE(cascade.update(0.0F, 0.0F) >= 1.0F);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, cascade.getSaturation());
+    const float outerIntegral = cascade.getOuter().getErrorI();
+    for (int ii = 0; ii < 10; ++ii) {
+        cascade.update(0.0F, 0.0F);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(outerIntegral, cascade.getOuter().getErrorI());
+
+    // without the inner saturation value the outer integral winds up
+    PIDFCascade<> unsaturated(outerGains, innerGains);
+    unsaturated.setSampleTime(deltaT, 2);
+    unsaturated.setSetpoint(10.0F);
+    for (int ii = 0; ii < 11; ++ii) {
+        unsaturated.update(0.0F, 0.0F);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, unsaturated.getSaturation());
+    TEST_ASSERT_TRUE(unsaturated.getOuter().getErrorI() > outerIntegral);
+}
+
+void test_cascade_double()
+{
+    static constexpr PIDFDouble::PIDF_t outerGainsDouble { 4.0, 1.0, 0.0, 0.0, 0.0 };
+    static constexpr PIDFDouble::PIDF_t innerGainsDouble { 0.5, 2.0, 0.01, 0.0, 0.02 };
+    constexpr double deltaT = 0.125;
+    PIDFCascade<PIDFDouble, PIDFDouble> cascade(outerGainsDouble, innerGainsDouble);
+    static_assert(std::is_same_v<double, decltype(cascade.update(0.0, 0.0))>);
+    cascade.setSampleTime(deltaT, 1);
+    PIDFDouble outer(outerGainsDouble);
+    PIDFDouble inner(innerGainsDouble);
+    outer.setSampleTime(deltaT);
+    inner.setSampleTime(deltaT);
+
+    cascade.setSetpoint(1.0);
+    outer.setSetpoint(1.0);
+    double angle = 0.0;
+    double rate = 0.0;
+    for (int ii = 0; ii < 20; ++ii) {
+        inner.setSetpoint(outer.update(angle), deltaT);
+        const double expected = inner.update(rate);
+        const double output = cascade.update(angle, rate);
+        TEST_ASSERT_TRUE(expected == output);
+        rate += 0.1*output;
+        angle += rate*deltaT;
+    }
+}
+
+void test_cascade_PIDFT()
+{
+    using PI = PIDFT<PIDFTerms::PI | PIDFTerms::FIXED_RATE>;
+    using PIK = PIDFT<PIDFTerms::PI | PIDFTerms::K | PIDFTerms::FIXED_RATE>;
+    PIDFCascade<PI, PIK> cascade(outerGains, innerGains);
+    cascade.setSampleTime(0.125F, 2);
+    cascade.setSetpoint(1.0F);
+    cascade.update(0.0F, 0.0F);
+    // outer: 4*1 + 1*1*0.25 = 4.25, inner: 0.5*4.25 + 2*4.25*0.125 + 0.02*4.25/0.25
+    TEST_ASSERT_EQUAL_FLOAT(4.25F, cascade.getInnerSetpoint());
+    TEST_ASSERT_EQUAL_FLOAT(0.02F*4.25F*4.0F, cascade.getInner().getErrorK());
+    TEST_ASSERT_EQUAL_FLOAT(0.5F*4.25F + 2.0F*4.25F*0.125F + 0.02F*4.25F*4.0F, cascade.update(0.0F, 0.0F) - 2.0F*4.25F*0.125F);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_cascade_same_as_two_controllers);
+    RUN_TEST(test_cascade_rate_division);
+    RUN_TEST(test_cascade_anti_windup);
+    RUN_TEST(test_cascade_inner_output_saturation);
+    RUN_TEST(test_cascade_double);
+    RUN_TEST(test_cascade_PIDFT);
+
+    UNITY_END();
+}
@@ -0,0 +1,74 @@
+#include <PIDF.h>
+#include <PIDFDenormalGuard.h>
+#include <cfloat>
+#include <cmath>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static float halve(float x)
+{
+    volatile float half = 0.5F; // stop the compiler evaluating the product at compile time
+    return x*half;
+}
+
+void test_denormal_guard()
+{
+    if (!PIDFDenormalGuard::isSupported()) {
+        TEST_ASSERT_FALSE(PIDFDenormalGuard::isFlushing());
+        return;
+    }
+    TEST_ASSERT_FALSE(PIDFDenormalGuard::isFlushing());
+    TEST_ASSERT_TRUE(halve(FLT_MIN) != 0.0F);
+    {
+        const PIDFDenormalGuard guard;
+        TEST_ASSERT_TRUE(PIDFDenormalGuard::isFlushing());
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, halve(FLT_MIN));
+        {
+            const PIDFDenormalGuard nested;
+            TEST_ASSERT_TRUE(PIDFDenormalGuard::isFlushing());
+        }
+        // leaving the nested guard restores the outer guard's mode
+        TEST_ASSERT_TRUE(PIDFDenormalGuard::isFlushing());
+    }
+    TEST_ASSERT_FALSE(PIDFDenormalGuard::isFlushing());
+    TEST_ASSERT_TRUE(halve(FLT_MIN) != 0.0F);
+}
+
+void test_denormal_guard_update()
+{
+    // an oscillation decaying through the subnormal range leaves subnormal state in a controller without
+    // PIDFTerms::FLUSH_DENORMALS, unless the guard is in scope
+    PIDFT<PIDFTerms::PID> pid({ 0.5F, 2.0F, 0.01F, 0.0F, 0.0F });
+    PIDFT<PIDFTerms::PID> pidGuarded({ 0.5F, 2.0F, 0.01F, 0.0F, 0.0F });
+    bool subnormal = false;
+    bool subnormalGuarded = false;
+    float amplitude = 1.0e-36F;
+    for (int ii = 0; ii < 4000; ++ii) {
+        const float m = amplitude*std::cos(0.05F*static_cast<float>(ii));
+        amplitude *= 0.99856F;
+        pid.update(m, 1.0F/8000.0F);
+        subnormal = subnormal || std::fpclassify(pid.getErrorRawD()) == FP_SUBNORMAL;
+        const PIDFDenormalGuard guard;
+        pidGuarded.update(m, 1.0F/8000.0F);
+        subnormalGuarded = subnormalGuarded || std::fpclassify(pidGuarded.getErrorRawD()) == FP_SUBNORMAL;
+    }
+    TEST_ASSERT_TRUE(subnormal);
+    TEST_ASSERT_EQUAL(!PIDFDenormalGuard::isSupported(), subnormalGuarded);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_denormal_guard);
+    RUN_TEST(test_denormal_guard_update);
+
+    UNITY_END();
+}
@@ -0,0 +1,209 @@
+#include <PIDF.h>
+#include <PIDFDirectForm.h>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 0.01F;
+
+static uint32_t seed = 12345;
+static float randomFloat(float range)
+{
+    seed = seed*1664525U + 1013904223U;
+    return range*(static_cast<float>(seed >> 8U)/8388608.0F - 1.0F);
+}
+
+void test_coefficients()
+{
+    // PD controller: output = kp*error + kd*(error - errorPrevious)/T - kd*(setpoint - setpointPrevious)/T + ks*setpoint
+    const PIDFDirectForm::coefficients_t pd = PIDFDirectForm::calculateCoefficients({ 2.0F, 0.0F, 0.1F, 0.5F, 0.0F }, DELTA_T, 0.0F, PIDFDirectForm::BACKWARD_EULER);
+    TEST_ASSERT_EQUAL_FLOAT(12.0F, pd.bError[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-22.0F, pd.bError[1]);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F, pd.bError[2]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0F, pd.a[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pd.a[1]);
+    TEST_ASSERT_EQUAL_FLOAT(-10.0F, pd.setpointDerivative);
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, pd.setpoint);
+
+    // I controller with Tustin integration: output[n] = output[n-1] + ki*T/2*(error[n] + error[n-1])
+    const PIDFDirectForm::coefficients_t i = PIDFDirectForm::calculateCoefficients({ 0.0F, 4.0F, 0.0F, 0.0F, 0.0F }, DELTA_T, 0.0F, PIDFDirectForm::TUSTIN);
+    TEST_ASSERT_EQUAL_FLOAT(0.02F, i.bError[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.02F, i.bError[1]);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, i.bError[2]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0F, i.a[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.04F, i.integralStep);
+
+    // derivative filter pole, the denominator has an exact integrator
+    const PIDFDirectForm::coefficients_t d = PIDFDirectForm::calculateCoefficients({ 0.0F, 0.0F, 1.0F, 0.0F, 0.0F }, DELTA_T, 0.03F, PIDFDirectForm::BACKWARD_EULER);
+    TEST_ASSERT_EQUAL_FLOAT(0.75F, d.derivativePole);
+    TEST_ASSERT_EQUAL_FLOAT(-1.75F, d.a[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.75F, d.a[1]);
+    TEST_ASSERT_EQUAL_FLOAT(25.0F, d.bError[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-50.0F, d.bError[1]);
+    TEST_ASSERT_EQUAL_FLOAT(25.0F, d.bError[2]);
+    const PIDFDirectForm::coefficients_t t = PIDFDirectForm::calculateCoefficients({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F }, DELTA_T, 0.0173F, PIDFDirectForm::TUSTIN);
+    TEST_ASSERT_TRUE(1.0F + t.a[0] + t.a[1] == 0.0F);
+}
+
+void test_backward_euler_matches_PIDF()
+{
+    const PIDF::PIDF_t gains { 1.5F, 4.0F, 0.02F, 0.3F, 0.01F };
+    PIDF pid(gains);
+    pid.setSampleTime(DELTA_T);
+    PIDFDirectForm directForm(gains, DELTA_T);
+    float setpoint = 0.0F;
+    float measurement = 0.0F;
+    for (int ii = 0; ii < 1000; ++ii) {
+        if (ii % 100 == 0) {
+            setpoint = randomFloat(1.0F);
+        }
+        // the PIDF K-term is calculated by setSetpoint(setpoint, deltaT), so it must be called every update
+        pid.setSetpoint(setpoint, DELTA_T);
+        directForm.setSetpoint(setpoint);
+        measurement += (setpoint - measurement)*0.05F + randomFloat(0.01F);
+        const float output = pid.update(measurement);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, output, directForm.update(measurement));
+
+        const PIDF::error_t error = pid.getError();
+        const PIDF::error_t reconstructed = directForm.getError();
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, error.P, reconstructed.P);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, error.I, reconstructed.I);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, error.D + error.K, reconstructed.D);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, error.S, reconstructed.S);
+    }
+}
+
+void test_derivative_filter()
+{
+    // equivalent to PIDF with the measurement delta and setpoint derivative filtered by a first order low-pass filter
+    const PIDF::PIDF_t gains { 1.0F, 2.0F, 0.05F, 0.0F, 0.02F };
+    const float tf = 0.02F;
+    const float pole = tf / (tf + DELTA_T);
+    PIDF pid(gains);
+    pid.setSampleTime(DELTA_T);
+    PIDFDirectForm directForm(gains, DELTA_T, tf);
+    float setpoint = 0.0F;
+    float setpointPrevious = 0.0F;
+    float measurement = 0.0F;
+    float measurementPrevious = 0.0F;
+    float measurementDeltaFiltered = 0.0F;
+    float setpointDeltaFiltered = 0.0F;
+    for (int ii = 0; ii < 1000; ++ii) {
+        if (ii % 100 == 0) {
+            setpoint = randomFloat(1.0F);
+        }
+        measurement += (setpoint - measurement)*0.05F + randomFloat(0.01F);
+        measurementDeltaFiltered = pole*measurementDeltaFiltered + (1.0F - pole)*(measurement - measurementPrevious);
+        setpointDeltaFiltered = pole*setpointDeltaFiltered + (1.0F - pole)*(setpoint - setpointPrevious);
+        measurementPrevious = measurement;
+        setpointPrevious = setpoint;
+        pid.setSetpoint(setpoint);
+        pid.setSetpointDerivative(setpointDeltaFiltered / DELTA_T);
+        directForm.setSetpoint(setpoint);
+        const float output = pid.updateDelta(measurement, measurementDeltaFiltered);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, output, directForm.update(measurement));
+        TEST_ASSERT_FLOAT_WITHIN(2.0e-4F, pid.getErrorI(), directForm.getError().I);
+        TEST_ASSERT_FLOAT_WITHIN(2.0e-4F, pid.getErrorD() + pid.getErrorK(), directForm.getError().D);
+    }
+}
+
+void test_tustin()
+{
+    // reference: trapezoidal integral, and Tustin discretization of the derivative filter
+    const PIDF::PIDF_t gains { 0.8F, 3.0F, 0.04F, 0.1F, 0.0F };
+    const float tf = 0.05F;
+    PIDFDirectForm directForm(gains, DELTA_T, tf, PIDFDirectForm::TUSTIN);
+    const float pole = (2.0F*tf - DELTA_T) / (2.0F*tf + DELTA_T);
+    const float g = 2.0F / (2.0F*tf + DELTA_T);
+    float integral = 0.0F;
+    float errorPrevious = 0.0F;
+    float derivative = 0.0F;
+    float measurement = 0.0F;
+    float measurementPrevious = 0.0F;
+    const float setpoint = 1.0F;
+    directForm.setSetpoint(setpoint);
+    for (int ii = 0; ii < 500; ++ii) {
+        measurement += (setpoint - measurement)*0.02F + randomFloat(0.01F);
+        const float error = setpoint - measurement;
+        integral += gains.ki*0.5F*DELTA_T*(error + errorPrevious);
+        derivative = pole*derivative - g*gains.kd*(measurement - measurementPrevious);
+        errorPrevious = error;
+        measurementPrevious = measurement;
+        const float output = gains.kp*error + integral + derivative + gains.ks*setpoint;
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, output, directForm.update(measurement));
+        TEST_ASSERT_FLOAT_WITHIN(2.0e-4F, integral, directForm.getError().I);
+        TEST_ASSERT_FLOAT_WITHIN(2.0e-4F, derivative, directForm.getError().D);
+    }
+}
+
+void test_no_steady_state_drift()
+{
+    // with a constant setpoint and measurement equal to the setpoint, the output is constant
+    PIDFDirectForm directForm({ 0.8F, 3.0F, 0.04F, 0.1F, 0.02F }, DELTA_T, 0.05F, PIDFDirectForm::TUSTIN);
+    directForm.setSetpoint(0.7F);
+    // let the derivative kick from the setpoint step decay
+    for (int ii = 0; ii < 1000; ++ii) {
+        directForm.update(0.7F);
+    }
+    // the rounding during the kick is integrated, so the output settles close to, but not exactly at, ks*setpoint.
+    // The offset depends on whether the compiler has fused multiply-adds: about 4e-7 without and 1.5e-6 with (-march=native)
+    const float output = directForm.getOutput();
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 0.07F, output);
+    for (int ii = 0; ii < 100000; ++ii) {
+        directForm.update(0.7F);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, output, directForm.getOutput());
+}
+
+void test_setPID_bumpless()
+{
+    const PIDF::PIDF_t gains { 1.5F, 4.0F, 0.02F, 0.3F, 0.0F };
+    PIDF pid(gains);
+    pid.setSampleTime(DELTA_T);
+    PIDFDirectForm directForm(gains, DELTA_T);
+    float measurement = 0.0F;
+    pid.setSetpoint(1.0F);
+    directForm.setSetpoint(1.0F);
+    for (int ii = 0; ii < 200; ++ii) {
+        measurement += (1.0F - measurement)*0.02F;
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, pid.update(measurement), directForm.update(measurement));
+    }
+    // setting the same gains does not change the output
+    const float output = directForm.getOutput();
+    directForm.setPID(gains);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, output, directForm.getOutput());
+
+    // PIDF keeps the integral when the gains change, and so does PIDFDirectForm
+    const PIDF::PIDF_t newGains { 0.5F, 8.0F, 0.01F, 0.3F, 0.0F };
+    pid.setPID(newGains);
+    directForm.setPID(newGains);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, pid.getErrorI(), directForm.getError().I);
+    for (int ii = 0; ii < 200; ++ii) {
+        measurement += (1.0F - measurement)*0.02F;
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, pid.update(measurement), directForm.update(measurement));
+    }
+
+    directForm.reset();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, directForm.getOutput());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, directForm.getError().I);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_coefficients);
+    RUN_TEST(test_backward_euler_matches_PIDF);
+    RUN_TEST(test_derivative_filter);
+    RUN_TEST(test_tustin);
+    RUN_TEST(test_no_steady_state_drift);
+    RUN_TEST(test_setPID_bumpless);
+
+    UNITY_END();
+}
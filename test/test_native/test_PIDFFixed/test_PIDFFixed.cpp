@@ -0,0 +1,181 @@
+#include <PIDF.h>
+#include <PIDFFixed.h>
+#include <cmath>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 0.001F;
+
+static uint32_t seed = 12345;
+static float randomFloat(float range)
+{
+    seed = seed*1664525U + 1013904223U;
+    return range*(static_cast<float>(seed >> 8U)/8388608.0F - 1.0F);
+}
+
+void test_conversions()
+{
+    TEST_ASSERT_EQUAL(16384, PIDFQ15::fromFloat(0.5F));
+    TEST_ASSERT_EQUAL(-16384, PIDFQ15::fromFloat(-0.5F));
+    TEST_ASSERT_EQUAL(32767, PIDFQ15::fromFloat(1.0F)); // saturates
+    TEST_ASSERT_EQUAL(-32768, PIDFQ15::fromFloat(-3.0F));
+    TEST_ASSERT_EQUAL_FLOAT(0.25F, PIDFQ15::toFloat(PIDFQ15::fromFloat(0.25F)));
+    TEST_ASSERT_EQUAL(INT32_MAX, PIDFQ31::fromFloat(1.0F));
+    TEST_ASSERT_EQUAL(1073741824, PIDFQ31::fromFloat(0.5F));
+
+    // gains are converted to the gain format, and back
+    PIDFQ15 pid({ 1.5F, 10.0F, 0.002F, 0.1F, 0.0F });
+    pid.setSampleTime(DELTA_T);
+    const PIDFQ15::PIDF_t gains = pid.getPIDFixed();
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, gains.kp);
+    TEST_ASSERT_FLOAT_WITHIN(10.0F/32768.0F/DELTA_T, 10.0F, gains.ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.002F, gains.kd); // kd/deltaT = 2 is exact
+    TEST_ASSERT_FLOAT_WITHIN(1.0F/512.0F, 0.1F, gains.ks);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F, pid.getPID().ki);
+}
+
+void test_PI()
+{
+    PIDFQ15 pid({ 0.5F, 100.0F, 0.0F, 0.0F, 0.0F });
+    pid.setSampleTime(0.01F); // ki*deltaT = 1 saturates to 32767/32768
+    pid.setSetpoint(PIDFQ15::fromFloat(0.25F));
+    const int16_t output = pid.update(0);
+    // 0.5*0.25 + 0.25*32767/32768
+    TEST_ASSERT_EQUAL(4096 + 8192, output);
+    TEST_ASSERT_EQUAL(4096, pid.getError().P);
+    TEST_ASSERT_EQUAL(8192, pid.getError().I);
+    TEST_ASSERT_EQUAL(8192, pid.getPreviousError());
+    pid.resetAll();
+    TEST_ASSERT_EQUAL(0, pid.getErrorI());
+    TEST_ASSERT_EQUAL(0, pid.getSetpoint());
+}
+
+void test_saturating_arithmetic()
+{
+    // large gains and errors saturate, rather than wrap
+    PIDFQ15 pid({ 100.0F, 0.0F, 0.0F, 100.0F, 0.0F });
+    pid.setSampleTime(DELTA_T);
+    pid.setSetpoint(PIDFQ15::fromFloat(0.9F));
+    TEST_ASSERT_EQUAL(INT16_MAX, pid.update(PIDFQ15::fromFloat(-0.9F)));
+    pid.setSetpoint(PIDFQ15::fromFloat(-0.9F));
+    TEST_ASSERT_EQUAL(INT16_MIN, pid.update(PIDFQ15::fromFloat(0.9F)));
+    // the error itself saturates
+    TEST_ASSERT_EQUAL(INT16_MIN, pid.getPreviousError());
+
+    // the integral saturates
+    PIDFQ15 pidI({ 0.0F, 900.0F, 0.0F, 0.0F, 0.0F });
+    pidI.setSampleTime(DELTA_T);
+    pidI.setSetpoint(PIDFQ15::fromFloat(0.9F));
+    for (int ii = 0; ii < 10000; ++ii) {
+        pidI.update(PIDFQ15::fromFloat(-0.9F));
+    }
+    TEST_ASSERT_EQUAL(INT16_MAX, pidI.getErrorI());
+    TEST_ASSERT_EQUAL(INT16_MAX, pidI.update(PIDFQ15::fromFloat(-0.9F)));
+}
+
+template <typename T>
+static void configure(T& pid, const PIDF::PIDF_t& gains)
+{
+    pid.setPID(gains);
+    pid.setSampleTime(DELTA_T);
+    pid.setIntegralLimit(T::fromFloat(0.5F));
+    pid.setIntegralThreshold(T::fromFloat(0.002F));
+    pid.setOutputSaturationValue(T::fromFloat(0.9F));
+}
+
+static void configure(PIDF& pid, const PIDF::PIDF_t& gains)
+{
+    pid.setPID(gains);
+    pid.setSampleTime(DELTA_T);
+    pid.setIntegralLimit(0.5F);
+    pid.setIntegralThreshold(0.002F);
+    pid.setOutputSaturationValue(0.9F);
+}
+
+/*!
+Run the fixed-point controller and PIDF side by side for a long time, with setpoint steps and ramps, measurement noise,
+and all the anti-windup features active (the signals are kept within the Q15/Q31 range, since out of range values saturate
+rather than being carried through as in PIDF), and return the maximum deviation of the output (open loop) or of the plant output
+(closed loop, with each controller driving its own first order plant).
+PIDF uses the fixed-point gains converted back to floating point, so the deviation is due to the fixed-point arithmetic.
+*/
+template <typename T>
+static float maxDeviation(bool closedLoop, size_t steps)
+{
+    seed = 12345;
+    T pidFixed;
+    configure(pidFixed, { 0.8F, 10.0F, 0.002F, 0.1F, 0.05F });
+    PIDF pid;
+    configure(pid, pidFixed.getPIDFixed());
+    pid.setIntegralLimit(T::toFloat(pidFixed.getIntegralMax()));
+    pid.setIntegralThreshold(T::toFloat(pidFixed.getIntegralThreshold()));
+    pid.setOutputSaturationValue(T::toFloat(pidFixed.getOutputSaturationValue()));
+
+    const float tau = 0.05F;
+    float plant = 0.0F;
+    float plantFixed = 0.0F;
+    float setpoint = 0.0F;
+    float rate = 0.0F;
+    float deviation = 0.0F;
+    for (size_t ii = 0; ii < steps; ++ii) {
+        if (ii % 2000 == 0) {
+            setpoint = randomFloat(0.3F);
+            rate = randomFloat(0.2F);
+        }
+        setpoint = std::fmin(std::fmax(setpoint + rate*DELTA_T, -0.4F), 0.4F);
+        const auto setpointFixed = T::fromFloat(setpoint);
+        const auto rateFixed = T::fromFloat(rate);
+        pid.setSetpoint(T::toFloat(setpointFixed));
+        pid.setSetpointDerivative(T::toFloat(rateFixed));
+        pidFixed.setSetpoint(setpointFixed);
+        pidFixed.setSetpointDerivative(rateFixed);
+
+        const float noise = randomFloat(0.002F);
+        const auto measurementFixed = T::fromFloat((closedLoop ? plantFixed : plant) + noise);
+        const float measurement = closedLoop ? T::toFloat(T::fromFloat(plant + noise)) : T::toFloat(measurementFixed);
+        const float output = pid.update(measurement);
+        const float outputFixed = T::toFloat(pidFixed.update(measurementFixed));
+        plant += (output - plant)*DELTA_T/tau;
+        plantFixed += (outputFixed - plantFixed)*DELTA_T/tau;
+        deviation = std::fmax(deviation, std::fabs(closedLoop ? plantFixed - plant : outputFixed - output));
+    }
+    return deviation;
+}
+
+void test_deviation_Q15()
+{
+    // within a few LSB (one LSB is 3.05e-5), the integral does not drift
+    const float openLoop = maxDeviation<PIDFQ15>(false, 200000);
+    TEST_ASSERT_TRUE(openLoop < 1.5e-4F);
+    const float closedLoop = maxDeviation<PIDFQ15>(true, 200000);
+    TEST_ASSERT_TRUE(closedLoop < 1.5e-4F);
+}
+
+void test_deviation_Q31()
+{
+    // the deviation is dominated by the rounding of the floating point reference
+    const float openLoop = maxDeviation<PIDFQ31>(false, 200000);
+    TEST_ASSERT_TRUE(openLoop < 1.0e-5F);
+    const float closedLoop = maxDeviation<PIDFQ31>(true, 200000);
+    TEST_ASSERT_TRUE(closedLoop < 1.0e-5F);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_conversions);
+    RUN_TEST(test_PI);
+    RUN_TEST(test_saturating_arithmetic);
+    RUN_TEST(test_deviation_Q15);
+    RUN_TEST(test_deviation_Q31);
+
+    UNITY_END();
+}
@@ -0,0 +1,186 @@
+#include <PIDFFrequencyResponse.h>
+#include <PIDFOptimizer.h>
+#include <PIDFSimulation.h>
+#include <cfloat>
+#include <cmath>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr double PI = PIDFFrequencyResponse::PI;
+static constexpr double RADIANS_TO_DEGREES = 180.0/PI;
+
+void test_transfer_function()
+{
+    // at omega = 1/timeConstant, the FOPDT gain is down by sqrt(2), and the phase is -45 degrees less the delay
+    const std::complex<double> fopdt = PIDFTransferFunction::fopdt(2.0F, 0.1F, 0.01F)(10.0);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 2.0F/std::sqrt(2.0F), static_cast<float>(std::abs(fopdt)));
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, static_cast<float>(-45.0 - 0.1*RADIANS_TO_DEGREES), static_cast<float>(std::arg(fopdt)*RADIANS_TO_DEGREES));
+
+    const std::complex<double> integrating = PIDFTransferFunction::integrating(3.0F)(6.0);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, 0.0F, static_cast<float>(integrating.real()));
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, -0.5F, static_cast<float>(integrating.imag()));
+
+    // at the natural frequency, the second order gain is gain/(2*zeta), and the phase is -90 degrees
+    const std::complex<double> secondOrder = PIDFTransferFunction::secondOrder(1.5F, 20.0F, 0.25F)(20.0);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 3.0F, static_cast<float>(std::abs(secondOrder)));
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, -90.0F, static_cast<float>(std::arg(secondOrder)*RADIANS_TO_DEGREES));
+}
+
+void test_frequency_grid()
+{
+    const PIDFFrequencyResponse response(0.001F, 1.0F, 1.0e6F, 101);
+    TEST_ASSERT_EQUAL(101, response.getPointCount());
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, response.getFrequency(0));
+    // the maximum is limited to the Nyquist frequency
+    TEST_ASSERT_EQUAL_FLOAT(static_cast<float>(PI*1000.0), response.getFrequency(100));
+    const float ratio = response.getFrequency(1)/response.getFrequency(0);
+    for (size_t ii = 1; ii < response.getPointCount(); ++ii) {
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, ratio, response.getFrequency(ii)/response.getFrequency(ii - 1));
+    }
+
+    const PIDFFrequencyResponse lower(0.001F, 0.1F, 1000.0F, 5);
+    TEST_ASSERT_EQUAL_FLOAT(0.1F, lower.getFrequency(0));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, lower.getFrequency(1));
+    TEST_ASSERT_EQUAL_FLOAT(1000.0F, lower.getFrequency(4));
+}
+
+void test_margins_discrete()
+{
+    // P control of the discrete plant b*z^-1/(1 - a*z^-1), the phase crosses -180 degrees at the Nyquist frequency, where z^-1 = -1
+    static constexpr double a = 0.9;
+    static constexpr double b = 0.2;
+    constexpr double kp = 2.0;
+    PIDFFrequencyResponse response(0.001F, 0.1F, 1.0e6F, 2000);
+    response.setDiscretePlant([](std::complex<double> zInverse) { return b*zInverse/(1.0 - a*zInverse); });
+    const PIDFFrequencyResponse::margins_t margins = response.analyze({ static_cast<float>(kp), 0.0F, 0.0F, 0.0F, 0.0F });
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, static_cast<float>((1.0 + a)/(kp*b)), margins.gainMargin);
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, static_cast<float>(PI*1000.0), margins.gainMarginFrequency);
+
+    // the loop gain is 1 where cos(theta) = (1 + a^2 - (kp*b)^2)/(2*a)
+    const double theta = std::acos((1.0 + a*a - kp*kp*b*b)/(2.0*a));
+    const std::complex<double> zInverse = std::polar(1.0, -theta);
+    const double phaseMargin = 180.0 + std::arg(kp*b*zInverse/(1.0 - a*zInverse))*RADIANS_TO_DEGREES;
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, static_cast<float>(phaseMargin), margins.phaseMargin);
+    TEST_ASSERT_FLOAT_WITHIN(0.2F, static_cast<float>(theta*1000.0), margins.gainCrossoverFrequency);
+    // the loop gain is closest to -1 at the Nyquist frequency
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, static_cast<float>(1.0/(1.0 - kp*b/(1.0 + a))), margins.sensitivityPeak);
+    TEST_ASSERT_EQUAL_FLOAT(static_cast<float>(PI*1000.0), margins.sensitivityPeakFrequency);
+
+    // with a low gain the loop gain never crosses 1
+    const PIDFFrequencyResponse::margins_t low = response.analyze({ 0.5F, 0.0F, 0.0F, 0.0F, 0.0F });
+    TEST_ASSERT_TRUE(std::isinf(low.phaseMargin));
+    TEST_ASSERT_TRUE(low.gainCrossoverFrequency < 0.0F);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, static_cast<float>((1.0 + a)/(0.5*b)), low.gainMargin);
+}
+
+void test_margins_continuous()
+{
+    // PI control of an FOPDT plant, with the integral time equal to the time constant, so the loop gain is 20*exp(-0.01*s)/s
+    PIDFFrequencyResponse response(0.001F, 0.1F, 1000.0F, 400);
+    response.setPlant(PIDFTransferFunction::fopdt(2.0F, 0.1F, 0.01F));
+    const PIDFFrequencyResponse::margins_t margins = response.analyze({ 1.0F, 10.0F, 0.0F, 0.0F, 0.0F });
+    TEST_ASSERT_FLOAT_WITHIN(0.2F, 20.0F, margins.gainCrossoverFrequency);
+    TEST_ASSERT_FLOAT_WITHIN(1.0F, static_cast<float>(90.0 - 0.2*RADIANS_TO_DEGREES), margins.phaseMargin);
+    // the phase is -180 degrees at about pi/(2*0.01), less the half-sample delay of the zero-order hold
+    TEST_ASSERT_FLOAT_WITHIN(0.5F, static_cast<float>(PI/2.0/0.0105), margins.gainMarginFrequency);
+    TEST_ASSERT_FLOAT_WITHIN(0.1F, margins.gainMarginFrequency/20.0F, margins.gainMargin);
+    TEST_ASSERT_TRUE(margins.bandwidth > margins.gainCrossoverFrequency);
+
+    // the sensitivity peak is the maximum of |1/(1 + L)| over the grid, and bounds the margins
+    float peak = 0.0F;
+    for (size_t ii = 0; ii < response.getPointCount(); ++ii) {
+        peak = std::fmax(peak, 1.0F/std::abs(1.0F + response.getLoopGain({ 1.0F, 10.0F, 0.0F, 0.0F, 0.0F }, ii)));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, peak, margins.sensitivityPeak);
+    TEST_ASSERT_TRUE(margins.sensitivityPeak >= margins.gainMargin/(margins.gainMargin - 1.0F));
+    TEST_ASSERT_TRUE(margins.sensitivityPeak >= 1.0F/(2.0F*std::sin(0.5F*margins.phaseMargin/static_cast<float>(RADIANS_TO_DEGREES))));
+}
+
+void test_setpoint_terms()
+{
+    // ks and kk change the setpoint response, so the bandwidth, but not the feedback loop, so not the margins
+    PIDFFrequencyResponse response(0.001F, 0.1F, 1000.0F, 301);
+    response.setPlant(PIDFTransferFunction::secondOrder(1.0F, 30.0F, 0.5F));
+    const PIDFFrequencyResponse::margins_t margins = response.analyze({ 1.0F, 20.0F, 0.02F, 0.0F, 0.0F });
+    const PIDFFrequencyResponse::margins_t feedforward = response.analyze({ 1.0F, 20.0F, 0.02F, 0.5F, 0.03F });
+    TEST_ASSERT_EQUAL_FLOAT(margins.gainMargin, feedforward.gainMargin);
+    TEST_ASSERT_EQUAL_FLOAT(margins.phaseMargin, feedforward.phaseMargin);
+    TEST_ASSERT_EQUAL_FLOAT(margins.sensitivityPeak, feedforward.sensitivityPeak);
+    TEST_ASSERT_TRUE(feedforward.bandwidth > 1.2F*margins.bandwidth);
+}
+
+void test_margins_match_simulation()
+{
+    // PI control of the PIDFSimulation FOPDT plant, using its exact discrete response,
+    // the loop is stable just below the gain margin and unstable just above it
+    constexpr float deltaT = 0.001F;
+    constexpr size_t DELAY = 10;
+    static constexpr double alpha = 0.02; // deltaT/timeConstant
+    PIDFFrequencyResponse response(deltaT, 0.1F, 1.0e6F, 500);
+    response.setDiscretePlant([](std::complex<double> zInverse) {
+        return 2.0*alpha*std::pow(zInverse, DELAY + 1)/(1.0 - (1.0 - alpha)*zInverse);
+    });
+    const PIDF::PIDF_t gains { 1.0F, 20.0F, 0.0F, 0.0F, 0.0F };
+    const PIDFFrequencyResponse::margins_t margins = response.analyze(gains);
+    TEST_ASSERT_TRUE(margins.gainMargin > 1.5F && margins.gainMargin < 20.0F);
+
+    auto finalError = [&gains](float scale) {
+        PIDFPlantFOPDT<DELAY> plant(2.0F, deltaT/static_cast<float>(alpha), deltaT);
+        PIDF pid({ scale*gains.kp, scale*gains.ki, 0.0F, 0.0F, 0.0F });
+        pid.setSampleTime(deltaT);
+        pid.setSetpoint(1.0F);
+        float measurement = 0.0F;
+        float maxError = 0.0F;
+        for (int ii = 0; ii < 20000; ++ii) {
+            measurement = plant.update(pid.update(measurement));
+            if (ii >= 18000) {
+                maxError = std::fmax(maxError, std::fabs(1.0F - measurement));
+            }
+        }
+        return maxError;
+    };
+    TEST_ASSERT_TRUE(finalError(0.95F*margins.gainMargin) < 0.1F);
+    TEST_ASSERT_TRUE(finalError(1.05F*margins.gainMargin) > 10.0F);
+}
+void test_optimizer_constraint()
+{
+    // maximize the crossover frequency, subject to a sensitivity peak of at most 1.4, analyzed concurrently by the optimizer's workers
+    PIDFFrequencyResponse response(0.001F, 0.1F, 1.0e6F, 200);
+    response.setPlant(PIDFTransferFunction::fopdt(2.0F, 0.1F, 0.01F));
+    auto cost = [&response](const PIDFOptimizer::candidate_t& candidate) {
+        const PIDFFrequencyResponse::margins_t margins = response.analyze(candidate.pid);
+        return (margins.sensitivityPeak > 1.4F || margins.gainCrossoverFrequency < 0.0F) ? FLT_MAX : -margins.gainCrossoverFrequency;
+    };
+    PIDFOptimizer optimizer(2);
+    const PIDFOptimizer::candidate_t minimum { { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const PIDFOptimizer::candidate_t maximum { { 20.0F, 200.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const std::vector<PIDFOptimizer::result_t> results = optimizer.random(minimum, maximum, 2000, 1, cost);
+    const PIDFFrequencyResponse::margins_t best = response.analyze(results[0].candidate.pid);
+    TEST_ASSERT_TRUE(best.sensitivityPeak <= 1.4F);
+    TEST_ASSERT_EQUAL_FLOAT(-best.gainCrossoverFrequency, results[0].cost);
+    // a high gain gives a higher crossover frequency, but too small a margin
+    TEST_ASSERT_TRUE(response.analyze({ 20.0F, 200.0F, 0.0F, 0.0F, 0.0F }).sensitivityPeak > 1.4F);
+    TEST_ASSERT_TRUE(best.phaseMargin > 30.0F);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_transfer_function);
+    RUN_TEST(test_frequency_grid);
+    RUN_TEST(test_margins_discrete);
+    RUN_TEST(test_margins_continuous);
+    RUN_TEST(test_setpoint_terms);
+    RUN_TEST(test_margins_match_simulation);
+    RUN_TEST(test_optimizer_constraint);
+
+    UNITY_END();
+}
@@ -0,0 +1,169 @@
+#include <PIDF.h>
+#include <PIDFGainScheduler.h>
+#include <array>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static const std::array<PIDF::PIDF_t, 3> gainTable {{
+    { 1.0F, 10.0F, 0.1F, 0.0F, 0.0F },
+    { 2.0F, 20.0F, 0.2F, 0.5F, 0.0F },
+    { 4.0F, 20.0F, 0.4F, 1.0F, 0.1F },
+}};
+
+void test_lookup()
+{
+    const PIDFGainScheduler<3> scheduler(0.0F, 1.0F, gainTable);
+    TEST_ASSERT_EQUAL(3, scheduler.size());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, scheduler.getInputMin());
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, scheduler.getInputMax());
+
+    PIDF::PIDF_t pid = scheduler.lookup(0.0F);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F, pid.ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.1F, pid.kd);
+
+    pid = scheduler.lookup(0.25F);
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(15.0F, pid.ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.15F, pid.kd);
+    TEST_ASSERT_EQUAL_FLOAT(0.25F, pid.ks);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.kk);
+
+    pid = scheduler.lookup(0.5F);
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, pid.ks);
+
+    pid = scheduler.lookup(0.75F);
+    TEST_ASSERT_EQUAL_FLOAT(3.0F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(20.0F, pid.ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.05F, pid.kk);
+
+    pid = scheduler.lookup(1.0F);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(0.1F, pid.kk);
+}
+
+void test_lookup_out_of_range()
+{
+    PIDFGainScheduler<3> scheduler(10.0F, 20.0F, gainTable);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, scheduler.lookup(-100.0F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, scheduler.lookup(10.0F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, scheduler.lookup(15.0F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, scheduler.lookup(20.0F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, scheduler.lookup(1000.0F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, scheduler.lookup(NAN).kp);
+
+    // descending input range
+    scheduler.setInputRange(20.0F, 10.0F);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, scheduler.lookup(10.0F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, scheduler.lookup(20.0F).kp);
+
+    // changing an entry updates the interpolation on both sides of it
+    scheduler.setEntry(1, { 3.0F, 20.0F, 0.2F, 0.5F, 0.0F });
+    TEST_ASSERT_EQUAL_FLOAT(3.0F, scheduler.lookup(15.0F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, scheduler.lookup(17.5F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(3.5F, scheduler.lookup(12.5F).kp);
+    TEST_ASSERT_EQUAL_FLOAT(3.0F, scheduler.getEntry(1).kp);
+}
+
+void test_apply()
+{
+    const PIDFGainScheduler<3> scheduler(0.0F, 1.0F, gainTable);
+    PIDF pid({ 1.0F, 10.0F, 0.0F, 0.0F, 0.0F });
+    PIDFT<PIDFTerms::PI> pidPI;
+    pid.setSetpoint(1.0F);
+    pid.update(0.0F, 0.1F);
+    const float errorI = pid.getErrorI();
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, errorI);
+
+    const PIDF::PIDF_t applied = scheduler.apply(0.25F, pid, pidPI);
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, applied.kp);
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, pid.getP());
+    TEST_ASSERT_EQUAL_FLOAT(15.0F, pid.getI());
+    TEST_ASSERT_EQUAL_FLOAT(0.15F, pid.getD());
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, pidPI.getP());
+    TEST_ASSERT_EQUAL_FLOAT(15.0F, pidPI.getI());
+    TEST_ASSERT_EQUAL_FLOAT(errorI, pid.getErrorI()); // integral unchanged
+
+    // with integration switched off, the scheduled ki is saved and used when integration is switched back on
+    pid.switchIntegrationOff();
+    TEST_ASSERT_FALSE(pid.isIntegrationOn());
+    scheduler.apply(0.0F, pid);
+    TEST_ASSERT_FALSE(pid.isIntegrationOn());
+    TEST_ASSERT_EQUAL_FLOAT(10.0F, pid.getI());
+    pid.update(0.0F, 0.1F);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.getErrorI());
+    pid.switchIntegrationOff(); // switching off twice does not lose the saved ki
+    pid.switchIntegrationOn();
+    TEST_ASSERT_TRUE(pid.isIntegrationOn());
+    pid.update(0.0F, 0.1F);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, pid.getErrorI());
+
+    // a zero ki does not switch integration back on
+    PIDF pidZero({ 1.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    TEST_ASSERT_TRUE(pidZero.isIntegrationOn());
+    pidZero.switchIntegrationOff();
+    TEST_ASSERT_FALSE(pidZero.isIntegrationOn());
+    scheduler.apply(0.5F, pidZero);
+    TEST_ASSERT_FALSE(pidZero.isIntegrationOn());
+    TEST_ASSERT_EQUAL_FLOAT(20.0F, pidZero.getI());
+
+    std::array<PIDF, 4> pids {};
+    scheduler.applyToArray(1.0F, &pids[0], pids.size());
+    for (const auto& p : pids) {
+        TEST_ASSERT_EQUAL_FLOAT(4.0F, p.getP());
+        TEST_ASSERT_EQUAL_FLOAT(0.1F, p.getK());
+    }
+}
+
+void test_apply_fixed_rate()
+{
+    const PIDFGainScheduler<3> scheduler(0.0F, 1.0F, gainTable);
+    PIDF pid;
+    PIDF pidVariable;
+    pid.setSampleTime(0.125F);
+    scheduler.apply(0.5F, pid, pidVariable);
+    pid.setSetpoint(1.0F);
+    pidVariable.setSetpoint(1.0F);
+    TEST_ASSERT_EQUAL_FLOAT(pidVariable.update(0.25F, 0.125F), pid.update(0.25F));
+    TEST_ASSERT_EQUAL_FLOAT(pidVariable.getErrorI(), pid.getErrorI());
+}
+
+void test_apply_double()
+{
+    const PIDFGainScheduler<3, double> scheduler(0.0, 1.0, {{
+        { 1.0, 10.0, 0.1, 0.0, 0.0 },
+        { 2.0, 20.0, 0.2, 0.5, 0.0 },
+        { 4.0, 20.0, 0.4, 1.0, 0.1 },
+    }});
+    PIDFDouble pid;
+    PIDFT<PIDFTerms::PI, double> pidPI;
+    const PIDFDouble::PIDF_t applied = scheduler.apply(0.25, pid, pidPI);
+    TEST_ASSERT_TRUE(applied.kp == 1.5);
+    TEST_ASSERT_TRUE(applied.ks == 0.25);
+    TEST_ASSERT_TRUE(pid.getP() == 1.5);
+    TEST_ASSERT_TRUE(pid.getI() == 15.0);
+    TEST_ASSERT_TRUE(pid.getS() == 0.25);
+    TEST_ASSERT_TRUE(pidPI.getP() == 1.5);
+    TEST_ASSERT_TRUE(pidPI.getI() == 15.0);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_lookup);
+    RUN_TEST(test_lookup_out_of_range);
+    RUN_TEST(test_apply);
+    RUN_TEST(test_apply_fixed_rate);
+    RUN_TEST(test_apply_double);
+
+    UNITY_END();
+}
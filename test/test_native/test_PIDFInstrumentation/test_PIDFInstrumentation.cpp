@@ -0,0 +1,157 @@
+#include <PIDF.h>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+using PIDFInstrumented = PIDFT<PIDFTerms::ALL | PIDFTerms::INSTRUMENTATION>;
+using PIDFIncrementalInstrumented = PIDFT<PIDFTerms::PID | PIDFTerms::INCREMENTAL | PIDFTerms::INSTRUMENTATION>;
+
+void test_instrumentation_zero_cost_when_disabled()
+{
+    static_assert(PIDFInstrumented::HAS_INSTRUMENTATION);
+#if !defined(USE_PIDF_INSTRUMENTATION)
+    // without the flag there is no instrumentation storage, and with it there is only a pointer
+    static_assert(!PIDF::HAS_INSTRUMENTATION);
+    static_assert(sizeof(PIDFInstrumented) == sizeof(PIDF) + sizeof(PIDFInstrumentation*));
+    const PIDF pid({ 1.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    TEST_ASSERT_NULL(pid.getInstrumentation());
+#endif
+}
+
+void test_instrumentation_record()
+{
+    // period of 1000 counts, histogram from 900 to 1100 in bins of 12.5 counts, budget of 100 counts
+    PIDFInstrumentation instrumentation(1000, 100, 100);
+    TEST_ASSERT_EQUAL(0, instrumentation.getUpdateCount());
+    TEST_ASSERT_EQUAL(0, instrumentation.getUpdateCountsMin());
+    TEST_ASSERT_EQUAL(0, instrumentation.getIntervalMin());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, instrumentation.getUpdateCountsMean());
+    TEST_ASSERT_EQUAL(900, instrumentation.getBinStart(0));
+    TEST_ASSERT_EQUAL(913, instrumentation.getBinStart(1));
+    TEST_ASSERT_EQUAL(1000, instrumentation.getBinStart(8));
+
+    instrumentation.record(0, 50);
+    TEST_ASSERT_EQUAL(1, instrumentation.getUpdateCount());
+    TEST_ASSERT_EQUAL(50, instrumentation.getUpdateCountsMin());
+    TEST_ASSERT_EQUAL(50, instrumentation.getUpdateCountsMax());
+    TEST_ASSERT_EQUAL(0, instrumentation.getIntervalMax()); // no interval after the first update
+    instrumentation.record(1000, 1060);  // interval 1000, bin 8
+    instrumentation.record(2010, 2140);  // interval 1010, bin 8, overrun
+    instrumentation.record(2910, 2950);  // interval 900, bin 0
+    instrumentation.record(3809, 3849);  // interval 899, underflow, bin 0
+    instrumentation.record(5809, 5849);  // interval 2000, overflow, bin 15
+    instrumentation.record(6908, 6958);  // interval 1099, bin 15
+    instrumentation.record(7920, 8020);  // interval 1012, bin 8, not an overrun
+    TEST_ASSERT_EQUAL(8, instrumentation.getUpdateCount());
+    TEST_ASSERT_EQUAL(1, instrumentation.getOverrunCount());
+    TEST_ASSERT_EQUAL(40, instrumentation.getUpdateCountsMin());
+    TEST_ASSERT_EQUAL(130, instrumentation.getUpdateCountsMax());
+    TEST_ASSERT_EQUAL(510, instrumentation.getUpdateCountsTotal());
+    TEST_ASSERT_EQUAL_FLOAT(63.75F, instrumentation.getUpdateCountsMean());
+    TEST_ASSERT_EQUAL_FLOAT(0.06375F, instrumentation.getLoad());
+    TEST_ASSERT_EQUAL(899, instrumentation.getIntervalMin());
+    TEST_ASSERT_EQUAL(2000, instrumentation.getIntervalMax());
+    const PIDFInstrumentation::histogram_t& histogram = instrumentation.getHistogram();
+    TEST_ASSERT_EQUAL(2, histogram[0]);
+    TEST_ASSERT_EQUAL(3, histogram[8]);
+    TEST_ASSERT_EQUAL(2, histogram[15]);
+    uint32_t total = 0;
+    for (uint32_t count : histogram) {
+        total += count;
+    }
+    TEST_ASSERT_EQUAL(7, total);
+
+    instrumentation.reset();
+    TEST_ASSERT_EQUAL(0, instrumentation.getUpdateCount());
+    TEST_ASSERT_EQUAL(0, instrumentation.getHistogram()[8]);
+}
+
+void test_instrumentation_counter_wrap()
+{
+    PIDFInstrumentation instrumentation(1000, 100, 100);
+    instrumentation.record(UINT32_MAX - 499, UINT32_MAX - 449);
+    instrumentation.record(500, 540); // counter has wrapped, interval 1000
+    TEST_ASSERT_EQUAL(40, instrumentation.getUpdateCountsMin());
+    TEST_ASSERT_EQUAL(1000, instrumentation.getIntervalMin());
+    TEST_ASSERT_EQUAL(1, instrumentation.getHistogram()[8]);
+    instrumentation.record(1450, 1500); // update end has wrapped relative to start
+    TEST_ASSERT_EQUAL(50, instrumentation.getUpdateCountsMax());
+}
+
+void test_instrumentation_small_jitter_range()
+{
+    // with a jitter range of 1 a long interval would overflow the bin multiplication, so must still be put in the last bin
+    PIDFInstrumentation instrumentation(10, 1, 100);
+    instrumentation.record(0, 1);
+    instrumentation.record(9 + (1U << 29U), 10 + (1U << 29U));
+    TEST_ASSERT_EQUAL(1, instrumentation.getHistogram()[PIDFInstrumentation::BIN_COUNT - 1]);
+    TEST_ASSERT_EQUAL(0, instrumentation.getHistogram()[0]);
+    instrumentation.record(0xF0000000U, 0xF0000001U);
+    TEST_ASSERT_EQUAL(2, instrumentation.getHistogram()[PIDFInstrumentation::BIN_COUNT - 1]);
+}
+
+void test_instrumentation_update()
+{
+    PIDFInstrumentation instrumentation(1000, 500, 1000000);
+    PIDFInstrumented pid({ 1.0F, 2.0F, 0.1F, 0.0F, 0.0F });
+    PIDFInstrumented reference({ 1.0F, 2.0F, 0.1F, 0.0F, 0.0F });
+    TEST_ASSERT_NULL(pid.getInstrumentation());
+    pid.update(0.5F, 0.001F); // not recorded
+    reference.update(0.5F, 0.001F);
+    pid.setInstrumentation(&instrumentation);
+    TEST_ASSERT_EQUAL_PTR(&instrumentation, pid.getInstrumentation());
+    pid.setSetpoint(1.0F);
+    reference.setSetpoint(1.0F);
+    for (int ii = 0; ii < 100; ++ii) {
+        const float measurement = 0.01F*static_cast<float>(ii);
+        // instrumentation does not change the output
+        TEST_ASSERT_EQUAL_FLOAT(reference.update(measurement, 0.001F), pid.update(measurement, 0.001F));
+    }
+    pid.setSampleTime(0.001F);
+    reference.setSampleTime(0.001F);
+    TEST_ASSERT_EQUAL_FLOAT(reference.updateDelta(0.5F, 0.01F), pid.updateDelta(0.5F, 0.01F));
+    TEST_ASSERT_EQUAL(101, instrumentation.getUpdateCount());
+    TEST_ASSERT_TRUE(instrumentation.getUpdateCountsMin() <= instrumentation.getUpdateCountsMax());
+    TEST_ASSERT_TRUE(instrumentation.getIntervalMin() <= instrumentation.getIntervalMax());
+    uint32_t total = 0;
+    for (uint32_t count : instrumentation.getHistogram()) {
+        total += count;
+    }
+    TEST_ASSERT_EQUAL(100, total);
+
+    pid.setInstrumentation(nullptr);
+    pid.update(0.5F, 0.001F);
+    TEST_ASSERT_EQUAL(101, instrumentation.getUpdateCount());
+}
+
+void test_instrumentation_incremental()
+{
+    PIDFInstrumentation instrumentation(1000, 500, 1000000);
+    PIDFIncrementalInstrumented pid({ 1.0F, 2.0F, 0.1F, 0.0F, 0.0F });
+    pid.setInstrumentation(&instrumentation);
+    pid.setSetpoint(1.0F);
+    for (int ii = 0; ii < 10; ++ii) {
+        pid.updateIncremental(0.1F*static_cast<float>(ii), 0.001F);
+    }
+    TEST_ASSERT_EQUAL(10, instrumentation.getUpdateCount());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_instrumentation_zero_cost_when_disabled);
+    RUN_TEST(test_instrumentation_record);
+    RUN_TEST(test_instrumentation_counter_wrap);
+    RUN_TEST(test_instrumentation_small_jitter_range);
+    RUN_TEST(test_instrumentation_update);
+    RUN_TEST(test_instrumentation_incremental);
+
+    UNITY_END();
+}
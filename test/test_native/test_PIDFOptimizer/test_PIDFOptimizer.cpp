@@ -0,0 +1,162 @@
+#include <PIDFOptimizer.h>
+#include <atomic>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 1.0F / 1000.0F;
+
+// quadratic bowl with its minimum at kp=2, ki=5, kd=0.25
+static float bowl(const PIDFOptimizer::candidate_t& c)
+{
+    return (c.pid.kp - 2.0F)*(c.pid.kp - 2.0F) + 0.1F*(c.pid.ki - 5.0F)*(c.pid.ki - 5.0F) + 10.0F*(c.pid.kd - 0.25F)*(c.pid.kd - 0.25F);
+}
+
+void test_pool()
+{
+    enum { COUNT = 10007 };
+    static std::array<std::atomic<uint32_t>, COUNT> calls {};
+    PIDFWorkStealingPool pool(4);
+    TEST_ASSERT_EQUAL(4, pool.getThreadCount());
+    std::atomic<uint32_t> worker3Calls {0};
+    // the work is uneven, the first indices are much slower, so the other workers must steal from worker 0
+    auto body = [&worker3Calls](size_t index, size_t worker) {
+        if (index < 100) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        calls[index].fetch_add(1);
+        if (worker == 3) {
+            worker3Calls.fetch_add(1);
+        }
+    };
+    for (int run = 0; run < 3; ++run) {
+        pool.parallelFor(COUNT, 4, body);
+    }
+    for (const auto& call : calls) {
+        TEST_ASSERT_EQUAL(3, call.load());
+    }
+    TEST_ASSERT_TRUE(worker3Calls.load() > 0);
+
+    size_t count = 0;
+    auto empty = [&count](size_t, size_t) { ++count; };
+    pool.parallelFor(0, 4, empty);
+    TEST_ASSERT_EQUAL(0, count);
+}
+
+void test_grid()
+{
+    PIDFOptimizer optimizer(3);
+    const PIDFOptimizer::candidate_t minimum { { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 1.0F };
+    const PIDFOptimizer::candidate_t maximum { { 4.0F, 10.0F, 1.0F, 0.0F, 0.0F }, 0.0F, 1.0F };
+    const std::vector<PIDFOptimizer::result_t> results = optimizer.grid(minimum, maximum, {{ 9, 11, 5, 1, 1, 1, 1 }}, bowl);
+    TEST_ASSERT_EQUAL(9*11*5, results.size());
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, results[0].candidate.pid.kp);
+    TEST_ASSERT_EQUAL_FLOAT(5.0F, results[0].candidate.pid.ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.25F, results[0].candidate.pid.kd);
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, results[0].candidate.outputSaturationValue); // fixed parameter
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, results[0].cost);
+    for (size_t ii = 1; ii < results.size(); ++ii) {
+        TEST_ASSERT_TRUE(results[ii - 1].cost <= results[ii].cost);
+    }
+}
+
+void test_random_is_independent_of_thread_count()
+{
+    const PIDFOptimizer::candidate_t minimum { { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const PIDFOptimizer::candidate_t maximum { { 4.0F, 10.0F, 1.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    PIDFOptimizer optimizer1(1);
+    PIDFOptimizer optimizer4(4);
+    const std::vector<PIDFOptimizer::result_t> results1 = optimizer1.random(minimum, maximum, 1000, 7, bowl);
+    const std::vector<PIDFOptimizer::result_t> results4 = optimizer4.random(minimum, maximum, 1000, 7, bowl);
+    for (size_t ii = 0; ii < results1.size(); ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(results1[ii].cost, results4[ii].cost);
+        TEST_ASSERT_EQUAL_FLOAT(results1[ii].candidate.pid.kp, results4[ii].candidate.pid.kp);
+    }
+    TEST_ASSERT_TRUE(results1[0].cost < 0.05F);
+    TEST_ASSERT_TRUE(results1[0].candidate.pid.kp >= 0.0F && results1[0].candidate.pid.kp <= 4.0F);
+    const std::vector<PIDFOptimizer::result_t> other = optimizer4.random(minimum, maximum, 1000, 8, bowl);
+    TEST_ASSERT_TRUE(other[0].candidate.pid.kp != results1[0].candidate.pid.kp);
+}
+
+void test_nelder_mead()
+{
+    PIDFOptimizer optimizer(2);
+    const PIDFOptimizer::candidate_t minimum { { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const PIDFOptimizer::candidate_t maximum { { 4.0F, 10.0F, 1.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const std::vector<PIDFOptimizer::candidate_t> starts {
+        { { 0.5F, 1.0F, 0.9F, 0.0F, 0.0F }, 0.0F, 0.0F },
+        { { 3.5F, 9.0F, 0.1F, 0.0F, 0.0F }, 0.0F, 0.0F },
+        { { 4.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F },
+    };
+    const std::vector<PIDFOptimizer::result_t> results = optimizer.nelderMead(minimum, maximum, starts, 400, bowl);
+    TEST_ASSERT_EQUAL(3, results.size());
+    for (const auto& result : results) {
+        TEST_ASSERT_FLOAT_WITHIN(0.01F, 2.0F, result.candidate.pid.kp);
+        TEST_ASSERT_FLOAT_WITHIN(0.05F, 5.0F, result.candidate.pid.ki);
+        TEST_ASSERT_FLOAT_WITHIN(0.01F, 0.25F, result.candidate.pid.kd);
+        TEST_ASSERT_TRUE(result.cost < 1.0e-4F);
+    }
+    // the minimum is outside the space, so the search stops at the bound
+    const PIDFOptimizer::candidate_t bounded { { 1.0F, 10.0F, 1.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const std::vector<PIDFOptimizer::result_t> edge = optimizer.nelderMead(minimum, bounded, starts, 400, bowl);
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 1.0F, edge[0].candidate.pid.kp);
+}
+
+void test_simulation_cost()
+{
+    // PI control of a first order plus dead time plant, with a step and a disturbance
+    const std::array<PIDFSimulation::scenario_t, 2> scenarios {{
+        { DELTA_T, 3.0F, 1.0F, 0.0F, 100.0F, 0.0F, 5.0F, 0.02F },
+        { DELTA_T, 3.0F, 0.0F, 0.0F, 0.5F, 0.5F, 5.0F, 0.02F },
+    }};
+    const PIDFSimulationCost<PIDFPlantFOPDT<20>, 2> cost(PIDFPlantFOPDT<20>(1.0F, 0.2F, DELTA_T), scenarios, 0.001F);
+
+    // a sluggish controller costs more than a well tuned one
+    const float sluggish = cost(PIDFOptimizer::candidate_t { { 0.2F, 0.5F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F });
+    const float tuned = cost(PIDFOptimizer::candidate_t { { 3.0F, 12.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F });
+    TEST_ASSERT_TRUE(tuned < sluggish);
+    // without an output limit, an unstable controller diverges, and costs FLT_MAX
+    const std::array<PIDFSimulation::scenario_t, 1> unlimited {{ { DELTA_T, 3.0F, 1.0F, 0.0F, 100.0F, 0.0F, 0.0F, 0.02F } }};
+    const PIDFSimulationCost<PIDFPlantFOPDT<20>, 1> unlimitedCost(PIDFPlantFOPDT<20>(1.0F, 0.2F, DELTA_T), unlimited, 0.001F);
+    TEST_ASSERT_EQUAL_FLOAT(FLT_MAX, unlimitedCost(PIDFOptimizer::candidate_t { { 200.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F }));
+
+    PIDFOptimizer optimizer(4);
+    const PIDFOptimizer::candidate_t minimum { { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const PIDFOptimizer::candidate_t maximum { { 10.0F, 40.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.0F };
+    const std::vector<PIDFOptimizer::result_t> random = optimizer.random(minimum, maximum, 64, 1, cost);
+    TEST_ASSERT_TRUE(random[0].cost < sluggish);
+    const std::vector<PIDFOptimizer::candidate_t> starts { random[0].candidate, random[1].candidate };
+    const std::vector<PIDFOptimizer::result_t> refined = optimizer.nelderMead(minimum, maximum, starts, 60, cost);
+    TEST_ASSERT_TRUE(refined[0].cost <= random[0].cost);
+    TEST_ASSERT_EQUAL_FLOAT(refined[0].cost, cost(refined[0].candidate));
+
+    // parallel evaluation gives the same costs as evaluating one at a time
+    std::array<PIDFOptimizer::result_t, 8> results {};
+    std::array<PIDFOptimizer::candidate_t, 8> candidates {};
+    for (size_t ii = 0; ii < candidates.size(); ++ii) {
+        candidates[ii] = random[ii].candidate;
+    }
+    optimizer.evaluate(&candidates[0], candidates.size(), cost, &results[0]);
+    for (size_t ii = 0; ii < candidates.size(); ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(random[ii].cost, results[ii].cost);
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pool);
+    RUN_TEST(test_grid);
+    RUN_TEST(test_random_is_independent_of_thread_count);
+    RUN_TEST(test_nelder_mead);
+    RUN_TEST(test_simulation_cost);
+
+    UNITY_END();
+}
@@ -0,0 +1,157 @@
+#include <PIDF.h>
+#include <PIDFRecorder.h>
+#include <array>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static const PIDFRecorder::config_t configFloat {
+    PIDFRecordFields::ALL,
+    {{ PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT }},
+    {{ 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F }}
+};
+
+void test_record_size()
+{
+    TEST_ASSERT_EQUAL(2 + 8*4, PIDFRecorder::recordSize(configFloat));
+    const PIDFRecorder::config_t config {
+        PIDFRecordFields::SETPOINT | PIDFRecordFields::MEASUREMENT | PIDFRecordFields::OUTPUT,
+        {{ PIDFRecorder::QUANTIZED, PIDFRecorder::DELTA, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT }},
+        {{ 100.0F, 100.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F }}
+    };
+    TEST_ASSERT_EQUAL(2 + 2 + 1 + 4, PIDFRecorder::recordSize(config));
+
+    std::array<uint8_t, 100> buffer {};
+    const PIDFRecorder recorder(&buffer[0], buffer.size(), config);
+    TEST_ASSERT_EQUAL(9, recorder.getRecordSize());
+    TEST_ASSERT_EQUAL(11, recorder.getCapacity());
+    TEST_ASSERT_TRUE(PIDFRecordDecoder(recorder.getHeader()).isValid());
+}
+
+void test_record_float()
+{
+    std::array<uint8_t, 34*4> buffer {};
+    PIDFRecorder recorder(&buffer[0], buffer.size(), configFloat);
+    TEST_ASSERT_EQUAL(4, recorder.getCapacity());
+    const uint8_t* data = nullptr;
+    TEST_ASSERT_EQUAL(0, recorder.peek(data));
+
+    for (size_t ii = 0; ii < 6; ++ii) {
+        const auto value = static_cast<float>(ii);
+        recorder.record({ value, value + 0.1F, value + 0.2F, value + 0.3F, value + 0.4F, value + 0.5F, value + 0.6F, value + 0.7F });
+    }
+    // buffer holds 4 records, so the last 2 are dropped
+    TEST_ASSERT_EQUAL(4, recorder.available());
+    TEST_ASSERT_EQUAL(2, recorder.getDroppedCount());
+
+    PIDFRecordDecoder decoder(recorder.getHeader());
+    TEST_ASSERT_EQUAL(4*34, recorder.peek(data));
+    PIDFRecordDecoder::record_t record = decoder.decode(data);
+    TEST_ASSERT_EQUAL(0, record.sequence);
+    TEST_ASSERT_EQUAL(0, record.dropped);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, record.values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.7F, record.values[7]);
+    record = decoder.decode(data + 34);
+    TEST_ASSERT_EQUAL(1, record.sequence);
+    TEST_ASSERT_EQUAL_FLOAT(1.3F, record.values[3]);
+    recorder.consume(2*34);
+    TEST_ASSERT_EQUAL(2, recorder.available());
+
+    // space for two more records, which wrap around the end of the buffer
+    recorder.record({ 6.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    recorder.record({ 7.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    TEST_ASSERT_EQUAL(4, recorder.available());
+    TEST_ASSERT_EQUAL(2*34, recorder.peek(data));
+    decoder.decode(data);
+    decoder.decode(data + 34);
+    recorder.consume(2*34);
+    TEST_ASSERT_EQUAL(2*34, recorder.peek(data));
+    TEST_ASSERT_EQUAL_PTR(&buffer[0], data);
+    record = decoder.decode(data);
+    TEST_ASSERT_EQUAL(6, record.sequence);
+    TEST_ASSERT_EQUAL(2, record.dropped);
+    TEST_ASSERT_EQUAL_FLOAT(6.0F, record.values[0]);
+    record = decoder.decode(data + 34);
+    TEST_ASSERT_EQUAL(7, record.sequence);
+    TEST_ASSERT_EQUAL(0, record.dropped);
+    TEST_ASSERT_EQUAL_FLOAT(7.0F, record.values[0]);
+    recorder.consume(2*34);
+    TEST_ASSERT_EQUAL(0, recorder.peek(data));
+}
+
+void test_record_quantized_and_delta()
+{
+    const PIDFRecorder::config_t config {
+        PIDFRecordFields::SETPOINT | PIDFRecordFields::MEASUREMENT,
+        {{ PIDFRecorder::QUANTIZED, PIDFRecorder::DELTA, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, PIDFRecorder::FLOAT }},
+        {{ 1000.0F, 100.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F }}
+    };
+    std::array<uint8_t, 5*64> buffer {};
+    PIDFRecorder recorder(&buffer[0], buffer.size(), config);
+    PIDFRecordDecoder decoder(recorder.getHeader());
+    const uint8_t* data = nullptr;
+
+    // setpoint is quantized to 0.001, and saturates at 32.767
+    // measurement ramps at 0.5 per record, which is within the delta limit of 1.27 per record, then steps by 3.0
+    const std::array<float, 6> measurements { 0.5F, 1.0F, 1.5F, 4.5F, 4.5F, 4.5F };
+    const std::array<float, 6> expected { 0.5F, 1.0F, 1.5F, 2.77F, 4.04F, 4.5F };
+    for (size_t ii = 0; ii < measurements.size(); ++ii) {
+        recorder.record({ 1.23456F*static_cast<float>(ii*ii), measurements[ii], 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+        TEST_ASSERT_EQUAL(5, recorder.peek(data));
+        const PIDFRecordDecoder::record_t record = decoder.decode(data);
+        recorder.consume(5);
+        TEST_ASSERT_FLOAT_WITHIN(0.0005F, std::fmin(1.23456F*static_cast<float>(ii*ii), 32.767F), record.values[0]);
+        TEST_ASSERT_FLOAT_WITHIN(0.00001F, expected[ii], record.values[1]);
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, record.values[7]);
+    }
+}
+
+void test_pidf_recorder()
+{
+    std::array<uint8_t, 34*16> buffer {};
+    PIDFRecorder recorder(&buffer[0], buffer.size(), configFloat);
+    PIDFT<PIDFTerms::ALL | PIDFTerms::RECORDER> pid({ 0.3F, 0.2F, 0.1F, 0.05F, 0.01F });
+    TEST_ASSERT_NULL(pid.getRecorder());
+    pid.setSetpoint(5.0F);
+    pid.update(1.0F, 0.1F); // not recorded
+    pid.setRecorder(&recorder);
+    TEST_ASSERT_EQUAL_PTR(&recorder, pid.getRecorder());
+    pid.setSetpoint(4.0F, 0.1F);
+    const float output = pid.update(2.0F, 0.1F);
+    const PIDF::error_t error = pid.getError();
+
+    const uint8_t* data = nullptr;
+    TEST_ASSERT_EQUAL(34, recorder.peek(data));
+    PIDFRecordDecoder decoder(recorder.getHeader());
+    const PIDFRecordDecoder::record_t record = decoder.decode(data);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, record.values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, record.values[1]);
+    TEST_ASSERT_EQUAL_FLOAT(error.P, record.values[2]);
+    TEST_ASSERT_EQUAL_FLOAT(error.I, record.values[3]);
+    TEST_ASSERT_EQUAL_FLOAT(error.D, record.values[4]);
+    TEST_ASSERT_EQUAL_FLOAT(error.S, record.values[5]);
+    TEST_ASSERT_EQUAL_FLOAT(error.K, record.values[6]);
+    TEST_ASSERT_EQUAL_FLOAT(output, record.values[7]);
+
+    pid.setRecorder(nullptr);
+    pid.update(2.0F, 0.1F);
+    TEST_ASSERT_EQUAL(1, recorder.available());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_record_size);
+    RUN_TEST(test_record_float);
+    RUN_TEST(test_record_quantized_and_delta);
+    RUN_TEST(test_pidf_recorder);
+
+    UNITY_END();
+}
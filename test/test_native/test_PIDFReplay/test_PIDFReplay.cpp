@@ -0,0 +1,221 @@
+#include <PIDF.h>
+#include <PIDFReplay.h>
+#include <cmath>
+#include <cstdio>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 1.0F / 1000.0F;
+
+static void drain(PIDFRecorder& recorder, std::vector<uint8_t>& dump)
+{
+    const uint8_t* data = nullptr;
+    while (size_t size = recorder.peek(data)) {
+        dump.insert(dump.end(), data, data + size);
+        recorder.consume(size);
+    }
+}
+
+static std::vector<uint8_t> createDump(const PIDFRecorder::config_t& config, size_t count, std::vector<PIDFRecorder::values_t>& recorded)
+{
+    std::vector<uint8_t> buffer(256*PIDFRecorder::recordSize(config));
+    PIDFRecorder recorder(&buffer[0], buffer.size(), config);
+    const PIDFRecorder::header_t& header = recorder.getHeader();
+    std::vector<uint8_t> dump(reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header) + sizeof(header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    for (size_t ii = 0; ii < count; ++ii) {
+        const float t = static_cast<float>(ii)*DELTA_T;
+        const float setpoint = (ii % 2000) < 1000 ? 1.0F : -0.5F;
+        const float measurement = 0.8F*std::sin(3.0F*t) + 0.01F*static_cast<float>(ii % 7);
+        recorder.record({ setpoint, measurement, 0, 0, 0, 0, 0, 0 });
+        recorded.push_back({ setpoint, measurement, 0, 0, 0, 0, 0, 0 });
+        drain(recorder, dump);
+    }
+    return dump;
+}
+
+static const PIDFRecorder::config_t floatConfig {
+    PIDFRecordFields::SETPOINT | PIDFRecordFields::MEASUREMENT,
+    {{ PIDFRecorder::FLOAT, PIDFRecorder::FLOAT, 0, 0, 0, 0, 0, 0 }},
+    {{ 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F, 1.0F }}
+};
+
+void test_replay_invalid()
+{
+    const PIDFReplay empty(nullptr, 0);
+    TEST_ASSERT_FALSE(empty.isValid());
+    std::vector<PIDFRecorder::values_t> recorded;
+    std::vector<uint8_t> dump = createDump(floatConfig, 10, recorded);
+    dump[0] = 0; // corrupt the magic number
+    TEST_ASSERT_FALSE(PIDFReplay(&dump[0], dump.size()).isValid());
+
+    // no measurement recorded
+    const PIDFRecorder::config_t config { PIDFRecordFields::SETPOINT | PIDFRecordFields::OUTPUT, {}, {} };
+    std::vector<uint8_t> buffer(1024);
+    const PIDFRecorder recorder(&buffer[0], buffer.size(), config);
+    TEST_ASSERT_FALSE(PIDFReplay(reinterpret_cast<const uint8_t*>(&recorder.getHeader()), sizeof(PIDFRecorder::header_t)).isValid()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    PIDF pid;
+    size_t calls = 0;
+    const PIDFReplay::stats_t stats = empty.run(&pid, 1, DELTA_T, [&calls](size_t, size_t, const PIDFRecorder::values_t*, size_t) { ++calls; });
+    TEST_ASSERT_EQUAL(0, stats.recordCount);
+    TEST_ASSERT_EQUAL(0, calls);
+}
+
+void test_replay_gain_sets()
+{
+    enum { COUNT = 5000, GAIN_SETS = 3 }; // not a multiple of the block size
+    std::vector<PIDFRecorder::values_t> recorded;
+    std::vector<uint8_t> dump = createDump(floatConfig, COUNT, recorded);
+    dump.push_back(0x55); // partially written record, ignored
+    const PIDFReplay replay(&dump[0], dump.size());
+    TEST_ASSERT_TRUE(replay.isValid());
+    TEST_ASSERT_EQUAL(COUNT, replay.getRecordCount());
+
+    const std::array<PIDF::PIDF_t, GAIN_SETS> gains {{
+        { 1.0F, 10.0F, 0.01F, 0.1F, 0.0F },
+        { 2.0F, 0.0F, 0.0F, 0.0F, 0.0F },
+        { 0.5F, 40.0F, 0.02F, 0.0F, 0.0F },
+    }};
+    std::array<PIDF, GAIN_SETS> pids {{ PIDF(gains[0]), PIDF(gains[1]), PIDF(gains[2]) }};
+    pids[2].setOutputSaturationValue(1.0F);
+    std::array<std::vector<PIDFRecorder::values_t>, GAIN_SETS> results {};
+    const PIDFReplay::stats_t stats = replay.run(&pids[0], pids.size(), DELTA_T,
+        [&results](size_t pidIndex, size_t first, const PIDFRecorder::values_t* values, size_t count) {
+            TEST_ASSERT_EQUAL(results[pidIndex].size(), first);
+            results[pidIndex].insert(results[pidIndex].end(), values, values + count);
+        });
+    TEST_ASSERT_EQUAL(COUNT, stats.recordCount);
+    TEST_ASSERT_EQUAL(0, stats.droppedCount);
+
+    // the same as running each controller over the samples one at a time
+    for (size_t jj = 0; jj < GAIN_SETS; ++jj) {
+        TEST_ASSERT_EQUAL(COUNT, results[jj].size());
+        PIDF pid(gains[jj]);
+        if (jj == 2) {
+            pid.setOutputSaturationValue(1.0F);
+        }
+        for (size_t ii = 0; ii < COUNT; ++ii) {
+            pid.setSetpoint(recorded[ii][0]);
+            const float output = pid.update(recorded[ii][1], DELTA_T);
+            const PIDF::error_t e = pid.getError();
+            const PIDFRecorder::values_t& r = results[jj][ii];
+            TEST_ASSERT_EQUAL_FLOAT(recorded[ii][0], r[0]);
+            TEST_ASSERT_EQUAL_FLOAT(recorded[ii][1], r[1]);
+            TEST_ASSERT_EQUAL_FLOAT(e.P, r[2]);
+            TEST_ASSERT_EQUAL_FLOAT(e.I, r[3]);
+            TEST_ASSERT_EQUAL_FLOAT(e.D, r[4]);
+            TEST_ASSERT_EQUAL_FLOAT(e.S, r[5]);
+            TEST_ASSERT_EQUAL_FLOAT(e.K, r[6]);
+            TEST_ASSERT_EQUAL_FLOAT(output, r[7]);
+        }
+    }
+}
+
+void test_replay_update_function()
+{
+    // quantized log, replayed through the fixed-rate updateSPI
+    const PIDFRecorder::config_t config {
+        PIDFRecordFields::SETPOINT | PIDFRecordFields::MEASUREMENT,
+        {{ PIDFRecorder::QUANTIZED, PIDFRecorder::DELTA, 0, 0, 0, 0, 0, 0 }},
+        {{ 1000.0F, 1000.0F, 0, 0, 0, 0, 0, 0 }}
+    };
+    std::vector<PIDFRecorder::values_t> recorded;
+    const std::vector<uint8_t> dump = createDump(config, 1500, recorded);
+    const PIDFReplay replay(&dump[0], dump.size());
+    TEST_ASSERT_TRUE(replay.isValid());
+    PIDF pid({ 1.0F, 5.0F, 0.0F, 0.2F, 0.0F });
+    pid.setSampleTime(DELTA_T);
+    std::vector<float> outputs;
+    replay.run(&pid, 1, DELTA_T,
+        [](PIDF& p, const PIDFReplay::sample_t& sample) { p.setSetpoint(sample.setpoint); return p.updateSPI(sample.measurement); },
+        [&outputs](size_t, size_t, const PIDFRecorder::values_t* values, size_t count) {
+            for (size_t ii = 0; ii < count; ++ii) { outputs.push_back(values[ii][7]); }
+        });
+    TEST_ASSERT_EQUAL(1500, outputs.size());
+    PIDF reference({ 1.0F, 5.0F, 0.0F, 0.2F, 0.0F });
+    reference.setSampleTime(DELTA_T);
+    for (size_t ii = 0; ii < outputs.size(); ++ii) {
+        reference.setSetpoint(recorded[ii][0]);
+        // quantized to 0.001
+        TEST_ASSERT_FLOAT_WITHIN(0.01F, reference.updateSPI(recorded[ii][1]), outputs[ii]);
+    }
+}
+
+void test_replay_dropped()
+{
+    // records dropped by the recorder are skipped, and the next deltaT spans the gap
+    std::vector<uint8_t> buffer(4*PIDFRecorder::recordSize(floatConfig));
+    PIDFRecorder recorder(&buffer[0], buffer.size(), floatConfig);
+    const PIDFRecorder::header_t& header = recorder.getHeader();
+    std::vector<uint8_t> dump(reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header) + sizeof(header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    for (int ii = 0; ii < 7; ++ii) {
+        recorder.record({ 1.0F, static_cast<float>(ii), 0, 0, 0, 0, 0, 0 }); // records 4, 5, and 6 are dropped
+    }
+    drain(recorder, dump);
+    recorder.record({ 1.0F, 7.0F, 0, 0, 0, 0, 0, 0 });
+    drain(recorder, dump);
+    const PIDFReplay replay(&dump[0], dump.size());
+    TEST_ASSERT_EQUAL(5, replay.getRecordCount());
+
+    PIDF pid;
+    std::vector<float> deltaTs;
+    const PIDFReplay::stats_t stats = replay.run(&pid, 1, DELTA_T,
+        [&deltaTs](PIDF&, const PIDFReplay::sample_t& sample) { deltaTs.push_back(sample.deltaT); return 0.0F; },
+        [](size_t, size_t, const PIDFRecorder::values_t*, size_t) {});
+    TEST_ASSERT_EQUAL(5, stats.recordCount);
+    TEST_ASSERT_EQUAL(3, stats.droppedCount);
+    TEST_ASSERT_EQUAL_FLOAT(DELTA_T, deltaTs[0]);
+    TEST_ASSERT_EQUAL_FLOAT(DELTA_T, deltaTs[3]);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F*DELTA_T, deltaTs[4]);
+}
+
+void test_mapped_file()
+{
+    std::vector<PIDFRecorder::values_t> recorded;
+    const std::vector<uint8_t> dump = createDump(floatConfig, 3000, recorded);
+    const char* path = "test_PIDFReplay.bin";
+    FILE* file = std::fopen(path, "wb"); // NOLINT(cppcoreguidelines-owning-memory)
+    TEST_ASSERT_NOT_NULL(file);
+    std::fwrite(&dump[0], 1, dump.size(), file);
+    std::fclose(file); // NOLINT(cppcoreguidelines-owning-memory)
+
+    PIDFMappedFile mapped;
+    TEST_ASSERT_FALSE(mapped.open("no_such_file.bin"));
+    TEST_ASSERT_TRUE(mapped.open(path));
+    TEST_ASSERT_EQUAL(dump.size(), mapped.size());
+    TEST_ASSERT_EQUAL(0, memcmp(&dump[0], mapped.data(), dump.size()));
+    const PIDFReplay replay(mapped.data(), mapped.size());
+    TEST_ASSERT_EQUAL(3000, replay.getRecordCount());
+    PIDF pid({ 1.0F, 10.0F, 0.0F, 0.0F, 0.0F });
+    float last = 0.0F;
+    replay.run(&pid, 1, DELTA_T, [&last](size_t, size_t, const PIDFRecorder::values_t* values, size_t count) { last = values[count - 1][7]; });
+    PIDF reference({ 1.0F, 10.0F, 0.0F, 0.0F, 0.0F });
+    float output = 0.0F;
+    for (const auto& r : recorded) {
+        reference.setSetpoint(r[0]);
+        output = reference.update(r[1], DELTA_T);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(output, last);
+    mapped.close();
+    TEST_ASSERT_NULL(mapped.data());
+    std::remove(path);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_replay_invalid);
+    RUN_TEST(test_replay_gain_sets);
+    RUN_TEST(test_replay_update_function);
+    RUN_TEST(test_replay_dropped);
+    RUN_TEST(test_mapped_file);
+
+    UNITY_END();
+}
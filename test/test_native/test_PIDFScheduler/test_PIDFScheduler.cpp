@@ -0,0 +1,218 @@
+#include <PIDFScheduler.h>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr uint64_t MICROSECONDS = 1000;
+static constexpr uint64_t MILLISECONDS = 1000000;
+
+void test_timer_wheel()
+{
+    // timers in every level, and beyond the range of the wheel
+    const std::array<uint64_t, 12> expiries {{ 1, 2, 63, 64, 65, 100, 4095, 4096, 4097, 300000, PIDFTimerWheel::MAX_DELTA + 10, 3*PIDFTimerWheel::MAX_DELTA }};
+    PIDFTimerWheel wheel(expiries.size());
+    TEST_ASSERT_EQUAL(UINT64_MAX, wheel.getNextTick());
+    for (size_t ii = 0; ii < expiries.size(); ++ii) {
+        wheel.schedule(static_cast<uint32_t>(ii), expiries[ii]);
+    }
+    TEST_ASSERT_EQUAL(1, wheel.getNextTick());
+
+    // jumping from event to event, each timer expires on its tick, and no event is missed
+    std::array<uint64_t, 12> expired {};
+    size_t expiredCount = 0;
+    size_t steps = 0;
+    while (wheel.getNextTick() != UINT64_MAX) {
+        const uint64_t next = wheel.getNextTick();
+        TEST_ASSERT_TRUE(next > wheel.getTick());
+        wheel.advance(next, [&](uint32_t timer) { expired[timer] = wheel.getTick(); ++expiredCount; });
+        ++steps;
+    }
+    TEST_ASSERT_EQUAL(expiries.size(), expiredCount);
+    for (size_t ii = 0; ii < expiries.size(); ++ii) {
+        TEST_ASSERT_EQUAL(expiries[ii], expired[ii]);
+    }
+    // the wheel does not wake on every tick
+    TEST_ASSERT_TRUE(steps < 100);
+
+    // advancing one tick at a time gives the same expiries, a timer scheduled in the past expires on the next tick
+    wheel.reset(1000);
+    wheel.schedule(0, 10);
+    wheel.schedule(1, 1000 + 64*64 + 7);
+    wheel.schedule(2, 1064);
+    expired.fill(0);
+    for (uint64_t tick = 1001; tick < 1000 + 64*64 + 100; ++tick) {
+        wheel.advance(tick, [&](uint32_t timer) { expired[timer] = tick; });
+    }
+    TEST_ASSERT_EQUAL(1001, expired[0]);
+    TEST_ASSERT_EQUAL(1000 + 64*64 + 7, expired[1]);
+    TEST_ASSERT_EQUAL(1064, expired[2]);
+
+    // a timer can be rescheduled from its expiry, and a large jump expires everything in between in order
+    wheel.reset(0);
+    size_t count = 0;
+    uint64_t previous = 0;
+    wheel.schedule(0, 3);
+    wheel.advance(1000, [&](uint32_t timer) {
+        TEST_ASSERT_TRUE(wheel.getTick() > previous);
+        previous = wheel.getTick();
+        ++count;
+        wheel.schedule(timer, wheel.getTick() + 3);
+    });
+    TEST_ASSERT_EQUAL(333, count);
+    TEST_ASSERT_EQUAL(1000, wheel.getTick());
+}
+
+void test_scheduler_rates()
+{
+    PIDFSimulatedClock clock(5*MILLISECONDS);
+    PIDFScheduler scheduler(clock, 1, 100*MICROSECONDS);
+    // integral only controllers, with an error of 1, so the output is the sum of the deltaTs
+    std::array<PIDF, 3> pids {{ PIDF({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F }), PIDF({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F }), PIDF({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F }) }};
+    std::array<float, 3> outputs {};
+    std::vector<size_t> order;
+    const std::array<uint64_t, 3> periods {{ 20*MILLISECONDS, 1*MILLISECONDS, 4*MILLISECONDS }};
+    for (size_t ii = 0; ii < pids.size(); ++ii) {
+        pids[ii].setSetpoint(1.0F);
+        const size_t loop = scheduler.addLoop(pids[ii], periods[ii],
+            [&order, ii]() { order.push_back(ii); return 0.0F; },
+            [&outputs, ii](float output) { outputs[ii] = output; });
+        TEST_ASSERT_EQUAL(ii, loop);
+    }
+    TEST_ASSERT_EQUAL(0, scheduler.getThread(0));
+
+    scheduler.runUntil(5*MILLISECONDS + 1000*MILLISECONDS);
+    TEST_ASSERT_EQUAL(5*MILLISECONDS + 1000*MILLISECONDS, clock.now());
+    const std::array<uint32_t, 3> runCounts {{ 50, 1000, 250 }};
+    for (size_t ii = 0; ii < pids.size(); ++ii) {
+        const PIDFScheduler::stats_t stats = scheduler.getStats(ii);
+        TEST_ASSERT_EQUAL(runCounts[ii], stats.runCount);
+        TEST_ASSERT_EQUAL(0, stats.missCount);
+        TEST_ASSERT_EQUAL(0, stats.skipCount);
+        TEST_ASSERT_EQUAL(0, stats.maxLatency);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, 1.0F, outputs[ii]);
+    }
+    // loops released together run shortest period first
+    TEST_ASSERT_EQUAL(1, order[order.size() - 3]);
+    TEST_ASSERT_EQUAL(2, order[order.size() - 2]);
+    TEST_ASSERT_EQUAL(0, order[order.size() - 1]);
+
+    // running again continues from where the scheduler stopped
+    scheduler.runUntil(clock.now() + 100*MILLISECONDS);
+    TEST_ASSERT_EQUAL(1100, scheduler.getStats(1).runCount);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, 1.1F, outputs[1]);
+}
+
+void test_scheduler_deadline_miss()
+{
+    PIDFSimulatedClock clock;
+    PIDFScheduler scheduler(clock, 1, 100*MICROSECONDS);
+    PIDF pid({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F });
+    pid.setSetpoint(1.0F);
+    uint32_t run = 0;
+    // each run takes 300us, except the fifth, which takes 2.5ms
+    const size_t loop = scheduler.addLoop(pid, 1*MILLISECONDS,
+        [&clock, &run]() { ++run; clock.advance(run == 5 ? 2500*MICROSECONDS : 300*MICROSECONDS); return 0.0F; },
+        [](float) {});
+    scheduler.runUntil(20*MILLISECONDS);
+
+    // the fifth run (released at 5ms) ends at 7.5ms, the sixth (released at 6ms) starts late at 7.5ms and ends at 7.8ms,
+    // so both miss their deadlines, and the release at 7ms is skipped
+    const PIDFScheduler::stats_t stats = scheduler.getStats(loop);
+    TEST_ASSERT_EQUAL(19, stats.runCount);
+    TEST_ASSERT_EQUAL(2, stats.missCount);
+    TEST_ASSERT_EQUAL(1, stats.skipCount);
+    TEST_ASSERT_EQUAL(1500*MICROSECONDS, stats.maxLatency);
+    TEST_ASSERT_EQUAL(2500*MICROSECONDS, stats.maxExecutionTime);
+    // deltaT is measured between the starts of the runs, so the integral is the time from the start to the last run
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 0.020F, pid.getError().I);
+
+    // with a longer deadline, the same overrun is not a miss
+    PIDFSimulatedClock clock2;
+    PIDFScheduler scheduler2(clock2, 1, 100*MICROSECONDS);
+    run = 0;
+    const size_t loop2 = scheduler2.addLoop(pid, 1*MILLISECONDS,
+        [&clock2, &run]() { ++run; clock2.advance(run == 5 ? 1800*MICROSECONDS : 300*MICROSECONDS); return 0.0F; },
+        [](float) {});
+    scheduler2.setDeadline(loop2, 3*MILLISECONDS);
+    scheduler2.runUntil(20*MILLISECONDS);
+    TEST_ASSERT_EQUAL(0, scheduler2.getStats(loop2).missCount);
+    TEST_ASSERT_EQUAL(0, scheduler2.getStats(loop2).skipCount);
+    TEST_ASSERT_EQUAL(20, scheduler2.getStats(loop2).runCount);
+}
+
+void test_scheduler_tick_resolution()
+{
+    // the period is not a multiple of the tick, releases are at exact multiples of the period, run on the following tick
+    PIDFSimulatedClock clock;
+    PIDFScheduler scheduler(clock, 1, 300*MICROSECONDS);
+    PIDF pid({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F });
+    pid.setSetpoint(1.0F);
+    std::vector<uint64_t> starts;
+    const size_t loop = scheduler.addLoop(pid, 1*MILLISECONDS, [&clock, &starts]() { starts.push_back(clock.now()); return 0.0F; }, [](float) {});
+    scheduler.runUntil(10*MILLISECONDS + 300*MICROSECONDS);
+    TEST_ASSERT_EQUAL(10, starts.size());
+    for (size_t ii = 0; ii < starts.size(); ++ii) {
+        const uint64_t release = (ii + 1)*MILLISECONDS;
+        TEST_ASSERT_TRUE(starts[ii] >= release);
+        TEST_ASSERT_TRUE(starts[ii] < release + 300*MICROSECONDS);
+    }
+    TEST_ASSERT_TRUE(scheduler.getStats(loop).maxLatency > 0);
+    TEST_ASSERT_EQUAL(0, scheduler.getStats(loop).missCount);
+}
+
+void test_scheduler_threads()
+{
+    PIDFMonotonicClock clock;
+    PIDFScheduler scheduler(clock, 3, 100*MICROSECONDS);
+    std::array<PIDF, 4> pids {};
+    std::array<std::atomic<float>, 4> outputs {};
+    for (size_t ii = 0; ii < pids.size(); ++ii) {
+        pids[ii].setPID({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F });
+        pids[ii].setSetpoint(1.0F);
+        scheduler.addLoop(pids[ii], ii < 2 ? 1*MILLISECONDS : 4*MILLISECONDS, []() { return 0.0F; }, [&outputs, ii](float output) { outputs[ii].store(output); });
+    }
+    // loops are spread over the threads other than the dispatcher, by rate
+    TEST_ASSERT_EQUAL(1, scheduler.getThread(0));
+    TEST_ASSERT_EQUAL(2, scheduler.getThread(1));
+    TEST_ASSERT_EQUAL(1, scheduler.getThread(2));
+    TEST_ASSERT_EQUAL(2, scheduler.getThread(3));
+
+    const uint64_t start = clock.now();
+    scheduler.start();
+    TEST_ASSERT_TRUE(scheduler.isRunning());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    scheduler.stop();
+    const float elapsed = static_cast<float>(clock.now() - start)*1.0e-9F;
+    TEST_ASSERT_FALSE(scheduler.isRunning());
+
+    for (size_t ii = 0; ii < pids.size(); ++ii) {
+        const PIDFScheduler::stats_t stats = scheduler.getStats(ii);
+        const float period = ii < 2 ? 0.001F : 0.004F;
+        const auto releases = static_cast<uint32_t>(elapsed/period);
+        // allow for a loaded test machine
+        TEST_ASSERT_TRUE(stats.runCount > releases/4);
+        TEST_ASSERT_TRUE(stats.runCount + stats.skipCount <= releases);
+        // the integral is the sum of the measured deltaTs
+        TEST_ASSERT_TRUE(outputs[ii].load() > 0.0F);
+        TEST_ASSERT_TRUE(outputs[ii].load() <= elapsed);
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_timer_wheel);
+    RUN_TEST(test_scheduler_rates);
+    RUN_TEST(test_scheduler_deadline_miss);
+    RUN_TEST(test_scheduler_tick_resolution);
+    RUN_TEST(test_scheduler_threads);
+
+    UNITY_END();
+}
@@ -0,0 +1,100 @@
+#include <PIDF.h>
+#include <PIDFSeqlock.h>
+#include <atomic>
+#include <thread>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+void test_seqlock()
+{
+    PIDFSeqlock<PIDF::error_t> seqlock;
+    TEST_ASSERT_EQUAL(0, seqlock.getPublishCount());
+    PIDF::error_t error = seqlock.read();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, error.P);
+
+    seqlock.publish(PIDF::error_t { 1.0F, 2.0F, 3.0F, 4.0F, 5.0F });
+    TEST_ASSERT_EQUAL(1, seqlock.getPublishCount());
+    TEST_ASSERT_TRUE(seqlock.tryRead(error));
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, error.P);
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, error.I);
+    TEST_ASSERT_EQUAL_FLOAT(3.0F, error.D);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, error.S);
+    TEST_ASSERT_EQUAL_FLOAT(5.0F, error.K);
+
+    const PIDFSeqlock<PIDF::error_t> copy(seqlock); // NOLINT(performance-unnecessary-copy-initialization)
+    TEST_ASSERT_EQUAL_FLOAT(5.0F, copy.read().K);
+}
+
+void test_error_snapshot()
+{
+    PIDFT<PIDFTerms::ALL | PIDFTerms::ERROR_SNAPSHOT> pid({ 0.3F, 0.2F, 0.1F, 0.05F, 0.0F });
+    pid.setSetpoint(5.0F);
+    pid.update(1.0F, 0.1F);
+    const PIDF::error_t error = pid.getError();
+    const PIDF::error_t snapshot = pid.getErrorSnapshot();
+    TEST_ASSERT_EQUAL_FLOAT(error.P, snapshot.P);
+    TEST_ASSERT_EQUAL_FLOAT(error.I, snapshot.I);
+    TEST_ASSERT_EQUAL_FLOAT(error.D, snapshot.D);
+    TEST_ASSERT_EQUAL_FLOAT(error.S, snapshot.S);
+    TEST_ASSERT_EQUAL_FLOAT(error.K, snapshot.K);
+
+    pid.setSampleTime(0.1F);
+    pid.update(2.0F);
+    PIDF::error_t snapshotFixedRate {};
+    TEST_ASSERT_TRUE(pid.tryGetErrorSnapshot(snapshotFixedRate));
+    TEST_ASSERT_EQUAL_FLOAT(pid.getErrorP(), snapshotFixedRate.P);
+    TEST_ASSERT_EQUAL_FLOAT(pid.getErrorI(), snapshotFixedRate.I);
+}
+
+void test_seqlock_concurrent()
+{
+    // writer publishes values with all fields equal, reader checks it never sees a mix of old and new fields
+    PIDFSeqlock<PIDF::error_t> seqlock;
+    std::atomic<bool> started {false};
+    std::atomic<bool> done {false};
+    int tornCount = 0;
+    int readCount = 0;
+    std::thread reader([&]() {
+        started.store(true);
+        while (!done.load()) {
+            const PIDF::error_t error = seqlock.read();
+            ++readCount;
+            if (error.P != error.I || error.P != error.D || error.P != error.S || error.P != error.K) {
+                ++tornCount;
+            }
+        }
+    });
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+    for (int ii = 1; ii <= 200000; ++ii) {
+        const auto value = static_cast<float>(ii);
+        seqlock.publish(PIDF::error_t { value, value, value, value, value });
+        if (ii % 1000 == 0) {
+            std::this_thread::yield(); // so the reader also runs on a single core machine
+        }
+    }
+    done.store(true);
+    reader.join();
+    TEST_ASSERT_EQUAL(0, tornCount);
+    TEST_ASSERT_GREATER_THAN(0, readCount);
+    TEST_ASSERT_EQUAL(200000, seqlock.getPublishCount());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_seqlock);
+    RUN_TEST(test_error_snapshot);
+    RUN_TEST(test_seqlock_concurrent);
+
+    UNITY_END();
+}
@@ -0,0 +1,193 @@
+#include <PIDF.h>
+#include <PIDFSimulation.h>
+#include <cmath>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 1.0F / 8000.0F;
+
+void test_plant_fopdt()
+{
+    PIDFPlantFOPDT<80> plant(2.0F, 0.1F, DELTA_T); // 10ms dead time
+    for (int ii = 0; ii < 80; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, plant.update(1.0F));
+    }
+    // one time constant after the dead time, the output is 63.2% of the final value
+    for (int ii = 0; ii < 800; ++ii) {
+        plant.update(1.0F);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.002F, 2.0F*(1.0F - std::exp(-1.0F)), plant.getOutput());
+    plant.reset();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, plant.getOutput());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, plant.update(1.0F));
+
+    static_assert(sizeof(PIDFPlantFOPDT<>) == 3*sizeof(float), "no delay takes no space");
+    PIDFPlantFOPDT<> noDelay(1.0F, 0.1F, DELTA_T);
+    TEST_ASSERT_EQUAL_FLOAT(DELTA_T/0.1F, noDelay.update(1.0F));
+}
+
+void test_plant_integrating()
+{
+    PIDFPlantIntegrating<8> plant(3.0F, DELTA_T);
+    for (int ii = 0; ii < 8 + 8000; ++ii) {
+        plant.update(0.5F);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0001F, 1.5F, plant.getOutput());
+}
+
+void test_plant_second_order()
+{
+    // step response overshoot is exp(-pi*zeta/sqrt(1 - zeta^2))
+    constexpr float zeta = 0.3F;
+    PIDFPlantSecondOrder plant(1.0F, 20.0F, zeta, DELTA_T);
+    float maxOutput = 0.0F;
+    for (int ii = 0; ii < 8000; ++ii) {
+        maxOutput = std::fmax(maxOutput, plant.update(1.0F));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, 1.0F + std::exp(-3.14159265F*zeta/std::sqrt(1.0F - zeta*zeta)), maxOutput);
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, 1.0F, plant.getOutput());
+}
+
+void test_plant_motor()
+{
+    PIDFPlantMotor motor(0.5F, 0.01F, 0.02F, 0.1F, DELTA_T);
+    // drive torque less than Coulomb friction, so the motor does not start
+    for (int ii = 0; ii < 100; ++ii) {
+        TEST_ASSERT_EQUAL_FLOAT(0.0F, motor.update(0.15F));
+    }
+    // steady state speed is (kt*input - coulombFriction)/viscousFriction
+    for (int ii = 0; ii < 80000; ++ii) {
+        motor.update(1.0F);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, (0.5F - 0.1F)/0.02F, motor.getSpeed());
+    TEST_ASSERT_TRUE(motor.getPosition() > 0.0F);
+    // with no drive, friction brings the motor to a stop, and does not reverse it
+    for (int ii = 0; ii < 80000; ++ii) {
+        motor.update(0.0F);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, motor.getSpeed());
+}
+
+void test_scenario_step()
+{
+    const PIDFSimulation::scenario_t scenario { DELTA_T, 2.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.02F };
+    // P controller on first order plant: closed loop time constant is tau/(1 + kp*K), with steady state error 1/(1 + kp*K)
+    PIDFPlantFOPDT<> plant(1.0F, 0.1F, DELTA_T);
+    PIDF pid({ 4.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    PIDFSimulation::metrics_t metrics = PIDFSimulation::run(plant, scenario, [&pid](float setpoint, float measurement) {
+        pid.setSetpoint(setpoint);
+        return pid.updateSP(measurement);
+    });
+    TEST_ASSERT_FLOAT_WITHIN(0.0001F, 0.2F, metrics.finalError);
+    TEST_ASSERT_TRUE(metrics.riseTime < 0.0F); // never reaches 90%
+    TEST_ASSERT_TRUE(metrics.settlingTime < 0.0F);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, metrics.overshoot);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, metrics.peakOutput);
+    // IAE is steady state error * duration, plus the transient 0.8*tauClosedLoop
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 0.2F*2.0F + 0.8F*0.02F, static_cast<float>(metrics.iae));
+
+    // PI controller removes the steady state error, and the rise time is ln(9)*tauClosedLoop
+    plant.reset();
+    PIDF pidPI({ 4.0F, 40.0F, 0.0F, 0.0F, 0.0F });
+    metrics = PIDFSimulation::run(plant, scenario, [&pidPI](float setpoint, float measurement) {
+        pidPI.setSetpoint(setpoint);
+        return pidPI.update(measurement, DELTA_T);
+    });
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 0.0F, metrics.finalError);
+    TEST_ASSERT_TRUE(metrics.riseTime > 0.0F);
+    TEST_ASSERT_TRUE(metrics.settlingTime > metrics.riseTime);
+    TEST_ASSERT_TRUE(metrics.settlingTime < 1.0F);
+    TEST_ASSERT_TRUE(metrics.itae < metrics.iae);
+}
+
+void test_scenario_saturation_and_disturbance()
+{
+    // output limited, so saturated for the start of the step, disturbance rejected by the integral
+    const PIDFSimulation::scenario_t scenario { DELTA_T, 4.0F, 1.0F, 0.0F, 2.0F, -0.5F, 2.0F, 0.02F };
+    PIDFPlantFOPDT<8> plant(1.0F, 0.1F, DELTA_T);
+    PIDF pid({ 10.0F, 20.0F, 0.0F, 0.0F, 0.0F });
+    pid.setSampleTime(DELTA_T);
+    pid.setOutputSaturationValue(2.0F);
+    float errorAtDisturbance = 0.0F;
+    int step = 0;
+    const PIDFSimulation::metrics_t metrics = PIDFSimulation::run(plant, scenario, [&](float setpoint, float measurement) {
+        if (step++ == 2*8000 + 400) {
+            errorAtDisturbance = setpoint - measurement;
+        }
+        pid.setSetpoint(setpoint);
+        return pid.update(measurement);
+    });
+    TEST_ASSERT_TRUE(metrics.saturationTime > 0.01F);
+    TEST_ASSERT_TRUE(metrics.saturationTime < 0.5F);
+    TEST_ASSERT_TRUE(errorAtDisturbance > 0.01F);
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, 0.0F, metrics.finalError);
+    TEST_ASSERT_TRUE(metrics.settlingTime > 2.0F); // the disturbance took the error out of the band
+}
+
+void test_scenario_update_variants()
+{
+    // the variable rate, fixed rate, and optimized PI updates control the plant identically (to within rounding)
+    const PIDFSimulation::scenario_t scenario { DELTA_T, 1.0F, 1.0F, 0.5F, 0.5F, 0.2F, 0.0F, 0.02F };
+    constexpr PIDF::PIDF_t gains { 2.0F, 30.0F, 0.0F, 0.0F, 0.0F };
+    PIDFPlantSecondOrder plant(1.0F, 30.0F, 0.7F, DELTA_T);
+    PIDF pid(gains);
+    const PIDFSimulation::metrics_t metrics = PIDFSimulation::run(plant, scenario, [&pid](float setpoint, float measurement) {
+        pid.setSetpoint(setpoint);
+        return pid.update(measurement, DELTA_T);
+    });
+    plant.reset();
+    PIDF pidFixed(gains);
+    pidFixed.setSampleTime(DELTA_T);
+    const PIDFSimulation::metrics_t metricsFixed = PIDFSimulation::run(plant, scenario, [&pidFixed](float setpoint, float measurement) {
+        pidFixed.setSetpoint(setpoint);
+        return pidFixed.update(measurement);
+    });
+    plant.reset();
+    PIDFT<PIDFTerms::PI> pidPI(gains);
+    const PIDFSimulation::metrics_t metricsPI = PIDFSimulation::run(plant, scenario, [&pidPI](float setpoint, float measurement) {
+        pidPI.setSetpoint(setpoint);
+        return pidPI.update(measurement, DELTA_T);
+    });
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, static_cast<float>(metrics.iae), static_cast<float>(metricsFixed.iae));
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, static_cast<float>(metrics.iae), static_cast<float>(metricsPI.iae));
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, metrics.overshoot, metricsPI.overshoot);
+}
+void test_scenario_ramp()
+{
+    // a measurement that tracks the ramping setpoint has (almost) no overshoot, even though it ends at 6 times the step
+    const PIDFSimulation::scenario_t scenario { DELTA_T, 10.0F, 1.0F, 0.5F, 100.0F, 0.0F, 0.0F, 0.02F };
+    PIDFPlantIntegrating<> plant(1.0F, DELTA_T);
+    PIDF pid({ 40.0F, 100.0F, 0.0F, 0.0F, 0.0F });
+    pid.setSampleTime(DELTA_T);
+    const PIDFSimulation::metrics_t metrics = PIDFSimulation::run(plant, scenario, [&pid](float setpoint, float measurement) {
+        pid.setSetpoint(setpoint);
+        return pid.update(measurement);
+    });
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 0.0F, metrics.finalError);
+    TEST_ASSERT_TRUE(metrics.overshoot < 0.05F);
+    TEST_ASSERT_TRUE(metrics.riseTime < 0.0F); // not calculated for a ramp
+    TEST_ASSERT_TRUE(metrics.settlingTime > 0.0F);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_plant_fopdt);
+    RUN_TEST(test_plant_integrating);
+    RUN_TEST(test_plant_second_order);
+    RUN_TEST(test_plant_motor);
+    RUN_TEST(test_scenario_step);
+    RUN_TEST(test_scenario_saturation_and_disturbance);
+    RUN_TEST(test_scenario_update_variants);
+    RUN_TEST(test_scenario_ramp);
+
+    UNITY_END();
+}
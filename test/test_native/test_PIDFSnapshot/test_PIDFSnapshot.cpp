@@ -0,0 +1,126 @@
+#include <PIDF.h>
+#include <PIDFSnapshot.h>
+#include <array>
+#include <cstring>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 0.001F;
+
+static PIDF createPID()
+{
+    PIDF pid({ 0.5F, 4.0F, 0.001F, 0.1F, 0.0F });
+    pid.setSampleTime(DELTA_T);
+    pid.setIntegralLimit(0.6F);
+    pid.setIntegralThreshold(0.001F);
+    pid.setOutputSaturationValue(0.9F);
+    return pid;
+}
+
+void test_crc32()
+{
+    const char* check = "123456789";
+    TEST_ASSERT_TRUE(PIDFSnapshot::crc32(reinterpret_cast<const uint8_t*>(check), strlen(check)) == 0xCBF43926); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    TEST_ASSERT_TRUE(PIDFSnapshot::crc32(nullptr, 0) == 0);
+}
+
+void test_capture_restore()
+{
+    PIDF pid = createPID();
+    pid.setSetpoint(0.4F);
+    float measurement = 0.0F;
+    for (int ii = 0; ii < 500; ++ii) {
+        measurement += (pid.update(measurement) - measurement)*0.01F;
+    }
+    const PIDFSnapshot::snapshot_t snapshot = PIDFSnapshot::capture(pid, PIDFSnapshot::STATE);
+    TEST_ASSERT_EQUAL(64, sizeof(snapshot));
+    TEST_ASSERT_TRUE(PIDFSnapshot::isValid(snapshot));
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, snapshot.pid.ki);
+    TEST_ASSERT_EQUAL_FLOAT(-0.6F, snapshot.integralMin);
+    TEST_ASSERT_EQUAL_FLOAT(DELTA_T, snapshot.sampleTime);
+    TEST_ASSERT_EQUAL_FLOAT(pid.getErrorI(), snapshot.errorIntegral);
+    TEST_ASSERT_TRUE(snapshot.errorIntegral > 0.1F);
+
+    // a controller restored from the snapshot continues exactly as the original, a cold started one does not
+    PIDF warm;
+    PIDFSnapshot::restore(warm, snapshot);
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, warm.getP());
+    TEST_ASSERT_EQUAL_FLOAT(0.9F, warm.getOutputSaturationValue());
+    TEST_ASSERT_EQUAL_FLOAT(0.001F, warm.getIntegralThreshold());
+    TEST_ASSERT_EQUAL_FLOAT(0.4F, warm.getSetpoint());
+    PIDF cold = createPID();
+    cold.setSetpoint(0.4F);
+    const float coldOutput = cold.update(measurement);
+    for (int ii = 0; ii < 100; ++ii) {
+        const float output = pid.update(measurement);
+        TEST_ASSERT_EQUAL_FLOAT(output, warm.update(measurement));
+        measurement += (output - measurement)*0.01F;
+    }
+    TEST_ASSERT_TRUE(coldOutput < warm.getErrorI());
+
+    // without the state, only the gains and limits are stored and restored, and the state is left unchanged
+    const PIDFSnapshot::snapshot_t gainsOnly = PIDFSnapshot::capture(pid, 0);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, gainsOnly.errorIntegral);
+    const float coldIntegral = cold.getErrorI();
+    PIDFSnapshot::restore(cold, gainsOnly);
+    TEST_ASSERT_EQUAL_FLOAT(coldIntegral, cold.getErrorI());
+
+    // a snapshot can be restored into a controller with fewer terms
+    PIDFT<PIDFTerms::PI | PIDFTerms::INTEGRAL_LIMIT> pidPI;
+    PIDFSnapshot::restore(pidPI, snapshot);
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, pidPI.getI());
+    TEST_ASSERT_EQUAL_FLOAT(0.6F, pidPI.getIntegralMax());
+    TEST_ASSERT_EQUAL_FLOAT(snapshot.errorIntegral, pidPI.getErrorI());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, PIDFSnapshot::capture(pidPI, PIDFSnapshot::STATE).sampleTime);
+}
+
+void test_find()
+{
+    // a flash page holding the snapshot, followed by erased bytes
+    alignas(4) std::array<uint8_t, 128> page {};
+    page.fill(0xFF);
+    TEST_ASSERT_NULL(PIDFSnapshot::find(&page[0], page.size()));
+
+    const PIDFSnapshot::snapshot_t snapshot = PIDFSnapshot::capture(createPID(), PIDFSnapshot::STATE);
+    memcpy(&page[0], &snapshot, sizeof(snapshot));
+    const PIDFSnapshot::snapshot_t* found = PIDFSnapshot::find(&page[0], page.size());
+    TEST_ASSERT_TRUE(found == reinterpret_cast<const PIDFSnapshot::snapshot_t*>(&page[0])); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    TEST_ASSERT_EQUAL_FLOAT(0.1F, found->pid.ks);
+    TEST_ASSERT_NULL(PIDFSnapshot::find(&page[0], sizeof(snapshot) - 1));
+    TEST_ASSERT_NULL(PIDFSnapshot::find(nullptr, page.size()));
+
+    // misaligned
+    memcpy(&page[1], &snapshot, sizeof(snapshot));
+    TEST_ASSERT_NULL(PIDFSnapshot::find(&page[1], sizeof(snapshot)));
+
+    // every single bit error is detected
+    for (size_t ii = 0; ii < sizeof(snapshot)*8; ++ii) {
+        memcpy(&page[0], &snapshot, sizeof(snapshot));
+        page[ii / 8] ^= static_cast<uint8_t>(1U << (ii % 8));
+        TEST_ASSERT_NULL(PIDFSnapshot::find(&page[0], sizeof(snapshot)));
+    }
+
+    // a snapshot of another version is rejected, even with a correct CRC
+    PIDFSnapshot::snapshot_t other = snapshot;
+    other.version = PIDFSnapshot::VERSION + 1;
+    other.crc = PIDFSnapshot::calculateCrc(other);
+    TEST_ASSERT_FALSE(PIDFSnapshot::isValid(other));
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_crc32);
+    RUN_TEST(test_capture_restore);
+    RUN_TEST(test_find);
+
+    UNITY_END();
+}
@@ -0,0 +1,648 @@
+#include <PIDF.h>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static uint32_t seed = 54321;
+static float randomFloat(float range)
+{
+    seed = seed*1664525U + 1013904223U;
+    return range*(static_cast<float>(seed >> 8U)/8388608.0F - 1.0F);
+}
+
+template <uint32_t TERMS>
+static void compareWithPIDF(const PIDF::PIDF_t& gains)
+{
+    PIDFT<TERMS> pidT(gains);
+    // PIDF with the gains of unselected terms set to zero
+    PIDF pid(pidT.getPID());
+    if constexpr (PIDFT<TERMS>::HAS_INTEGRAL_LIMIT) {
+        pidT.setIntegralLimit(0.5F);
+        pid.setIntegralLimit(0.5F);
+    }
+    if constexpr (PIDFT<TERMS>::HAS_INTEGRAL_THRESHOLD) {
+        pidT.setIntegralThreshold(0.1F);
+        pid.setIntegralThreshold(0.1F);
+    }
+    if constexpr (PIDFT<TERMS>::HAS_OUTPUT_SATURATION) {
+        pidT.setOutputSaturationValue(1.0F);
+        pid.setOutputSaturationValue(1.0F);
+    }
+    const float deltaT = 0.01F;
+    float measurement = 0.0F;
+    for (int ii = 0; ii < 1000; ++ii) {
+        if (ii % 100 == 0) {
+            const float setpoint = randomFloat(2.0F);
+            pidT.setSetpoint(setpoint, deltaT);
+            pid.setSetpoint(setpoint, deltaT);
+        }
+        measurement += randomFloat(0.1F);
+        TEST_ASSERT_EQUAL_FLOAT(pid.update(measurement, deltaT), pidT.update(measurement, deltaT));
+        const PIDF::error_t error = pid.getError();
+        const PIDF::error_t errorT = pidT.getError();
+        TEST_ASSERT_EQUAL_FLOAT(error.P, errorT.P);
+        TEST_ASSERT_EQUAL_FLOAT(error.I, errorT.I);
+        TEST_ASSERT_EQUAL_FLOAT(error.D, errorT.D);
+        TEST_ASSERT_EQUAL_FLOAT(error.S, errorT.S);
+        TEST_ASSERT_EQUAL_FLOAT(error.K, errorT.K);
+    }
+}
+
+void test_PIDFT_size()
+{
+#if !defined(USE_PIDF_ERROR_SNAPSHOT) && !defined(USE_PIDF_RECORDER) && !defined(USE_PIDF_INCREMENTAL)
+    TEST_ASSERT_EQUAL(80, sizeof(PIDF));
+    TEST_ASSERT_EQUAL(80, sizeof(PIDFT<PIDFTerms::ALL>));
+    TEST_ASSERT_EQUAL(68, sizeof(PIDFT<PIDFTerms::ALL & ~PIDFTerms::FIXED_RATE>));
+#endif
+    TEST_ASSERT_EQUAL(5*sizeof(float), sizeof(PIDFT<PIDFTerms::P>));
+    TEST_ASSERT_EQUAL(8*sizeof(float), sizeof(PIDFT<PIDFTerms::PI>));
+    TEST_ASSERT_EQUAL(10*sizeof(float), sizeof(PIDFT<PIDFTerms::PI | PIDFTerms::K>));
+    TEST_ASSERT_EQUAL(7*sizeof(float), sizeof(PIDFT<PIDFTerms::PD>));
+    // the incremental form needs extra state only for the S and K terms
+    TEST_ASSERT_EQUAL(8*sizeof(float), sizeof(PIDFT<PIDFTerms::PI | PIDFTerms::INCREMENTAL>));
+    TEST_ASSERT_EQUAL(11*sizeof(float), sizeof(PIDFT<PIDFTerms::PI | PIDFTerms::K | PIDFTerms::INCREMENTAL>));
+}
+
+void test_PIDFT_getters()
+{
+    const PIDFT<PIDFTerms::PI | PIDFTerms::K> pid({ 1.0F, 2.0F, 3.0F, 4.0F, 5.0F });
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, pid.getP());
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, pid.getI());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.getD());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.getS());
+    TEST_ASSERT_EQUAL_FLOAT(5.0F, pid.getK());
+    const PIDF::error_t error = pid.getError();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, error.D);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, error.S);
+}
+
+void test_PIDFT_P()
+{
+    PIDFT<PIDFTerms::P> pid({ 1.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    pid.setSetpoint(5.0F);
+    TEST_ASSERT_EQUAL_FLOAT(5.0F, pid.update(0.0F, 1.0F));
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, pid.update(1.0F, 1.0F));
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, pid.getErrorP());
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, pid.getPreviousMeasurement());
+}
+
+void test_PIDFT_matches_PIDF()
+{
+    const PIDF::PIDF_t gains { 0.8F, 0.6F, 0.02F, 0.3F, 0.05F };
+    compareWithPIDF<PIDFTerms::P>(gains);
+    compareWithPIDF<PIDFTerms::PI>(gains);
+    compareWithPIDF<PIDFTerms::PD>(gains);
+    compareWithPIDF<PIDFTerms::PID>(gains);
+    compareWithPIDF<PIDFTerms::PI | PIDFTerms::K>(gains);
+    compareWithPIDF<PIDFTerms::PD | PIDFTerms::K>(gains);
+    compareWithPIDF<PIDFTerms::S | PIDFTerms::K>(gains);
+    compareWithPIDF<PIDFTerms::PI | PIDFTerms::INTEGRAL_LIMIT>(gains);
+    compareWithPIDF<PIDFTerms::PI | PIDFTerms::OUTPUT_SATURATION>(gains);
+    compareWithPIDF<PIDFTerms::PID | PIDFTerms::INTEGRAL_THRESHOLD>(gains);
+    compareWithPIDF<PIDFTerms::ALL>(gains);
+}
+
+void test_PIDF_optimized_updates()
+{
+    // the optimized updates give the same output as the full update with the unused gains set to zero
+    PIDF pid({ 0.8F, 0.6F, 0.02F, 0.3F, 0.05F });
+    PIDF pidSPI({ 0.8F, 0.6F, 0.0F, 0.3F, 0.0F });
+    PIDF pidSPD({ 0.8F, 0.0F, 0.02F, 0.3F, 0.0F });
+    pid.setSetpoint(1.0F);
+    pidSPI.setSetpoint(1.0F);
+    pidSPD.setSetpoint(1.0F);
+    const float deltaT = 0.01F;
+    float measurement = 0.0F;
+    for (int ii = 0; ii < 100; ++ii) {
+        const float delta = randomFloat(0.1F);
+        measurement += delta;
+        TEST_ASSERT_EQUAL_FLOAT(pidSPI.updateDelta(measurement, delta, deltaT), pid.updateSPI(measurement, deltaT));
+        TEST_ASSERT_EQUAL_FLOAT(pidSPD.updateDelta(measurement, delta, deltaT), pid.updateSPD(measurement, delta, deltaT));
+    }
+}
+void test_PIDFT_sample_time_invalid()
+{
+    // a sample time that is not positive is ignored, so the fixed-rate coefficients stay finite
+    PIDFT<PIDFTerms::PID | PIDFTerms::FIXED_RATE> pid({ 1.0F, 2.0F, 0.1F, 0.0F, 0.0F });
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.getSampleTime());
+    pid.setSampleTime(0.01F);
+    pid.setSampleTime(0.0F);
+    TEST_ASSERT_EQUAL_FLOAT(0.01F, pid.getSampleTime());
+    pid.setSampleTime(-0.01F);
+    TEST_ASSERT_EQUAL_FLOAT(0.01F, pid.getSampleTime());
+    pid.setSampleTime(std::numeric_limits<float>::quiet_NaN());
+    TEST_ASSERT_EQUAL_FLOAT(0.01F, pid.getSampleTime());
+
+    PIDFT<PIDFTerms::PID | PIDFTerms::FIXED_RATE> pidExpected({ 1.0F, 2.0F, 0.1F, 0.0F, 0.0F });
+    pidExpected.setSampleTime(0.01F);
+    pid.setSetpoint(1.0F);
+    pidExpected.setSetpoint(1.0F);
+    for (int ii = 0; ii < 10; ++ii) {
+        const float measurement = 0.1F*static_cast<float>(ii);
+        const float output = pid.update(measurement);
+        TEST_ASSERT_TRUE(std::isfinite(output));
+        TEST_ASSERT_EQUAL_FLOAT(pidExpected.update(measurement), output);
+    }
+}
+void test_PIDFT_incremental()
+{
+    // with constant gains and no integral limits, the sum of the increments is the positional output
+    constexpr uint32_t TERMS = PIDFTerms::PID | PIDFTerms::S | PIDFTerms::K | PIDFTerms::INTEGRAL_THRESHOLD | PIDFTerms::FIXED_RATE;
+    const PIDF::PIDF_t gains { 0.8F, 0.6F, 0.02F, 0.3F, 0.05F };
+    PIDFT<TERMS> pid(gains);
+    PIDFT<TERMS | PIDFTerms::INCREMENTAL> pidIncremental(gains);
+    PIDFT<TERMS | PIDFTerms::INCREMENTAL> pidFixedRate(gains);
+    const float deltaT = 0.01F;
+    pidFixedRate.setSampleTime(deltaT);
+    pid.setIntegralThreshold(0.05F);
+    pidIncremental.setIntegralThreshold(0.05F);
+    pidFixedRate.setIntegralThreshold(0.05F);
+    float measurement = 0.0F;
+    float output = 0.0F;
+    for (int ii = 0; ii < 1000; ++ii) {
+        if (ii % 100 == 0) {
+            const float setpoint = randomFloat(2.0F);
+            pid.setSetpoint(setpoint, deltaT);
+            pidIncremental.setSetpoint(setpoint, deltaT);
+            pidFixedRate.setSetpoint(setpoint, deltaT);
+        }
+        measurement += randomFloat(0.1F);
+        const float outputDelta = pidIncremental.updateIncremental(measurement, deltaT);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, outputDelta, pidFixedRate.updateIncremental(measurement));
+        output += outputDelta;
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-4F, pid.update(measurement, deltaT), output);
+        // the error getters report the same per-term contributions as the positional form
+        const PIDF::error_t error = pid.getError();
+        const PIDF::error_t errorIncremental = pidIncremental.getError();
+        TEST_ASSERT_EQUAL_FLOAT(error.P, errorIncremental.P);
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, error.I, errorIncremental.I);
+        TEST_ASSERT_EQUAL_FLOAT(error.D, errorIncremental.D);
+        TEST_ASSERT_EQUAL_FLOAT(error.S, errorIncremental.S);
+        TEST_ASSERT_EQUAL_FLOAT(error.K, errorIncremental.K);
+    }
+}
+
+void test_PIDFT_incremental_bumpless()
+{
+    // changing the gains causes a jump in the positional output, but not in the incremental output
+    PIDFT<PIDFTerms::PI | PIDFTerms::S> pid({ 1.0F, 0.5F, 0.0F, 0.2F, 0.0F });
+    PIDFT<PIDFTerms::PI | PIDFTerms::S | PIDFTerms::INCREMENTAL> pidIncremental({ 1.0F, 0.5F, 0.0F, 0.2F, 0.0F });
+    pid.setSetpoint(1.0F);
+    pidIncremental.setSetpoint(1.0F);
+    const float deltaT = 0.01F;
+    for (int ii = 0; ii < 10; ++ii) {
+        pid.update(0.5F, deltaT);
+        pidIncremental.updateIncremental(0.5F, deltaT);
+    }
+    const float positional = pid.update(0.5F, deltaT);
+    pidIncremental.updateIncremental(0.5F, deltaT);
+    pid.setPID({ 3.0F, 0.5F, 0.0F, 0.6F, 0.0F });
+    pidIncremental.setPID({ 3.0F, 0.5F, 0.0F, 0.6F, 0.0F });
+    // the error is unchanged, so the only change in output is the integral increment
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, 0.5F*0.5F*deltaT, pidIncremental.updateIncremental(0.5F, deltaT));
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, 0.5F*2.0F + 0.2F*2.0F + 0.5F*0.5F*deltaT, pid.update(0.5F, deltaT) - positional);
+
+    // switching integration off stops the integral increments
+    pidIncremental.switchIntegrationOff();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pidIncremental.updateIncremental(0.5F, deltaT));
+}
+static bool bitEqual(float a, float b)
+{
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+void test_PIDFT_anti_windup_bit_compatible()
+{
+    // the branch-free integral limit and output saturation give the same results as the original nested if-else.
+    // They are bit-identical when compiled without floating point contraction, but the compiler may fuse the multiply-adds
+    // differently in the two versions (eg with -march=native, or by default on AArch64), so allow a few ULP of the terms
+    // (which are of order 1) difference, and resynchronize the reference integral each step so differences do not accumulate.
+    const float tolerance = 4.0F*FLT_EPSILON;
+    PIDF pid({ 0.8F, 5.0F, 0.0F, 0.3F, 0.0F });
+    pid.setIntegralLimit(0.3F);
+    pid.setOutputSaturationValue(0.5F);
+    const float kp = 0.8F;
+    const float ki = 5.0F;
+    const float ks = 0.3F;
+    float errorIntegral = 0.0F;
+    const float deltaT = 0.01F;
+    float measurement = 0.0F;
+    float setpoint = 0.0F;
+    for (int ii = 0; ii < 2000; ++ii) {
+        if (ii % 50 == 0) {
+            setpoint = randomFloat(1.0F);
+            pid.setSetpoint(setpoint);
+        }
+        measurement += randomFloat(0.1F);
+        const float error = setpoint - measurement;
+        const float partialSum = -0.0F + kp*error + ks*setpoint;
+        errorIntegral += ki*error*deltaT;
+        if (errorIntegral > 0.3F) {
+            errorIntegral = 0.3F;
+        } else if (errorIntegral < -0.3F) {
+            errorIntegral = -0.3F;
+        }
+        if (errorIntegral > 0.5F - partialSum) {
+            errorIntegral = std::fmax(0.5F - partialSum, 0.0F);
+        } else if (errorIntegral < -0.5F - partialSum) {
+            errorIntegral = std::fmin(-0.5F - partialSum, 0.0F);
+        }
+        const float output = pid.updateDelta(measurement, 0.0F, deltaT);
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, partialSum + errorIntegral, output);
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, errorIntegral, pid.getErrorI());
+        errorIntegral = pid.getErrorI();
+    }
+}
+
+void test_PIDFT_back_calculation()
+{
+    using PIDF_BC = PIDFT<PIDFTerms::PI | PIDFTerms::OUTPUT_SATURATION | PIDFTerms::BACK_CALCULATION | PIDFTerms::FIXED_RATE>;
+    const float deltaT = 0.01F;
+    PIDF_BC pid({ 1.0F, 2.0F, 0.0F, 0.0F, 0.0F });
+    pid.setSampleTime(deltaT);
+    pid.setOutputSaturationValue(1.0F);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pid.getTrackingGain());
+
+    // with a tracking gain of zero, the integral is limited on output saturation
+    PIDFT<PIDFTerms::PI | PIDFTerms::OUTPUT_SATURATION> pidClamped({ 1.0F, 2.0F, 0.0F, 0.0F, 0.0F });
+    pidClamped.setOutputSaturationValue(1.0F);
+    pid.setSetpoint(0.8F);
+    pidClamped.setSetpoint(0.8F);
+    for (int ii = 0; ii < 100; ++ii) {
+        TEST_ASSERT_TRUE(bitEqual(pidClamped.update(0.0F, deltaT), pid.update(0.0F, deltaT)));
+    }
+
+    // with a tracking gain, the integral is pulled back by trackingGain*(saturated - output)*deltaT
+    pid.resetAll();
+    pid.setTrackingGain(10.0F);
+    TEST_ASSERT_EQUAL_FLOAT(10.0F, pid.getTrackingGain());
+    pid.setSetpoint(0.8F);
+    float integral = 0.0F;
+    for (int ii = 0; ii < 100; ++ii) {
+        const float output = pid.update(0.0F);
+        integral += 2.0F*0.8F*deltaT;
+        const float unsaturated = 0.8F + integral;
+        if (unsaturated > 1.0F) {
+            integral += 10.0F*deltaT*(1.0F - unsaturated);
+        }
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, integral, pid.getErrorI());
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, 0.8F + integral, output);
+    }
+    // the integral settles where the integration balances the tracking: ki*error = trackingGain*(output - saturation)
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 0.2F + 2.0F*0.8F/10.0F - 2.0F*0.8F*deltaT, pid.getErrorI());
+
+    // the variable-rate update gives the same result as the fixed-rate update
+    PIDF_BC pidVariable({ 1.0F, 2.0F, 0.0F, 0.0F, 0.0F });
+    pidVariable.setOutputSaturationValue(1.0F);
+    pidVariable.setTrackingGain(10.0F);
+    pidVariable.setSetpoint(0.8F);
+    pid.resetAll();
+    pid.setSetpoint(0.8F);
+    for (int ii = 0; ii < 100; ++ii) {
+        TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, pid.update(0.0F), pidVariable.update(0.0F, deltaT));
+    }
+}
+void test_PIDF_double()
+{
+    // double holds the small integral increments that float loses, so double integrates a small residual error
+    PIDF pidF({ 0.0F, 1.0F, 0.0F, 0.0F, 0.0F });
+    PIDFDouble pidD({ 0.0, 1.0, 0.0, 0.0, 0.0 });
+    pidF.setSampleTime(0.001F);
+    pidD.setSampleTime(0.001);
+    pidF.setSetpoint(1.0F);
+    pidD.setSetpoint(1.0);
+    for (int ii = 0; ii < 1000; ++ii) {
+        pidF.update(0.0F);
+        pidD.update(0.0);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 1.0F, pidF.getErrorI());
+    TEST_ASSERT_TRUE(std::fabs(pidD.getErrorI() - 1.0) < 1.0e-12);
+    const float integralF = pidF.getErrorI();
+    for (int ii = 0; ii < 100000; ++ii) {
+        // increment is 1e-8, less than half the spacing of floats near 1
+        pidF.update(1.0F - 1.0e-5F);
+        pidD.update(1.0 - 1.0e-5);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(integralF, pidF.getErrorI());
+    TEST_ASSERT_TRUE(std::fabs(pidD.getErrorI() - 1.001) < 1.0e-9);
+    TEST_ASSERT_TRUE(std::fabs(pidD.updateSPI(1.0 - 1.0e-5) - (1.001 + 1.0e-8)) < 1.0e-9);
+}
+
+// minimal numeric wrapper, standing in for a user-defined type such as a fixed-point class
+struct Scalar {
+    double value;
+    Scalar() = default;
+    constexpr explicit Scalar(int v) : value(v) {}
+    constexpr explicit Scalar(double v) : value(v) {}
+    explicit operator float() const { return static_cast<float>(value); }
+};
+static Scalar operator+(Scalar a, Scalar b) { return Scalar(a.value + b.value); }
+static Scalar operator-(Scalar a, Scalar b) { return Scalar(a.value - b.value); }
+static Scalar operator*(Scalar a, Scalar b) { return Scalar(a.value * b.value); }
+static Scalar operator/(Scalar a, Scalar b) { return Scalar(a.value / b.value); }
+static Scalar operator-(Scalar a) { return Scalar(-a.value); }
+static Scalar& operator+=(Scalar& a, Scalar b) { a.value += b.value; return a; }
+static bool operator<(Scalar a, Scalar b) { return a.value < b.value; }
+static bool operator>(Scalar a, Scalar b) { return a.value > b.value; }
+static bool operator>=(Scalar a, Scalar b) { return a.value >= b.value; }
+static bool operator==(Scalar a, Scalar b) { return a.value == b.value; }
+static bool operator!=(Scalar a, Scalar b) { return a.value != b.value; }
+
+void test_PIDFT_custom_type()
+{
+    // the generic math functions give the same results as the double overloads
+    PIDFT<PIDFTerms::ALL, Scalar> pidS({ Scalar(0.3), Scalar(0.2), Scalar(0.001), Scalar(0.05), Scalar(0.01) });
+    PIDFDouble pidD({ 0.3, 0.2, 0.001, 0.05, 0.01 });
+    pidS.setSampleTime(Scalar(0.01));
+    pidD.setSampleTime(0.01);
+    pidS.setIntegralLimit(Scalar(0.1));
+    pidD.setIntegralLimit(0.1);
+    pidS.setIntegralThreshold(Scalar(0.02));
+    pidD.setIntegralThreshold(0.02);
+    pidS.setOutputSaturationValue(Scalar(0.5));
+    pidD.setOutputSaturationValue(0.5);
+    seed = 54321;
+    for (int ii = 0; ii < 1000; ++ii) {
+        if (ii == 500) {
+            pidS.switchIntegrationOff();
+            pidD.switchIntegrationOff();
+            TEST_ASSERT_FALSE(pidS.isIntegrationOn());
+            TEST_ASSERT_EQUAL_FLOAT(0.2F, static_cast<float>(pidS.getI()));
+        }
+        if (ii == 700) {
+            pidS.switchIntegrationOn();
+            pidD.switchIntegrationOn();
+            TEST_ASSERT_TRUE(pidS.isIntegrationOn());
+        }
+        const double setpoint = static_cast<double>(randomFloat(1.0F));
+        const double measurement = static_cast<double>(randomFloat(1.0F));
+        pidS.setSetpoint(Scalar(setpoint), Scalar(0.01));
+        pidD.setSetpoint(setpoint, 0.01);
+        const Scalar outputS = (ii % 2 == 0) ? pidS.update(Scalar(measurement)) : pidS.update(Scalar(measurement), Scalar(0.01));
+        const double outputD = (ii % 2 == 0) ? pidD.update(measurement) : pidD.update(measurement, 0.01);
+        TEST_ASSERT_TRUE(outputS.value == outputD);
+        TEST_ASSERT_TRUE(pidS.getErrorI().value == pidD.getErrorI());
+    }
+}
+
+void test_PIDFT_float16()
+{
+#if defined(__FLT16_MAX__)
+    using F16 = _Float16;
+    PIDFT<PIDFTerms::PI | PIDFTerms::INTEGRAL_LIMIT | PIDFTerms::FIXED_RATE, F16> pid16({ F16(1), F16(2), F16(0), F16(0), F16(0) });
+    PIDFT<PIDFTerms::PI | PIDFTerms::INTEGRAL_LIMIT | PIDFTerms::FIXED_RATE> pid({ 1.0F, 2.0F, 0.0F, 0.0F, 0.0F });
+    pid16.setSampleTime(static_cast<F16>(0.0625F));
+    pid.setSampleTime(0.0625F);
+    pid16.setIntegralLimit(static_cast<F16>(0.5F));
+    pid.setIntegralLimit(0.5F);
+    pid16.setSetpoint(static_cast<F16>(0.25F));
+    pid.setSetpoint(0.25F);
+    for (int ii = 0; ii < 20; ++ii) {
+        const float measurement = 0.01F*static_cast<float>(ii);
+        const float output16 = static_cast<float>(pid16.update(static_cast<F16>(measurement)));
+        TEST_ASSERT_FLOAT_WITHIN(0.002F, pid.update(measurement), output16);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.002F, pid.getErrorI(), static_cast<float>(pid16.getErrorI()));
+    for (int ii = 0; ii < 20; ++ii) {
+        pid16.update(F16(0));
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, static_cast<float>(pid16.getErrorI()));
+#endif
+}
+enum block_e { BLOCK, BLOCK_DELTA, BLOCK_DELTA_ITERM };
+
+// runs pidBlock over the samples with a block update, and pidScalar with the scalar update, and checks they give identical results
+template <typename PID, block_e BLOCK_TYPE, bool FIXED_RATE>
+static void compareBlock(PID& pidBlock, PID& pidScalar, size_t count, bool withSetpoints)
+{
+    using T = typename PID::value_type;
+    const T deltaT = T(0.01F);
+    std::vector<T> measurements(count);
+    std::vector<T> measurementDeltas(count);
+    std::vector<T> iTermErrors(count);
+    std::vector<T> setpoints(count);
+    T measurement = pidScalar.getPreviousMeasurement();
+    T setpoint = pidScalar.getSetpoint();
+    for (size_t ii = 0; ii < count; ++ii) {
+        if (ii % 37 == 0) {
+            setpoint = T(randomFloat(2.0F));
+        }
+        const T previous = measurement;
+        measurement += T(randomFloat(0.2F));
+        measurements[ii] = measurement;
+        measurementDeltas[ii] = T(0.5F)*(measurement - previous); // filtered delta
+        iTermErrors[ii] = T(0.8F)*(setpoint - measurement); // attenuated error
+        setpoints[ii] = setpoint;
+    }
+    std::vector<T> outputs(count);
+    const T* sp = withSetpoints ? setpoints.data() : nullptr;
+    if constexpr (FIXED_RATE) {
+        if constexpr (BLOCK_TYPE == BLOCK) { pidBlock.updateBlock(measurements.data(), sp, outputs.data(), count); }
+        if constexpr (BLOCK_TYPE == BLOCK_DELTA) { pidBlock.updateDeltaBlock(measurements.data(), measurementDeltas.data(), sp, outputs.data(), count); }
+        if constexpr (BLOCK_TYPE == BLOCK_DELTA_ITERM) { pidBlock.updateDeltaITermBlock(measurements.data(), measurementDeltas.data(), iTermErrors.data(), sp, outputs.data(), count); }
+    } else {
+        if constexpr (BLOCK_TYPE == BLOCK) { pidBlock.updateBlock(measurements.data(), sp, deltaT, outputs.data(), count); }
+        if constexpr (BLOCK_TYPE == BLOCK_DELTA) { pidBlock.updateDeltaBlock(measurements.data(), measurementDeltas.data(), sp, deltaT, outputs.data(), count); }
+        if constexpr (BLOCK_TYPE == BLOCK_DELTA_ITERM) { pidBlock.updateDeltaITermBlock(measurements.data(), measurementDeltas.data(), iTermErrors.data(), sp, deltaT, outputs.data(), count); }
+    }
+    for (size_t ii = 0; ii < count; ++ii) {
+        if (withSetpoints) {
+            pidScalar.setSetpoint(setpoints[ii]);
+        }
+        T output {};
+        if constexpr (FIXED_RATE) {
+            if constexpr (BLOCK_TYPE == BLOCK) { output = pidScalar.update(measurements[ii]); }
+            if constexpr (BLOCK_TYPE == BLOCK_DELTA) { output = pidScalar.updateDelta(measurements[ii], measurementDeltas[ii]); }
+            if constexpr (BLOCK_TYPE == BLOCK_DELTA_ITERM) { output = pidScalar.updateDeltaITerm(measurements[ii], measurementDeltas[ii], iTermErrors[ii]); }
+        } else {
+            if constexpr (BLOCK_TYPE == BLOCK) { output = pidScalar.update(measurements[ii], deltaT); }
+            if constexpr (BLOCK_TYPE == BLOCK_DELTA) { output = pidScalar.updateDelta(measurements[ii], measurementDeltas[ii], deltaT); }
+            if constexpr (BLOCK_TYPE == BLOCK_DELTA_ITERM) { output = pidScalar.updateDeltaITerm(measurements[ii], measurementDeltas[ii], iTermErrors[ii], deltaT); }
+        }
+        TEST_ASSERT_TRUE(bitEqual(static_cast<float>(output), static_cast<float>(outputs[ii])));
+    }
+    // the same final state
+    const auto error = pidScalar.getErrorRaw();
+    const auto errorBlock = pidBlock.getErrorRaw();
+    TEST_ASSERT_TRUE(bitEqual(static_cast<float>(error.P), static_cast<float>(errorBlock.P)));
+    TEST_ASSERT_TRUE(bitEqual(static_cast<float>(error.I), static_cast<float>(errorBlock.I)));
+    TEST_ASSERT_TRUE(bitEqual(static_cast<float>(error.D), static_cast<float>(errorBlock.D)));
+    TEST_ASSERT_TRUE(bitEqual(static_cast<float>(error.S), static_cast<float>(errorBlock.S)));
+    TEST_ASSERT_TRUE(bitEqual(static_cast<float>(error.K), static_cast<float>(errorBlock.K)));
+    TEST_ASSERT_TRUE(pidScalar.getPreviousMeasurement() == pidBlock.getPreviousMeasurement());
+    TEST_ASSERT_TRUE(pidScalar.getSetpoint() == pidBlock.getSetpoint());
+    TEST_ASSERT_TRUE(pidScalar.getPreviousSetpoint() == pidBlock.getPreviousSetpoint());
+}
+
+template <typename PID>
+static void compareBlocks(const PID& pid)
+{
+    PID pidBlock = pid;
+    PID pidScalar = pid;
+    // block sizes that are not a multiple of the internal block size, and carrying the state between calls
+    for (const size_t count : { 0, 1, 31, 32, 33, 100, 1000 }) {
+        compareBlock<PID, BLOCK, false>(pidBlock, pidScalar, count, true);
+        compareBlock<PID, BLOCK_DELTA, false>(pidBlock, pidScalar, count, true);
+        compareBlock<PID, BLOCK_DELTA_ITERM, false>(pidBlock, pidScalar, count, false);
+        compareBlock<PID, BLOCK, false>(pidBlock, pidScalar, count, false);
+        if constexpr (PID::HAS_FIXED_RATE) {
+            compareBlock<PID, BLOCK, true>(pidBlock, pidScalar, count, true);
+            compareBlock<PID, BLOCK_DELTA, true>(pidBlock, pidScalar, count, false);
+            compareBlock<PID, BLOCK_DELTA_ITERM, true>(pidBlock, pidScalar, count, true);
+        }
+    }
+}
+
+void test_PIDFT_block()
+{
+    PIDF pid({ 1.2F, 8.0F, 0.02F, 0.3F, 0.01F });
+    pid.setSampleTime(0.01F);
+    compareBlocks(pid);
+    pid.setIntegralLimit(0.4F);
+    pid.setIntegralThreshold(0.05F);
+    pid.setOutputSaturationValue(1.5F);
+    pid.setSetpoint(0.5F, 0.01F); // non-zero setpoint derivative, which is held over the block
+    compareBlocks(pid);
+
+    // without setpoints, the previous setpoint is left unchanged
+    PIDF pidBlock = pid;
+    PIDF pidScalar = pid;
+    pidBlock.setSetpoint(0.2F);
+    pidScalar.setSetpoint(0.2F);
+    compareBlock<PIDF, BLOCK, false>(pidBlock, pidScalar, 10, false);
+    TEST_ASSERT_TRUE(pidBlock.getPreviousSetpoint() != pidBlock.getSetpoint());
+
+    compareBlocks(PIDFT<PIDFTerms::PI>({ 1.0F, 5.0F, 0.0F, 0.0F, 0.0F }));
+    compareBlocks(PIDFT<PIDFTerms::PD | PIDFTerms::S>({ 1.0F, 0.0F, 0.05F, 0.2F, 0.0F }));
+    PIDFT<PIDFTerms::PID | PIDFTerms::OUTPUT_SATURATION | PIDFTerms::BACK_CALCULATION | PIDFTerms::FIXED_RATE> pidBC({ 2.0F, 10.0F, 0.01F, 0.0F, 0.0F });
+    pidBC.setSampleTime(0.01F);
+    pidBC.setOutputSaturationValue(0.8F);
+    pidBC.setTrackingGain(20.0F);
+    compareBlocks(pidBC);
+    // with an error snapshot the scalar updates are used, so the snapshot is published for each sample
+    PIDFT<PIDFTerms::PID | PIDFTerms::ERROR_SNAPSHOT> pidSnapshot({ 1.0F, 5.0F, 0.01F, 0.0F, 0.0F });
+    compareBlocks(pidSnapshot);
+    PIDFDouble pidDouble({ 1.2, 8.0, 0.02, 0.3, 0.01 });
+    pidDouble.setSampleTime(0.01);
+    pidDouble.setOutputSaturationValue(1.5);
+    compareBlocks(pidDouble);
+    compareBlocks(PIDFT<PIDFTerms::ALL | PIDFTerms::FLUSH_DENORMALS>({ 1.2F, 8.0F, 0.02F, 0.3F, 0.01F }));
+}
+
+void test_PIDFT_block_snapshot()
+{
+    PIDFT<PIDFTerms::PID | PIDFTerms::ERROR_SNAPSHOT> pid({ 1.0F, 5.0F, 0.01F, 0.0F, 0.0F });
+    pid.setSetpoint(1.0F);
+    const std::array<float, 3> measurements { 0.1F, 0.2F, 0.3F };
+    std::array<float, 3> outputs {};
+    pid.updateBlock(measurements.data(), nullptr, 0.01F, outputs.data(), outputs.size());
+    TEST_ASSERT_EQUAL_FLOAT(pid.getErrorP(), pid.getErrorSnapshot().P);
+    TEST_ASSERT_EQUAL_FLOAT(0.7F, pid.getErrorSnapshot().P);
+}
+void test_PIDFT_block_span()
+{
+#if defined(__cpp_lib_span)
+    PIDF pid({ 1.0F, 5.0F, 0.01F, 0.0F, 0.0F });
+    PIDF pidScalar({ 1.0F, 5.0F, 0.01F, 0.0F, 0.0F });
+    const std::array<float, 4> measurements { 0.1F, 0.2F, 0.3F, 0.35F };
+    const std::array<float, 4> setpoints { 1.0F, 1.0F, 0.5F, 0.5F };
+    std::array<float, 4> outputs {};
+    pid.updateBlock(measurements, setpoints, 0.01F, outputs);
+    for (size_t ii = 0; ii < outputs.size(); ++ii) {
+        pidScalar.setSetpoint(setpoints[ii]);
+        TEST_ASSERT_TRUE(bitEqual(pidScalar.update(measurements[ii], 0.01F), outputs[ii]));
+    }
+    pid.updateBlock(measurements, {}, 0.01F, outputs); // no setpoints, so the setpoint is unchanged
+    TEST_ASSERT_EQUAL_FLOAT(0.5F, pid.getSetpoint());
+#endif
+}
+
+void test_PIDFT_flush_denormals()
+{
+    // values below the threshold are flushed to zero, keeping their sign
+    TEST_ASSERT_TRUE(bitEqual(0x1p-62F, pidfFlushTiny(0x1p-62F)));
+    TEST_ASSERT_TRUE(bitEqual(-0x1p-62F, pidfFlushTiny(-0x1p-62F)));
+    TEST_ASSERT_TRUE(bitEqual(0.0F, pidfFlushTiny(0x1p-63F)));
+    TEST_ASSERT_TRUE(bitEqual(-0.0F, pidfFlushTiny(-1.0e-40F)));
+    TEST_ASSERT_TRUE(bitEqual(1.0F, pidfFlushTiny(1.0F)));
+    TEST_ASSERT_TRUE(pidfFlushTiny(0x1p-510) == 0x1p-510);
+    TEST_ASSERT_TRUE(pidfFlushTiny(0x1p-511) == 0.0);
+    TEST_ASSERT_TRUE(pidfFlushTiny(1.0e-40) == 1.0e-40); // small for a float, but not for a double
+
+    using PIDFFlush = PIDFT<PIDFTerms::ALL | PIDFTerms::FLUSH_DENORMALS>;
+    static_assert(PIDFFlush::HAS_FLUSH_DENORMALS);
+
+    // on normal values the flushing controller gives identical results
+    PIDF pid({ 1.2F, 8.0F, 0.02F, 0.3F, 0.01F });
+    PIDFFlush pidFlush({ 1.2F, 8.0F, 0.02F, 0.3F, 0.01F });
+    pid.setSetpoint(0.5F);
+    pidFlush.setSetpoint(0.5F);
+    float measurement = 0.0F;
+    for (int ii = 0; ii < 200; ++ii) {
+        measurement += randomFloat(0.1F);
+        TEST_ASSERT_TRUE(bitEqual(pid.update(measurement, 0.01F), pidFlush.update(measurement, 0.01F)));
+    }
+
+    // an oscillation decaying through the subnormal range: without flushing the state becomes subnormal, with flushing it does not
+    const PIDF::PIDF_t gains { 0.5F, 2.0F, 0.01F, 0.0F, 0.0F };
+    PIDFT<PIDFTerms::PID> pidDecay(gains);
+    PIDFFlush pidDecayFlush(gains);
+    PIDFT<PIDFTerms::PID | PIDFTerms::INCREMENTAL | PIDFTerms::FLUSH_DENORMALS> pidIncremental(gains);
+    const auto isTiny = [](float x) { return x != 0.0F && std::fabs(x) < 0x1p-62F; };
+    bool subnormal = false;
+    float amplitude = 1.0e-36F;
+    for (int ii = 0; ii < 4000; ++ii) {
+        const float m = amplitude*std::cos(0.05F*static_cast<float>(ii));
+        amplitude *= 0.99856F;
+        pidDecay.update(m, 1.0F/8000.0F);
+        subnormal = subnormal || std::fpclassify(pidDecay.getErrorRawD()) == FP_SUBNORMAL;
+        const float output = pidDecayFlush.update(m, 1.0F/8000.0F);
+        TEST_ASSERT_FALSE(isTiny(output));
+        TEST_ASSERT_FALSE(isTiny(pidDecayFlush.getErrorRawD()));
+        TEST_ASSERT_FALSE(isTiny(pidDecayFlush.getErrorRawI()));
+        TEST_ASSERT_FALSE(isTiny(pidDecayFlush.getPreviousMeasurement()));
+        const float outputIncremental = pidIncremental.updateIncremental(m, 1.0F/8000.0F);
+        TEST_ASSERT_FALSE(isTiny(outputIncremental));
+        TEST_ASSERT_FALSE(isTiny(pidIncremental.getErrorRawD()));
+    }
+    TEST_ASSERT_TRUE(subnormal);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pidDecayFlush.getErrorRawD());
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, pidDecayFlush.getErrorRawI());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_PIDFT_size);
+    RUN_TEST(test_PIDFT_getters);
+    RUN_TEST(test_PIDFT_P);
+    RUN_TEST(test_PIDFT_matches_PIDF);
+    RUN_TEST(test_PIDF_optimized_updates);
+    RUN_TEST(test_PIDFT_sample_time_invalid);
+    RUN_TEST(test_PIDFT_incremental);
+    RUN_TEST(test_PIDFT_incremental_bumpless);
+    RUN_TEST(test_PIDFT_anti_windup_bit_compatible);
+    RUN_TEST(test_PIDFT_back_calculation);
+    RUN_TEST(test_PIDF_double);
+    RUN_TEST(test_PIDFT_custom_type);
+    RUN_TEST(test_PIDFT_float16);
+    RUN_TEST(test_PIDFT_block);
+    RUN_TEST(test_PIDFT_block_snapshot);
+    RUN_TEST(test_PIDFT_block_span);
+    RUN_TEST(test_PIDFT_flush_denormals);
+
+    UNITY_END();
+}
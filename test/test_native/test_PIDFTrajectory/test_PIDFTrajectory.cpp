@@ -0,0 +1,149 @@
+#include <PIDF.h>
+#include <PIDFTrajectory.h>
+#include <cmath>
+#include <vector>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr float DELTA_T = 0.001F;
+static const PIDFTrajectory::limits_t limits { 2.0F, 4.0F, 40.0F };
+
+/*!
+Run a move to target and check that it stays within the limits, that the velocity and acceleration are consistent with the
+position, and that it ends at rest at the target. Returns the number of samples in the move.
+*/
+static size_t checkMove(PIDFTrajectory& trajectory, float target)
+{
+    const float tolerance = 1.0e-4F;
+    PIDFTrajectory::point_t previous = trajectory.getPoint();
+    trajectory.setTarget(target);
+    size_t count = 0;
+    while (!trajectory.isFinished()) {
+        const PIDFTrajectory::point_t point = trajectory.update();
+        ++count;
+        TEST_ASSERT_TRUE(std::fabs(point.velocity) <= limits.velocity + tolerance);
+        TEST_ASSERT_TRUE(std::fabs(point.acceleration) <= limits.acceleration + tolerance);
+        TEST_ASSERT_TRUE(std::fabs(point.acceleration - previous.acceleration) <= limits.jerk*DELTA_T + tolerance);
+        // the velocity and acceleration are the derivatives of the position and velocity (trapezoidal rule, which is
+        // inexact by up to jerk*deltaT^2 in a sample in which the jerk changes), positions are up to 11, so have a resolution of 1e-6
+        TEST_ASSERT_FLOAT_WITHIN(4.0e-6F, 0.5F*(point.velocity + previous.velocity)*DELTA_T, point.position - previous.position);
+        TEST_ASSERT_FLOAT_WITHIN(limits.jerk*DELTA_T*DELTA_T, 0.5F*(point.acceleration + previous.acceleration)*DELTA_T, point.velocity - previous.velocity);
+        previous = point;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(target, previous.position);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, previous.velocity);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, previous.acceleration);
+    return count;
+}
+
+void test_long_move()
+{
+    PIDFTrajectory trajectory(limits, DELTA_T);
+    trajectory.reset(1.0F);
+    TEST_ASSERT_TRUE(trajectory.isFinished());
+    // jerk time 0.1, acceleration phase 0.6, cruise (10 - 2*0.6)/2 = 4.4
+    trajectory.setTarget(11.0F);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 5.6F, trajectory.getDuration());
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 0.1F, trajectory.getSegments()[1].startTime);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 0.6F, trajectory.getSegments()[3].startTime);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 2.0F, trajectory.getSegments()[3].start.velocity);
+    trajectory.reset(1.0F);
+    const size_t count = checkMove(trajectory, 11.0F);
+    TEST_ASSERT_EQUAL(5600, count);
+    // and back
+    checkMove(trajectory, 1.0F);
+}
+
+void test_short_moves()
+{
+    PIDFTrajectory trajectory(limits, DELTA_T);
+    trajectory.reset(0.0F);
+    // maximum velocity not reached, maximum acceleration reached
+    checkMove(trajectory, 0.5F);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-6F, 0.0F, trajectory.getSegments()[3].startTime - trajectory.getSegments()[4].startTime);
+    // neither reached, the jerk time is cbrt(d/(2*jerk))
+    trajectory.reset(0.0F);
+    trajectory.setTarget(-0.01F);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 4.0F*std::cbrt(0.01F/80.0F), trajectory.getDuration());
+    trajectory.reset(0.0F);
+    checkMove(trajectory, -0.01F);
+    // a move of less than a sample
+    checkMove(trajectory, -0.01F + 1.0e-7F);
+    // zero length
+    trajectory.setTarget(trajectory.getPoint().position);
+    TEST_ASSERT_TRUE(trajectory.isFinished());
+    // maximum velocity reached without reaching the maximum acceleration
+    PIDFTrajectory lowVelocity({ 0.2F, 4.0F, 40.0F }, DELTA_T);
+    lowVelocity.reset(0.0F);
+    lowVelocity.setTarget(1.0F);
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 0.2F, lowVelocity.getSegments()[3].start.velocity);
+    // acceleration phase 2*sqrt(velocity/jerk), plus distance/velocity
+    TEST_ASSERT_FLOAT_WITHIN(1.0e-5F, 2.0F*std::sqrt(0.2F/40.0F) + 1.0F/0.2F, lowVelocity.getDuration());
+}
+
+void test_pending_target()
+{
+    PIDFTrajectory trajectory(limits, DELTA_T);
+    trajectory.reset(0.0F);
+    trajectory.setTarget(1.0F);
+    for (int ii = 0; ii < 100; ++ii) {
+        trajectory.update();
+    }
+    trajectory.setTarget(-1.0F);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0F, trajectory.getTarget());
+    TEST_ASSERT_FALSE(trajectory.isFinished());
+    float maximum = 0.0F;
+    while (!trajectory.isFinished()) {
+        maximum = std::fmax(maximum, trajectory.update().position);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, maximum);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0F, trajectory.getPoint().position);
+}
+
+void test_plan_and_apply()
+{
+    PIDFTrajectory trajectory(limits, DELTA_T);
+    std::vector<PIDFTrajectory::point_t> points(2000);
+    const size_t count = trajectory.plan(0.0F, 1.5F, &points[0], points.size());
+    TEST_ASSERT_TRUE(count < points.size());
+    TEST_ASSERT_EQUAL(count, trajectory.plan(0.0F, 1.5F, nullptr, 0));
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, points[count - 1].position);
+
+    // the planned points are the same as the points from update, and update sets the setpoint and K-term of the controller
+    PIDF pid({ 1.0F, 0.0F, 0.0F, 0.0F, 0.5F });
+    trajectory.reset(0.0F);
+    trajectory.setTarget(1.5F);
+    for (size_t ii = 0; ii < count; ++ii) {
+        const PIDFTrajectory::point_t& point = trajectory.update(pid);
+        TEST_ASSERT_EQUAL_FLOAT(points[ii].position, point.position);
+        TEST_ASSERT_EQUAL_FLOAT(points[ii].velocity, point.velocity);
+        TEST_ASSERT_EQUAL_FLOAT(point.position, pid.getSetpoint());
+        TEST_ASSERT_EQUAL_FLOAT(0.5F*point.velocity, pid.getErrorK());
+    }
+    TEST_ASSERT_TRUE(trajectory.isFinished());
+    PIDFTrajectory::apply(pid, points[10]);
+    TEST_ASSERT_EQUAL_FLOAT(points[10].position, pid.getSetpoint());
+    // a controller without a K-term only has its setpoint set
+    PIDFT<PIDFTerms::PI> pidPI;
+    PIDFTrajectory::apply(pidPI, points[10]);
+    TEST_ASSERT_EQUAL_FLOAT(points[10].position, pidPI.getSetpoint());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_long_move);
+    RUN_TEST(test_short_moves);
+    RUN_TEST(test_pending_target);
+    RUN_TEST(test_plan_and_apply);
+
+    UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include <PIDFVec.h>
+#include <array>
+#include <unity.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+using PIDF_BC = PIDFT<PIDFTerms::ALL | PIDFTerms::BACK_CALCULATION>;
+
+static uint32_t seed = 12345;
+static float randomFloat(float range)
+{
+    // simple linear congruential generator, so tests are repeatable
+    seed = seed*1664525U + 1013904223U;
+    return range*(static_cast<float>(seed >> 8U)/8388608.0F - 1.0F);
+}
+
+template <size_t N>
+static void configure(PIDFVec<N>& vec, std::array<PIDF_BC, N>& pids, float deltaT)
+{
+    vec.setSampleTime(deltaT);
+    for (size_t ii = 0; ii < N; ++ii) {
+        const PIDF::PIDF_t gains { 0.5F + 0.1F*static_cast<float>(ii), 0.3F, 0.01F*static_cast<float>(ii), 0.1F, (ii & 1U) ? 0.02F : 0.0F };
+        vec.setPID(ii, gains);
+        pids[ii].setPID(gains);
+        pids[ii].setSampleTime(deltaT);
+        // each axis has different limits
+        if (ii == 0) {
+            vec.setIntegralLimit(ii, 0.4F);
+            pids[ii].setIntegralLimit(0.4F);
+        }
+        if (ii == 1) {
+            vec.setIntegralThreshold(ii, 0.2F);
+            pids[ii].setIntegralThreshold(0.2F);
+        }
+        if (ii >= 2) {
+            vec.setOutputSaturationValue(ii, 1.0F);
+            pids[ii].setOutputSaturationValue(1.0F);
+        }
+        if (ii == 3) {
+            vec.setTrackingGain(ii, 20.0F);
+            pids[ii].setTrackingGain(20.0F);
+        }
+    }
+}
+
+template <size_t N, bool FIXED_RATE>
+static void compareWithPIDF()
+{
+    const float deltaT = 0.005F;
+    PIDFVec<N> vec;
+    std::array<PIDF_BC, N> pids;
+    configure(vec, pids, deltaT);
+
+    std::array<float, N> measurements {};
+    for (size_t step = 0; step < 500; ++step) {
+        if (step % 50 == 0) {
+            std::array<float, N> setpoints {};
+            for (size_t ii = 0; ii < N; ++ii) {
+                const float setpoint = randomFloat(3.0F);
+                setpoints[ii] = setpoint;
+                vec.setSetpoint(ii, setpoint);
+                vec.setSetpointDerivative(ii, setpoint*0.1F);
+                pids[ii].setSetpoint(setpoint);
+                pids[ii].setSetpointDerivative(setpoint*0.1F);
+            }
+            if (FIXED_RATE) {
+                vec.setSetpoints(setpoints);
+            }
+        }
+        for (size_t ii = 0; ii < N; ++ii) {
+            measurements[ii] += randomFloat(0.2F);
+        }
+        const std::array<float, N> outputs = FIXED_RATE ? vec.update(measurements) : vec.update(measurements, deltaT);
+        for (size_t ii = 0; ii < N; ++ii) {
+            // the variable-rate update also uses the reciprocal of deltaT, so is the same as the PIDF fixed-rate update
+            const float output = pids[ii].update(measurements[ii]);
+            // allow a few ULP difference, in case the compiler has used fused multiply-adds differently in scalar and SIMD code
+            TEST_ASSERT_FLOAT_WITHIN(1e-5F, output, outputs[ii]);
+            const PIDF::error_t error = pids[ii].getError();
+            const PIDF::error_t vecError = vec.getError(ii);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5F, error.P, vecError.P);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5F, error.I, vecError.I);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5F, error.D, vecError.D);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5F, error.S, vecError.S);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5F, error.K, vecError.K);
+            TEST_ASSERT_EQUAL_FLOAT(pids[ii].getPreviousMeasurement(), vec.getPreviousMeasurement(ii));
+        }
+    }
+}
+
+void test_PIDFVec_init()
+{
+    const PIDFVec3 vec;
+    TEST_ASSERT_EQUAL(3, vec.size());
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(&vec) % PIDFVec3::ALIGNMENT); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, vec.getPID(2).kp);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, vec.getSetpoint(2));
+}
+
+void test_PIDFVec_PI()
+{
+    PIDFVec3 vec;
+    vec.setPID(0, PIDF::PIDF_t { 0.3F, 0.2F, 0.0F, 0.0F, 0.0F });
+    vec.setPID(2, PIDF::PIDF_t { 1.0F, 0.0F, 0.0F, 0.0F, 0.0F });
+    vec.setSetpoint(0, 5.0F);
+    vec.setSetpoint(2, -1.0F);
+
+    const std::array<float, 3> outputs = vec.updateDelta({ 1.0F, 0.0F, 0.0F }, { 1.0F, 0.0F, 0.0F }, 1.0F);
+    TEST_ASSERT_EQUAL_FLOAT(2.0F, outputs[0]); // 0.3*4 + 0.2*4
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, outputs[1]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0F, outputs[2]);
+    TEST_ASSERT_EQUAL_FLOAT(0.8F, vec.getErrorI(0));
+    TEST_ASSERT_EQUAL_FLOAT(4.0F, vec.getPreviousError(0));
+    TEST_ASSERT_EQUAL_FLOAT(-1.0F, vec.getError(2).P);
+
+    vec.resetAll();
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, vec.getErrorI(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, vec.getSetpoint(0));
+}
+
+void test_PIDFVec_matches_PIDF()
+{
+    compareWithPIDF<3, false>();
+    compareWithPIDF<3, true>();
+    compareWithPIDF<4, false>();
+    compareWithPIDF<4, true>();
+    compareWithPIDF<1, true>();
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_PIDFVec_init);
+    RUN_TEST(test_PIDFVec_PI);
+    RUN_TEST(test_PIDFVec_matches_PIDF);
+
+    UNITY_END();
+}
@@ -0,0 +1,87 @@
+/*!
+Host tool to convert a PIDFRecorder dump into CSV.
+
+Usage: pidf_decode <dump file> [<csv file>]
+
+The dump is the recorder header followed by the records, as drained from the recorder. The CSV is written to stdout if
+no output file is given. The first column is the record sequence number, followed by a column for each recorded field.
+A comment line is written where records were dropped.
+*/
+#include <PIDFRecorder.h>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+//! Closes the file when the owning pointer goes out of scope, so it is closed on every return path. stdout is not closed.
+struct file_closer_t {
+    void operator()(FILE* file) const {
+        if (file != stdout) {
+            std::fclose(file); // NOLINT(cppcoreguidelines-owning-memory)
+        }
+    }
+};
+using file_ptr_t = std::unique_ptr<FILE, file_closer_t>;
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3) {
+        std::fprintf(stderr, "Usage: %s <dump file> [<csv file>]\n", argv[0]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return 1;
+    }
+    const file_ptr_t inFile(std::fopen(argv[1], "rb")); // NOLINT(cppcoreguidelines-owning-memory,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    FILE* in = inFile.get();
+    if (in == nullptr) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return 1;
+    }
+    const file_ptr_t outFile((argc == 3) ? std::fopen(argv[2], "w") : stdout); // NOLINT(cppcoreguidelines-owning-memory,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    FILE* out = outFile.get();
+    if (out == nullptr) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[2]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return 1;
+    }
+
+    PIDFRecorder::header_t header {};
+    if (std::fread(&header, sizeof(header), 1, in) != 1) {
+        std::fprintf(stderr, "Dump too short\n");
+        return 1;
+    }
+    PIDFRecordDecoder decoder(header);
+    if (!decoder.isValid()) {
+        std::fprintf(stderr, "Not a PIDF recorder dump, or unsupported version\n");
+        return 1;
+    }
+
+    static constexpr std::array<const char*, PIDFRecordFields::FIELD_COUNT> names {
+        "setpoint", "measurement", "P", "I", "D", "S", "K", "output"
+    };
+    std::fprintf(out, "sequence");
+    for (size_t ii = 0; ii < PIDFRecordFields::FIELD_COUNT; ++ii) {
+        if (header.config.fields & (1U << ii)) {
+            std::fprintf(out, ",%s", names[ii]);
+        }
+    }
+    std::fprintf(out, "\n");
+
+    std::vector<uint8_t> record(decoder.getRecordSize());
+    size_t recordCount = 0;
+    size_t droppedCount = 0;
+    while (std::fread(&record[0], record.size(), 1, in) == 1) {
+        const PIDFRecordDecoder::record_t decoded = decoder.decode(&record[0]);
+        if (decoded.dropped != 0) {
+            std::fprintf(out, "# %u records dropped\n", static_cast<unsigned>(decoded.dropped));
+            droppedCount += decoded.dropped;
+        }
+        std::fprintf(out, "%u", static_cast<unsigned>(decoded.sequence));
+        for (size_t ii = 0; ii < PIDFRecordFields::FIELD_COUNT; ++ii) {
+            if (header.config.fields & (1U << ii)) {
+                std::fprintf(out, ",%.9g", static_cast<double>(decoded.values[ii]));
+            }
+        }
+        std::fprintf(out, "\n");
+        ++recordCount;
+    }
+    std::fprintf(stderr, "%zu records decoded, %zu dropped\n", recordCount, droppedCount);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*!
+Host tool to find PIDF gains for a simulated plant, using every core.
+
+Usage: pidf_optimize [<candidate count> [<thread count>]]
+
+Searches kp, ki, kd, kk, and the output saturation value for a first order plus dead time plant, over a setpoint step,
+a setpoint ramp, and a load disturbance. The cost is ITAE plus a control effort penalty. Candidates whose sensitivity peak
+(calculated from the frequency response, which is much cheaper than the simulation) exceeds MAX_SENSITIVITY_PEAK are
+rejected without being simulated. A random search is refined by Nelder-Mead searches started from its best candidates,
+and the best results are printed ranked by cost, followed by the margins of the best candidate.
+Edit the plant, scenarios, and search space below to suit.
+*/
+#include <PIDFFrequencyResponse.h>
+#include <PIDFOptimizer.h>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+    // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const size_t candidateCount = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    const size_t threadCount = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+    static constexpr float DELTA_T = 1.0F / 1000.0F;
+    const PIDFPlantFOPDT<50> plant(2.0F, 0.5F, DELTA_T); // 50ms dead time
+    const std::array<PIDFSimulation::scenario_t, 3> scenarios {{
+        // deltaT, duration, step, ramp, disturbance time, disturbance, output limit, settling band
+        { DELTA_T, 5.0F, 1.0F, 0.0F, 100.0F, 0.0F, 2.0F, 0.02F },
+        { DELTA_T, 5.0F, 0.0F, 0.5F, 100.0F, 0.0F, 2.0F, 0.02F },
+        { DELTA_T, 5.0F, 0.0F, 0.0F, 0.5F, 0.5F, 2.0F, 0.02F },
+    }};
+    const PIDFSimulationCost<PIDFPlantFOPDT<50>, 3> simulationCost(plant, scenarios, 0.01F);
+    // the exact response of the simulated plant, as seen by the controller, gain*alpha*z^-51/(1 - (1 - alpha)*z^-1)
+    PIDFFrequencyResponse response(DELTA_T, 0.01F, 1.0e5F, 200);
+    response.setDiscretePlant([](std::complex<double> zInverse) {
+        constexpr double alpha = static_cast<double>(DELTA_T) / 0.5;
+        return 2.0*alpha*std::pow(zInverse, 51)/(1.0 - (1.0 - alpha)*zInverse);
+    });
+    static constexpr float MAX_SENSITIVITY_PEAK = 1.6F;
+    auto cost = [&response, &simulationCost](const PIDFOptimizer::candidate_t& candidate) {
+        return (response.analyze(candidate.pid).sensitivityPeak > MAX_SENSITIVITY_PEAK) ? FLT_MAX : simulationCost(candidate);
+    };
+    const PIDFOptimizer::candidate_t minimum { { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F }, 0.0F, 0.5F };
+    const PIDFOptimizer::candidate_t maximum { { 5.0F, 50.0F, 0.5F, 0.0F, 0.5F }, 0.0F, 2.0F };
+    // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    PIDFOptimizer optimizer(threadCount);
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<PIDFOptimizer::result_t> random = optimizer.random(minimum, maximum, candidateCount, 1, cost);
+    const auto randomEnd = std::chrono::steady_clock::now();
+    enum { REFINE_COUNT = 16, REFINE_EVALUATIONS = 300 };
+    std::vector<PIDFOptimizer::candidate_t> starts;
+    for (size_t ii = 0; ii < std::min(static_cast<size_t>(REFINE_COUNT), random.size()); ++ii) {
+        starts.push_back(random[ii].candidate);
+    }
+    const std::vector<PIDFOptimizer::result_t> refined = optimizer.nelderMead(minimum, maximum, starts, REFINE_EVALUATIONS, cost);
+    const auto end = std::chrono::steady_clock::now();
+
+    const double randomSeconds = std::chrono::duration<double>(randomEnd - start).count();
+    std::printf("%zu threads, random search of %zu candidates in %.2fs (%.0f candidates/s), refined in %.2fs\n\n",
+        optimizer.getThreadCount(), candidateCount, randomSeconds, static_cast<double>(candidateCount) / randomSeconds,
+        std::chrono::duration<double>(end - randomEnd).count());
+    std::printf("Random search:\n");
+    PIDFOptimizer::report(stdout, random, 5);
+    std::printf("\nNelder-Mead refinement:\n");
+    PIDFOptimizer::report(stdout, refined, 5);
+    const PIDFFrequencyResponse::margins_t margins = response.analyze(refined[0].candidate.pid);
+    std::printf("\nBest candidate: gain margin %.2f at %.1frad/s, phase margin %.1fdeg at %.1frad/s, sensitivity peak %.2f, bandwidth %.1frad/s\n",
+        static_cast<double>(margins.gainMargin), static_cast<double>(margins.gainMarginFrequency),
+        static_cast<double>(margins.phaseMargin), static_cast<double>(margins.gainCrossoverFrequency),
+        static_cast<double>(margins.sensitivityPeak), static_cast<double>(margins.bandwidth));
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*!
+Host tool to replay a PIDFRecorder dump through PIDF with one or more sets of gains.
+
+Usage: pidf_replay <dump file> <deltaT> <output prefix> <kp,ki,kd,ks,kk[,output saturation]> [<kp,ki,kd,ks,kk[,output saturation]> ...]
+
+The dump must contain the setpoint and measurement. It is memory-mapped and replayed in blocks, with every gain set
+replayed in the same pass. For each gain set N, a recorder dump of the setpoint, measurement, P, I, D, S, and K contributions,
+and output of every update is written to <output prefix>N.bin, which can be converted to CSV with pidf_decode.
+*/
+#include <PIDF.h>
+#include <PIDFReplay.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+//! Closes the file when the owning pointer goes out of scope, so it is closed on every return path.
+struct file_closer_t {
+    void operator()(FILE* file) const { std::fclose(file); } // NOLINT(cppcoreguidelines-owning-memory)
+};
+using file_ptr_t = std::unique_ptr<FILE, file_closer_t>;
+
+int main(int argc, char** argv)
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (argc < 5) {
+        std::fprintf(stderr, "Usage: %s <dump file> <deltaT> <output prefix> <kp,ki,kd,ks,kk[,output saturation]> ...\n", argv[0]);
+        return 1;
+    }
+    PIDFMappedFile file;
+    if (!file.open(argv[1])) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    const PIDFReplay replay(file.data(), file.size());
+    if (!replay.isValid()) {
+        std::fprintf(stderr, "Not a PIDF recorder dump with the setpoint and measurement, or unsupported version\n");
+        return 1;
+    }
+    const float deltaT = std::strtof(argv[2], nullptr);
+
+    std::vector<PIDF> pids;
+    for (int ii = 4; ii < argc; ++ii) {
+        std::array<float, 6> values {};
+        size_t count = 0;
+        const char* s = argv[ii];
+        for (; count < values.size() && *s != '\0'; ++count) {
+            char* end = nullptr;
+            values[count] = std::strtof(s, &end);
+            s = (*end == ',') ? end + 1 : end;
+        }
+        if (count < 5) {
+            std::fprintf(stderr, "Gain set %s must be kp,ki,kd,ks,kk[,output saturation]\n", argv[ii]);
+            return 1;
+        }
+        pids.emplace_back(PIDF::PIDF_t { values[0], values[1], values[2], values[3], values[4] });
+        pids.back().setOutputSaturationValue(values[5]);
+    }
+
+    // each result is written to its own dump, using a recorder that is drained after every block
+    const PIDFRecorder::config_t config { PIDFRecordFields::ALL, {}, {} };
+    const size_t recordSize = PIDFRecorder::recordSize(config);
+    std::vector<std::vector<uint8_t>> buffers(pids.size(), std::vector<uint8_t>(PIDFReplay::BLOCK_SIZE*recordSize));
+    std::deque<PIDFRecorder> recorders; // recorders cannot be moved, so are not stored in a vector
+    std::vector<file_ptr_t> outputs;
+    for (size_t ii = 0; ii < pids.size(); ++ii) {
+        recorders.emplace_back(&buffers[ii][0], buffers[ii].size(), config);
+        const std::string path = std::string(argv[3]) + std::to_string(ii) + ".bin";
+        file_ptr_t out(std::fopen(path.c_str(), "wb")); // NOLINT(cppcoreguidelines-owning-memory)
+        if (out == nullptr) {
+            std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+            return 1;
+        }
+        std::fwrite(&recorders[ii].getHeader(), sizeof(PIDFRecorder::header_t), 1, out.get());
+        outputs.push_back(std::move(out));
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    const auto start = std::chrono::steady_clock::now();
+    const PIDFReplay::stats_t stats = replay.run(&pids[0], pids.size(), deltaT,
+        [&recorders, &outputs](size_t pidIndex, size_t, const PIDFRecorder::values_t* values, size_t count) {
+            PIDFRecorder& recorder = recorders[pidIndex];
+            for (size_t ii = 0; ii < count; ++ii) {
+                recorder.record(values[ii]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            }
+            const uint8_t* data = nullptr;
+            while (const size_t size = recorder.peek(data)) {
+                std::fwrite(data, 1, size, outputs[pidIndex].get());
+                recorder.consume(size);
+            }
+        });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    outputs.clear(); // close the outputs, so they are complete when the summary is printed
+    std::fprintf(stderr, "%zu records (%zu dropped in the log) replayed with %zu gain sets in %.3fs (%.0f updates/s)\n",
+        stats.recordCount, stats.droppedCount, pids.size(), seconds,
+        static_cast<double>(stats.recordCount*pids.size()) / seconds);
+    return 0;
+}